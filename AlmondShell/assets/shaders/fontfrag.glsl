@@ -1,12 +1,19 @@
 #version 330 core
 in vec2 TexCoords;
+in vec4 TextColor;
 
 out vec4 FragColor;
 
 uniform sampler2D text;
-uniform vec3 textColor;
+uniform bool isSDF;     // Atlas holds signed distance fields instead of coverage
 
 void main() {
-    vec4 sampled = texture(text, TexCoords);
-    FragColor = vec4(textColor, 1.0) * sampled;
+    // Glyph coverage (or distance, edge at 0.5) lives in the red channel of the atlas
+    float sampled = texture(text, TexCoords).r;
+    float coverage = sampled;
+    if (isSDF) {
+        float width = max(fwidth(sampled) * 0.5, 1e-4);
+        coverage = smoothstep(0.5 - width, 0.5 + width, sampled);
+    }
+    FragColor = vec4(TextColor.rgb, TextColor.a * coverage);
 }
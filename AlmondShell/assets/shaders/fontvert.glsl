@@ -1,11 +1,14 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 2) in vec4 color;  // Per-glyph RGBA so differently coloured labels share a batch
 
 out vec2 TexCoords;
+out vec4 TextColor;
 
 uniform mat4 projection;
 
 void main() {
     gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
+    TextColor = color;
 }
@@ -0,0 +1,24 @@
+#version 460 core
+
+in vec2 TexCoords;          // Position across the grid from the vertex shader
+out vec4 FragColor;         // Final color output
+
+uniform usampler2D cells;   // One cell value per texel, or 32 cells per texel when packedBits is set
+uniform sampler2D palette;  // 256x1 colors indexed by cell value
+uniform ivec2 gridSize;     // Cells across and down
+uniform bool packedBits;    // Cells are single bits, lowest bit first
+
+void main()
+{
+    ivec2 cell = min(ivec2(TexCoords * vec2(gridSize)), gridSize - 1);
+
+    uint value;
+    if (packedBits) {
+        uint word = texelFetch(cells, ivec2(cell.x >> 5, cell.y), 0).r;
+        value = (word >> uint(cell.x & 31)) & 1u;
+    } else {
+        value = texelFetch(cells, cell, 0).r;
+    }
+
+    FragColor = texelFetch(palette, ivec2(int(value), 0), 0);
+}
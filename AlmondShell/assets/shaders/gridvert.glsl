@@ -0,0 +1,11 @@
+#version 460 core
+
+out vec2 TexCoords;  // Position across the grid, 0..1, with row 0 at the top
+
+void main()
+{
+    // One triangle that covers the whole screen, generated from the vertex index (no vertex buffer)
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+    TexCoords = vec2(corner.x, 1.0 - corner.y);
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace almond::bench {
+
+    // Keeps the compiler from discarding a value whose only purpose is to be computed
+    template <typename T>
+    inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    struct Options {
+        std::uint64_t seed = 1;
+        int samples = 10;              // Timed samples per benchmark; the median is reported
+        double minSampleMs = 20.0;     // Calls are batched until one sample takes at least this long
+        double warmupMs = 50.0;
+    };
+
+    struct Result {
+        std::string name;
+        std::uint64_t iterations = 0;  // Calls timed across all samples
+        double minNs = 0, medianNs = 0, meanNs = 0, maxNs = 0, stddevNs = 0; // Per call
+        double itemsPerCall = 1;
+
+        double ItemsPerSecond() const { return medianNs > 0 ? itemsPerCall * 1e9 / medianNs : 0; }
+    };
+
+    // Handed to each benchmark body. The body builds its inputs from Seed(), then calls Measure()
+    // once with the operation to time; nothing outside Measure() is timed.
+    class Run {
+    public:
+        Run(std::string name, const Options& options)
+            : options(options) {
+            result.name = std::move(name);
+        }
+
+        std::uint64_t Seed() const { return options.seed; }
+
+        // itemsPerCall turns the per-call time into a throughput (jobs, steps, events, ...)
+        template <typename Fn>
+        void Measure(Fn&& fn, double itemsPerCall = 1.0) {
+            using Clock = std::chrono::steady_clock;
+            auto elapsedNs = [](Clock::time_point start) {
+                return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            };
+
+            // Warm caches and estimate the cost of one call
+            std::uint64_t warmupCalls = 0;
+            const auto warmupStart = Clock::now();
+            do {
+                fn();
+                ++warmupCalls;
+            } while (elapsedNs(warmupStart) < options.warmupMs * 1e6);
+            const double estimateNs = elapsedNs(warmupStart) / static_cast<double>(warmupCalls);
+            const auto batch = static_cast<std::uint64_t>(std::max(1.0, std::ceil(options.minSampleMs * 1e6 / std::max(estimateNs, 1.0))));
+
+            std::vector<double> perCall;
+            for (int sample = 0; sample < std::max(1, options.samples); ++sample) {
+                const auto start = Clock::now();
+                for (std::uint64_t i = 0; i < batch; ++i) fn();
+                perCall.push_back(elapsedNs(start) / static_cast<double>(batch));
+            }
+
+            std::sort(perCall.begin(), perCall.end());
+            const size_t n = perCall.size();
+            double sum = 0;
+            for (double ns : perCall) sum += ns;
+            const double mean = sum / static_cast<double>(n);
+            double variance = 0;
+            for (double ns : perCall) variance += (ns - mean) * (ns - mean);
+
+            result.iterations = batch * n;
+            result.minNs = perCall.front();
+            result.maxNs = perCall.back();
+            result.medianNs = n % 2 ? perCall[n / 2] : (perCall[n / 2 - 1] + perCall[n / 2]) / 2;
+            result.meanNs = mean;
+            result.stddevNs = std::sqrt(variance / static_cast<double>(n));
+            result.itemsPerCall = itemsPerCall;
+            measured = true;
+        }
+
+        bool WasMeasured() const { return measured; }
+        const Result& GetResult() const { return result; }
+
+    private:
+        const Options& options;
+        Result result;
+        bool measured = false;
+    };
+
+    struct Benchmark {
+        std::string name;
+        std::function<void(Run&)> body;
+    };
+
+    class Registry {
+    public:
+        void Add(std::string name, std::function<void(Run&)> body) {
+            benchmarks.push_back({ std::move(name), std::move(body) });
+        }
+
+        const std::vector<Benchmark>& GetBenchmarks() const { return benchmarks; }
+
+    private:
+        std::vector<Benchmark> benchmarks;
+    };
+
+    inline std::string FormatNs(double ns) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(ns < 10.0 ? 2 : 1);
+        if (ns >= 1e9) out << ns / 1e9 << " s";
+        else if (ns >= 1e6) out << ns / 1e6 << " ms";
+        else if (ns >= 1e3) out << ns / 1e3 << " us";
+        else out << ns << " ns";
+        return out.str();
+    }
+
+    inline std::string EscapeJson(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    inline void WriteJson(std::ostream& out, const Options& options, const std::vector<Result>& results) {
+        out << std::setprecision(6) << std::fixed;
+        out << "{\n  \"context\": {\n";
+        out << "    \"seed\": " << options.seed << ",\n";
+        out << "    \"samples\": " << options.samples << ",\n";
+        out << "    \"min_sample_ms\": " << options.minSampleMs << ",\n";
+#ifdef NDEBUG
+        out << "    \"build\": \"release\"\n";
+#else
+        out << "    \"build\": \"debug\"\n";
+#endif
+        out << "  },\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << "    { \"name\": \"" << EscapeJson(r.name) << "\", \"iterations\": " << r.iterations
+                << ", \"min_ns\": " << r.minNs << ", \"median_ns\": " << r.medianNs
+                << ", \"mean_ns\": " << r.meanNs << ", \"max_ns\": " << r.maxNs
+                << ", \"stddev_ns\": " << r.stddevNs << ", \"items_per_second\": " << r.ItemsPerSecond() << " }"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+
+    // Reads name -> median_ns back from a file written by WriteJson. Only that layout is understood,
+    // which is all a stored baseline ever is.
+    inline std::map<std::string, double> ReadBaseline(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            throw std::runtime_error("Could not open baseline: " + path);
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        const std::string text = buffer.str();
+
+        std::map<std::string, double> medians;
+        const std::string nameKey = "\"name\": \"", medianKey = "\"median_ns\": ";
+        for (size_t pos = text.find(nameKey); pos != std::string::npos; pos = text.find(nameKey, pos)) {
+            pos += nameKey.size();
+            std::string name;
+            for (; pos < text.size() && text[pos] != '"'; ++pos) {
+                if (text[pos] == '\\' && pos + 1 < text.size()) ++pos;
+                name += text[pos];
+            }
+
+            const size_t median = text.find(medianKey, pos);
+            const size_t nextName = text.find(nameKey, pos);
+            if (median == std::string::npos || (nextName != std::string::npos && median > nextName)) continue;
+            medians[name] = std::strtod(text.c_str() + median + medianKey.size(), nullptr);
+        }
+        return medians;
+    }
+
+    // Prints each result against the baseline. Returns how many got slower by more than
+    // thresholdPercent.
+    inline int CompareWithBaseline(const std::map<std::string, double>& baseline, const std::vector<Result>& results,
+        double thresholdPercent, std::ostream& out) {
+        int regressions = 0;
+        out << "\nComparison with baseline (threshold " << thresholdPercent << "%):\n";
+        for (const Result& r : results) {
+            auto it = baseline.find(r.name);
+            out << "  " << std::left << std::setw(48) << r.name << std::right;
+            if (it == baseline.end() || it->second <= 0) {
+                out << "  (not in baseline)\n";
+                continue;
+            }
+
+            const double change = (r.medianNs - it->second) / it->second * 100.0;
+            out << std::setw(12) << FormatNs(it->second) << " -> " << std::setw(12) << FormatNs(r.medianNs)
+                << "  " << std::showpos << std::fixed << std::setprecision(1) << change << "%" << std::noshowpos;
+            if (change > thresholdPercent) {
+                out << "  REGRESSION";
+                ++regressions;
+            }
+            out << "\n";
+        }
+        return regressions;
+    }
+
+} // namespace almond::bench
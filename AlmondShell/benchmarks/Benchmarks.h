@@ -0,0 +1,36 @@
+#pragma once
+
+#include "BenchmarkHarness.h"
+
+#include <cstdint>
+
+namespace almond::bench {
+
+    // Sand, Game of Life (dense and sparse)
+    void RegisterSimulationBenchmarks(Registry& registry);
+
+    // WaitFreeQueue, ThreadPool, ComponentManager, SaveSystem, atlas packers, Logger
+    void RegisterCoreBenchmarks(Registry& registry);
+
+    // Seeded source for benchmark inputs, so a given --seed always produces the same work
+    class Random {
+    public:
+        explicit Random(std::uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+        std::uint64_t Next() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        // In [low, high]
+        int Range(int low, int high) {
+            return low + static_cast<int>(Next() % static_cast<std::uint64_t>(high - low + 1));
+        }
+
+    private:
+        std::uint64_t state;
+    };
+
+} // namespace almond::bench
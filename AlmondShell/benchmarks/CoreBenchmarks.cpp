@@ -0,0 +1,208 @@
+#include "Benchmarks.h"
+
+#include "alsComponentManager.h"
+#include "alsLoadSave.h"
+#include "alsLogger.h"
+#include "alsRobustTime.h"
+#include "alsTextureAtlasPacker.h"
+#include "alsThreadPool.h"
+#include "alsWaitFreeQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace almond::bench {
+
+    namespace {
+
+        struct Position { float x, y, z; };
+        struct Velocity { float x, y, z; };
+
+        std::filesystem::path TempFile(const std::string& name) {
+            return std::filesystem::temp_directory_path() / ("almond_bench_" + name);
+        }
+
+        void RegisterQueueBenchmarks(Registry& registry) {
+            registry.Add("WaitFreeQueue/enqueue_dequeue_x1024", [](Run& run) {
+                constexpr int kItems = 1024;
+                WaitFreeQueue<int> queue(kItems);
+                run.Measure([&] {
+                    for (int i = 0; i < kItems; ++i) queue.enqueue(i);
+                    int value = 0, sum = 0;
+                    while (queue.dequeue(value)) sum += value;
+                    DoNotOptimize(sum);
+                }, kItems);
+            });
+
+            // Two producers and two consumers pushing items through a small queue, so the slots are
+            // contended; includes starting the four threads
+            registry.Add("WaitFreeQueue/mpmc_2x2_x65536", [](Run& run) {
+                constexpr int kItemsPerProducer = 32768;
+                WaitFreeQueue<int> queue(256);
+                run.Measure([&] {
+                    std::atomic<int> consumed{ 0 };
+                    std::vector<std::thread> threads;
+                    for (int p = 0; p < 2; ++p) {
+                        threads.emplace_back([&] {
+                            for (int i = 0; i < kItemsPerProducer; ++i) {
+                                while (!queue.enqueue(i)) std::this_thread::yield();
+                            }
+                        });
+                    }
+                    for (int c = 0; c < 2; ++c) {
+                        threads.emplace_back([&] {
+                            int value = 0;
+                            while (consumed.load(std::memory_order_relaxed) < kItemsPerProducer * 2) {
+                                if (queue.dequeue(value)) consumed.fetch_add(1, std::memory_order_relaxed);
+                                else std::this_thread::yield();
+                            }
+                        });
+                    }
+                    for (auto& thread : threads) thread.join();
+                }, kItemsPerProducer * 2);
+            });
+        }
+
+        void RegisterThreadPoolBenchmarks(Registry& registry) {
+            registry.Add("ThreadPool/enqueue_x4096", [](Run& run) {
+                constexpr int kJobs = 4096;
+                ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+                std::atomic<int> done{ 0 };
+                run.Measure([&] {
+                    done.store(0, std::memory_order_relaxed);
+                    for (int i = 0; i < kJobs; ++i) {
+                        pool.enqueue([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                    }
+                    while (done.load(std::memory_order_acquire) < kJobs) std::this_thread::yield();
+                }, kJobs);
+            });
+
+            registry.Add("ThreadPool/parallelFor_x4096", [](Run& run) {
+                constexpr size_t kIndices = 4096;
+                ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+                std::vector<std::uint64_t> values(kIndices);
+                run.Measure([&] {
+                    pool.parallelFor(kIndices, [&values](size_t i) { values[i] = values[i] * 31 + i; });
+                    DoNotOptimize(values.data());
+                }, kIndices);
+            });
+        }
+
+        void RegisterComponentBenchmarks(Registry& registry) {
+            constexpr int kEntities = 1024;
+
+            registry.Add("ComponentManager/add_x1024", [](Run& run) {
+                run.Measure([&] {
+                    ComponentManager manager;
+                    for (int e = 0; e < kEntities; ++e) {
+                        manager.addComponent(static_cast<EntityID>(e), Position{ 1.0f, 2.0f, 3.0f });
+                        manager.addComponent(static_cast<EntityID>(e), Velocity{ 0.0f, -1.0f, 0.0f });
+                    }
+                    DoNotOptimize(manager);
+                }, kEntities * 2);
+            });
+
+            registry.Add("ComponentManager/get_x1024", [](Run& run) {
+                ComponentManager manager;
+                Random random(run.Seed());
+                for (int e = 0; e < kEntities; ++e) {
+                    manager.addComponent(static_cast<EntityID>(e), Position{ static_cast<float>(random.Range(0, 100)), 0.0f, 0.0f });
+                    manager.addComponent(static_cast<EntityID>(e), Velocity{ 1.0f, 0.0f, 0.0f });
+                }
+                run.Measure([&] {
+                    float sum = 0.0f;
+                    for (int e = 0; e < kEntities; ++e) {
+                        sum += manager.getComponent<Position>(static_cast<EntityID>(e)).x
+                            + manager.getComponent<Velocity>(static_cast<EntityID>(e)).x;
+                    }
+                    DoNotOptimize(sum);
+                }, kEntities * 2);
+            });
+        }
+
+        void RegisterSaveBenchmarks(Registry& registry) {
+            registry.Add("SaveSystem/save_load_x1024", [](Run& run) {
+                constexpr int kEvents = 1024;
+                Random random(run.Seed());
+                std::vector<Event> events(kEvents);
+                for (auto& event : events) {
+                    event.type = static_cast<EventType>(random.Range(0, 3));
+                    event.x = static_cast<float>(random.Range(0, 1920));
+                    event.y = static_cast<float>(random.Range(0, 1080));
+                    event.key = random.Range(0, 255);
+                    event.text[0] = static_cast<char>('a' + random.Range(0, 25));
+                    event.data["action"] = "press";
+                }
+
+                const std::string path = TempFile("save.dat").string();
+                std::vector<Event> loaded;
+                run.Measure([&] {
+                    SaveSystem::SaveGame(path, events);
+                    loaded.clear();
+                    SaveSystem::LoadGame(path, loaded);
+                    DoNotOptimize(loaded.data());
+                }, kEvents);
+                std::filesystem::remove(path);
+            });
+        }
+
+        void RegisterAtlasBenchmarks(Registry& registry) {
+            constexpr int kRects = 512;
+
+            // Random sprite sizes into a 2048 page, reset between calls
+            registry.Add("AtlasAllocator/insert_x512", [](Run& run) {
+                Random random(run.Seed());
+                std::vector<std::pair<int, int>> sizes;
+                for (int i = 0; i < kRects; ++i) sizes.emplace_back(random.Range(4, 64), random.Range(4, 64));
+
+                AtlasAllocator allocator(2048, 2048);
+                run.Measure([&] {
+                    allocator.Reset();
+                    for (const auto& [width, height] : sizes) DoNotOptimize(allocator.Insert(width, height));
+                }, kRects);
+            });
+
+            registry.Add("SkylinePacker/insert_x512", [](Run& run) {
+                Random random(run.Seed());
+                std::vector<std::pair<int, int>> sizes;
+                for (int i = 0; i < kRects; ++i) sizes.emplace_back(random.Range(4, 64), random.Range(4, 64));
+
+                SkylinePacker packer(2048, 2048);
+                run.Measure([&] {
+                    packer.Reset();
+                    for (const auto& [width, height] : sizes) DoNotOptimize(packer.Insert(width, height));
+                }, kRects);
+            });
+        }
+
+        void RegisterLoggerBenchmarks(Registry& registry) {
+            registry.Add("Logger/log_x1024", [](Run& run) {
+                constexpr int kLines = 1024;
+                const std::string path = TempFile("log.txt").string();
+                {
+                    RobustTime timeSystem;
+                    Logger logger(path, timeSystem);
+                    run.Measure([&] {
+                        for (int i = 0; i < kLines; ++i) logger.log("Benchmark message", LogLevel::INFO);
+                    }, kLines);
+                }
+                std::filesystem::remove(path);
+            });
+        }
+
+    }
+
+    void RegisterCoreBenchmarks(Registry& registry) {
+        RegisterQueueBenchmarks(registry);
+        RegisterThreadPoolBenchmarks(registry);
+        RegisterComponentBenchmarks(registry);
+        RegisterSaveBenchmarks(registry);
+        RegisterAtlasBenchmarks(registry);
+        RegisterLoggerBenchmarks(registry);
+    }
+
+} // namespace almond::bench
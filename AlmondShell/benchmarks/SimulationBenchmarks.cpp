@@ -0,0 +1,75 @@
+// SandSimulation::update and CellularAutomaton::update are thin wrappers over these grids' step(),
+// so the grids are benchmarked directly and no window backend is needed.
+
+#include "Benchmarks.h"
+
+#include "alsLifeGrid.h"
+#include "alsSandGrid.h"
+#include "alsSparseLifeGrid.h"
+#include "alsThreadPool.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace almond::bench {
+
+    namespace {
+
+        // Same worker count as the engine's job system
+        ThreadPool& SharedPool() {
+            static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+
+        // A settled sand grid sleeps and costs nothing, so each call reseeds and then runs a fixed
+        // number of steps; the reseed is part of the timed work
+        void SandFall(Run& run, Material material, int density, ThreadPool* pool) {
+            constexpr int kSteps = 32;
+            SandGrid grid(512, 512);
+            run.Measure([&] {
+                grid.randomize(run.Seed(), density, static_cast<std::uint8_t>(material));
+                for (int i = 0; i < kSteps; ++i) grid.step(pool);
+                DoNotOptimize(grid.getCells().data());
+            }, kSteps);
+        }
+
+        // A random soup keeps a dense grid busy for thousands of generations, and a dense step costs
+        // the same whatever the pattern, so the grid is seeded once
+        void LifeStep(Run& run, ThreadPool* pool) {
+            LifeGrid grid(2048, 2048);
+            grid.randomize(run.Seed());
+            run.Measure([&] {
+                grid.step(pool);
+                DoNotOptimize(grid.row(0));
+            });
+        }
+
+    }
+
+    void RegisterSimulationBenchmarks(Registry& registry) {
+        registry.Add("SandGrid/sand_512x512_x32", [](Run& run) { SandFall(run, Material::Sand, 5, nullptr); });
+        registry.Add("SandGrid/sand_512x512_x32_pool", [](Run& run) { SandFall(run, Material::Sand, 5, &SharedPool()); });
+        registry.Add("SandGrid/water_512x512_x32", [](Run& run) { SandFall(run, Material::Water, 3, nullptr); });
+
+        registry.Add("LifeGrid/step_2048x2048", [](Run& run) { LifeStep(run, nullptr); });
+        registry.Add("LifeGrid/step_2048x2048_pool", [](Run& run) { LifeStep(run, &SharedPool()); });
+
+        // A 256x256 soup in an otherwise empty 8192x8192 world: the case the sparse grid exists for
+        registry.Add("SparseLifeGrid/soup_256_in_8192_x16", [](Run& run) {
+            constexpr int kSteps = 16;
+            SparseLifeGrid grid(8192, 8192);
+            run.Measure([&] {
+                grid.clear();
+                Random random(run.Seed());
+                for (int y = 0; y < 256; ++y) {
+                    for (int x = 0; x < 256; ++x) {
+                        if (random.Next() & 1) grid.set(4096 + x, 4096 + y, true);
+                    }
+                }
+                for (int i = 0; i < kSteps; ++i) grid.step();
+                DoNotOptimize(grid.getTileCount());
+            }, kSteps);
+        });
+    }
+
+} // namespace almond::bench
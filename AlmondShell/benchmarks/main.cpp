@@ -0,0 +1,132 @@
+// Headless benchmark runner for the engine's simulations and core containers.
+//
+// usage: AlmondBenchmarks [--filter TEXT] [--seed N] [--samples N] [--min-sample-ms MS] [--json PATH|-]
+//                         [--baseline PATH] [--threshold PERCENT] [--list]
+//
+// Every benchmark builds its inputs from the seed, so two runs with the same seed do identical
+// work. --json writes the results (a file written this way is also a baseline); --baseline
+// compares the medians against such a file and exits with 2 when any benchmark got slower than
+// the threshold (default 10%).
+
+#include "BenchmarkHarness.h"
+#include "Benchmarks.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct CommandLine {
+        almond::bench::Options options;
+        std::string filter;
+        std::string jsonPath;
+        std::string baselinePath;
+        double thresholdPercent = 10.0;
+        bool list = false;
+    };
+
+    void PrintUsage() {
+        std::cerr << "usage: AlmondBenchmarks [--filter TEXT] [--seed N] [--samples N] [--min-sample-ms MS] [--json PATH|-]\n"
+                     "                        [--baseline PATH] [--threshold PERCENT] [--list]\n";
+    }
+
+    bool ParseCommandLine(int argc, char* argv[], CommandLine& commandLine) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--list") {
+                commandLine.list = true;
+                continue;
+            }
+            if (i + 1 >= argc) return false;
+
+            std::string value = argv[++i];
+            if (arg == "--filter") commandLine.filter = value;
+            else if (arg == "--seed") commandLine.options.seed = std::stoull(value);
+            else if (arg == "--samples") commandLine.options.samples = std::stoi(value);
+            else if (arg == "--min-sample-ms") commandLine.options.minSampleMs = std::stod(value);
+            else if (arg == "--json") commandLine.jsonPath = value;
+            else if (arg == "--baseline") commandLine.baselinePath = value;
+            else if (arg == "--threshold") commandLine.thresholdPercent = std::stod(value);
+            else return false;
+        }
+        return commandLine.options.samples > 0;
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+    CommandLine commandLine;
+    try {
+        if (!ParseCommandLine(argc, argv, commandLine)) {
+            PrintUsage();
+            return 1;
+        }
+    }
+    catch (const std::exception&) {
+        PrintUsage();
+        return 1;
+    }
+
+    almond::bench::Registry registry;
+    almond::bench::RegisterSimulationBenchmarks(registry);
+    almond::bench::RegisterCoreBenchmarks(registry);
+
+    if (commandLine.list) {
+        for (const auto& benchmark : registry.GetBenchmarks()) std::cout << benchmark.name << "\n";
+        return 0;
+    }
+
+    // With JSON on stdout the table goes to stderr so the output stays parseable
+    std::ostream& report = commandLine.jsonPath == "-" ? std::cerr : std::cout;
+#ifndef NDEBUG
+    report << "Warning: this is a debug build; timings are not representative.\n";
+#endif
+
+    std::vector<almond::bench::Result> results;
+    try {
+        for (const auto& benchmark : registry.GetBenchmarks()) {
+            if (benchmark.name.find(commandLine.filter) == std::string::npos) continue;
+
+            almond::bench::Run run(benchmark.name, commandLine.options);
+            benchmark.body(run);
+            if (!run.WasMeasured()) {
+                std::cerr << benchmark.name << " never called Measure()\n";
+                return 1;
+            }
+
+            const auto& result = run.GetResult();
+            report << std::left << std::setw(48) << result.name << std::right
+                << std::setw(12) << almond::bench::FormatNs(result.medianNs)
+                << "  +/- " << std::setw(10) << almond::bench::FormatNs(result.stddevNs)
+                << std::setw(14) << std::fixed << std::setprecision(0) << result.ItemsPerSecond() << " items/s\n";
+            results.push_back(result);
+        }
+
+        if (commandLine.jsonPath == "-") {
+            almond::bench::WriteJson(std::cout, commandLine.options, results);
+        }
+        else if (!commandLine.jsonPath.empty()) {
+            std::ofstream json(commandLine.jsonPath);
+            if (!json) {
+                std::cerr << "Could not write " << commandLine.jsonPath << "\n";
+                return 1;
+            }
+            almond::bench::WriteJson(json, commandLine.options, results);
+        }
+
+        if (!commandLine.baselinePath.empty()) {
+            const auto baseline = almond::bench::ReadBaseline(commandLine.baselinePath);
+            if (almond::bench::CompareWithBaseline(baseline, results, commandLine.thresholdPercent, report) > 0) {
+                return 2;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
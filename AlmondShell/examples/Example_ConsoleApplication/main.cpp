@@ -4,45 +4,32 @@
 #include <cstdlib>
 #include <ctime>
 
-// Define a basic Cellular Automaton class
+// Game of Life backed by the engine's bit-packed grid (see alsLifeGrid.h)
+#include "alsLifeGrid.h"
+#include <bit>
+
 class CellularAutomaton {
 public:
     CellularAutomaton(int width, int height)
-        : width(width), height(height), grid(width* height, false) {
+        : grid(width, height) {
     }
 
     void randomize() {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                grid[y * width + x] = (rand() % 2 == 0);
-            }
-        }
+        grid.randomize((static_cast<std::uint64_t>(rand()) << 32) | static_cast<std::uint64_t>(rand()));
     }
 
-    void update() {
-        std::vector<bool> newGrid(width * height, false);
-
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                int liveNeighbors = countLiveNeighbors(x, y);
-                if (grid[y * width + x]) {
-                    newGrid[y * width + x] = (liveNeighbors == 2 || liveNeighbors == 3);
-                }
-                else {
-                    newGrid[y * width + x] = (liveNeighbors == 3);
-                }
-            }
-        }
-
-        grid = newGrid;
+    void update(almond::ThreadPool* pool = nullptr) {
+        grid.step(pool);
     }
 
     void render(SDL_Renderer* renderer, int cellSize) const {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                if (grid[y * width + x]) {
-                    SDL_FRect rect = { x * cellSize, y * cellSize, cellSize, cellSize };
-                    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White for live cells
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White for live cells
+        for (int y = 0; y < grid.getHeight(); ++y) {
+            const std::uint64_t* words = grid.row(y);
+            for (int w = 0; w < grid.getWordsPerRow(); ++w) {
+                for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                    int x = w * 64 + std::countr_zero(bits);
+                    SDL_FRect rect = { static_cast<float>(x * cellSize), static_cast<float>(y * cellSize), static_cast<float>(cellSize), static_cast<float>(cellSize) };
                     SDL_RenderFillRect(renderer, &rect);
                 }
             }
@@ -50,85 +37,37 @@ public:
     }
 
 private:
-    int width, height;
-    std::vector<bool> grid;
-
-    int countLiveNeighbors(int x, int y) const {
-        int count = 0;
-        for (int dy = -1; dy <= 1; ++dy) {
-            for (int dx = -1; dx <= 1; ++dx) {
-                if (dx == 0 && dy == 0) continue; // Skip the cell itself
-                int nx = x + dx, ny = y + dy;
-                if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-                    count += grid[ny * width + nx] ? 1 : 0;
-                }
-            }
-        }
-        return count;
-    }
+    almond::LifeGrid grid;
 };
 
-// Define a sand simulation class
+// Sand backed by the engine's chunked grid (see alsSandGrid.h)
+#include "alsSandGrid.h"
+
 class SandSimulation {
 public:
     SandSimulation(int width, int height)
-        : width(width), height(height), grid(width* height, false) {
+        : grid(width, height) {
     }
 
     void randomize() {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                // Add sand particles at random positions
-                grid[y * width + x] = (rand() % 5 == 0); // Adjust density as needed
-            }
-        }
+        grid.randomize((static_cast<std::uint64_t>(rand()) << 32) | static_cast<std::uint64_t>(rand()));
     }
 
-    void update() {
-        std::vector<bool> newGrid(width * height, false);
-
-        for (int y = height - 2; y >= 0; --y) { // Start from the second-to-last row up to the first row
-            for (int x = 0; x < width; ++x) {
-                if (grid[y * width + x]) {
-                    // Check if the cell below is empty
-                    if (y + 1 < height && !grid[(y + 1) * width + x]) {
-                        newGrid[(y + 1) * width + x] = true; // Drop sand down
-                    }
-                    else if (x > 0 && y + 1 < height && !grid[(y + 1) * width + (x - 1)]) {
-                        newGrid[(y + 1) * width + (x - 1)] = true; // Diagonal left
-                    }
-                    else if (x + 1 < width && y + 1 < height && !grid[(y + 1) * width + (x + 1)]) {
-                        newGrid[(y + 1) * width + (x + 1)] = true; // Diagonal right
-                    }
-                    else {
-                        newGrid[y * width + x] = true; // Stay in place if no space to fall
-                    }
-                }
-            }
-        }
-
-        // Ensure particles at the bottom row remain in place
-        for (int x = 0; x < width; ++x) {
-            if (grid[(height - 1) * width + x]) {
-                newGrid[(height - 1) * width + x] = true;
-            }
-        }
-
-        grid = newGrid;
+    void update(almond::ThreadPool* pool = nullptr) {
+        grid.step(pool);
     }
 
     void addSandAt(int x, int y) {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            grid[y * width + x] = true; // Add a sand particle
-        }
+        grid.set(x, y, 1); // Add a sand particle
     }
 
     void render(SDL_Renderer* renderer, int cellSize) const {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                if (grid[y * width + x]) {
-                    SDL_FRect rect = { x * cellSize, y * cellSize, cellSize, cellSize };
-                    SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255); // Yellow for sand
+        SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255); // Yellow for sand
+        const auto& cells = grid.getCells();
+        for (int y = 0; y < grid.getHeight(); ++y) {
+            for (int x = 0; x < grid.getWidth(); ++x) {
+                if (cells[static_cast<size_t>(y) * grid.getWidth() + x]) {
+                    SDL_FRect rect = { static_cast<float>(x * cellSize), static_cast<float>(y * cellSize), static_cast<float>(cellSize), static_cast<float>(cellSize) };
                     SDL_RenderFillRect(renderer, &rect);
                 }
             }
@@ -136,8 +75,7 @@ public:
     }
 
 private:
-    int width, height;
-    std::vector<bool> grid;
+    almond::SandGrid grid;
 };
 
 int main(int argc, char* argv[]) {
@@ -61,13 +61,55 @@ public:
     void Shutdown() override {
         std::cout << "ExampleMod shutting down!" << std::endl;
     }
+
+    void Update(float deltaTime) {
+        elapsed += deltaTime;
+        if (elapsed >= 5.0f) {
+            std::cout << "ExampleMod updating..." << std::endl;
+            elapsed = 0.0f;
+        }
+    }
+
+    void OnEvent(const almond::plugin::PluginEvent& event) {
+        if (event.type == static_cast<std::uint32_t>(almond::EventType::KeyPress)) {
+            ++keyPresses;
+        }
+    }
+
+private:
+    float elapsed = 0.0f;
+    int keyPresses = 0;
 };
 
+// Metadata the engine reads before creating the mod. Name the mods that must be initialized
+// before this one in dependencies.
+static const almond::plugin::PluginInfo exampleModInfo{ "ExampleMod", "0.0.1", nullptr, 0 };
+
+extern "C" __declspec(dllexport) const almond::plugin::PluginInfo* GetPluginInfo() {
+    return &exampleModInfo;
+}
+
 // Exported entry point to create the mod plugin.
 extern "C" __declspec(dllexport) almond::plugin::IPlugin* CreatePlugin() {
     return new ExampleMod();
 }
 
+// Frame hooks, called through plain function pointers. The mod only touches its own members, so it
+// declares itself thread-safe and may be updated on a worker alongside other mods.
+extern "C" __declspec(dllexport) bool GetPluginHooks(std::uint32_t abiVersion, almond::plugin::IPlugin* plugin, almond::plugin::PluginHooks* hooks) {
+    if (abiVersion != almond::plugin::kPluginAbiVersion) {
+        return false;
+    }
+
+    hooks->flags = almond::plugin::kPluginThreadSafe;
+    // Store the derived pointer: the hooks cast context straight back to ExampleMod*, which is only
+    // the same address as the IPlugin* when IPlugin happens to sit at offset 0
+    hooks->context = static_cast<ExampleMod*>(plugin);
+    hooks->update = [](void* self, float deltaTime) { static_cast<ExampleMod*>(self)->Update(deltaTime); };
+    hooks->onEvent = [](void* self, const almond::plugin::PluginEvent* event) { static_cast<ExampleMod*>(self)->OnEvent(*event); };
+    return true;
+}
+
 // Exported entry point to destroy the mod plugin.
 extern "C" __declspec(dllexport) void DestroyPlugin(almond::plugin::IPlugin* plugin) {
     delete plugin;
@@ -1,17 +1,47 @@
 #pragma once
 #include "alsPluginManager.h"
+#include "alsThreadPool.h"
+
+#include <exception>
 #include <future>
-#include <thread>
+#include <memory>
 
 namespace almond::plugin {
 
-    // AsyncPluginManager extends PluginManager to add async loading of plugins
+    // AsyncPluginManager extends PluginManager to load plugins on the job system. Loads run as
+    // ordinary jobs rather than a thread each, and PluginManager serializes access to the loaded
+    // plugins, so any number of loads can be in flight at once.
     class AsyncPluginManager : public PluginManager {
     public:
+        AsyncPluginManager(const std::string& logFileName, almond::RobustTime& timeSystem, ThreadPool& jobSystem)
+            : PluginManager(logFileName, timeSystem), jobSystem(jobSystem) {
+        }
+
         std::future<bool> LoadPluginAsync(const std::filesystem::path& path) {
-            return std::async(std::launch::async, [this, path]() {
-                return LoadPlugin(path);
-                });
+            return Run([this, path]() { return LoadPlugin(path); });
+        }
+
+        // Resolves to the number of plugins loaded. Initialize() runs on a worker, in dependency order.
+        std::future<size_t> LoadPluginsFromDirectoryAsync(const std::filesystem::path& directory) {
+            return Run([this, directory]() { return LoadPluginsFromDirectory(directory, &jobSystem); });
+        }
+
+    private:
+        ThreadPool& jobSystem;
+
+        template <typename Function>
+        auto Run(Function function) -> std::future<decltype(function())> {
+            auto promise = std::make_shared<std::promise<decltype(function())>>();
+            auto result = promise->get_future();
+            jobSystem.enqueue([promise, function]() {
+                try {
+                    promise->set_value(function());
+                }
+                catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+            return result;
         }
     };
 
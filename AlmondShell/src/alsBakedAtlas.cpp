@@ -0,0 +1,237 @@
+#include "alsBakedAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace almond {
+
+    namespace {
+        constexpr char kMagic[4] = { 'A', 'L', 'A', 'T' };
+
+        template <typename T>
+        void Write(std::vector<std::uint8_t>& out, T value) {
+            const size_t offset = out.size();
+            out.resize(offset + sizeof(T));
+            std::memcpy(out.data() + offset, &value, sizeof(T));
+        }
+
+        // Bounds-checked cursor over the file contents
+        struct Reader {
+            const std::uint8_t* data;
+            size_t size;
+            size_t offset = 0;
+
+            const std::uint8_t* Take(size_t count) {
+                if (count > size - offset) {
+                    throw std::runtime_error("Baked atlas is truncated.");
+                }
+                const std::uint8_t* ptr = data + offset;
+                offset += count;
+                return ptr;
+            }
+
+            template <typename T>
+            T Read() {
+                T value;
+                std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+                return value;
+            }
+        };
+    }
+
+    BakedAtlas BakedAtlas::Load(const std::filesystem::path& filepath) {
+        // Parsed straight out of the mapping; uncompressed pages are never copied at all
+        auto contents = std::make_shared<const MappedFile>(filepath);
+
+        Reader reader{ contents->data(), contents->size() };
+        if (std::memcmp(reader.Take(sizeof(kMagic)), kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error("Not a baked atlas: " + filepath.string());
+        }
+
+        auto version = reader.Read<std::uint32_t>();
+        if (version != kVersion) {
+            throw std::runtime_error("Unsupported baked atlas version " + std::to_string(version) + ": " + filepath.string());
+        }
+
+        auto flags = reader.Read<std::uint32_t>();
+        auto pageCount = reader.Read<std::uint32_t>();
+        auto spriteCount = reader.Read<std::uint32_t>();
+
+        BakedAtlas atlas;
+        atlas.mipLevels = std::max(1, static_cast<int>((flags >> kMipLevelsShift) & 0xFF));
+        atlas.sprites.reserve(spriteCount);
+        atlas.names.reserve(spriteCount);
+        atlas.lookup.reserve(spriteCount);
+
+        for (std::uint32_t i = 0; i < spriteCount; ++i) {
+            auto nameLength = reader.Read<std::uint16_t>();
+            std::string name(reinterpret_cast<const char*>(reader.Take(nameLength)), nameLength);
+
+            BakedSprite sprite;
+            sprite.page = reader.Read<std::uint16_t>();
+            sprite.x = reader.Read<std::int32_t>();
+            sprite.y = reader.Read<std::int32_t>();
+            sprite.width = reader.Read<std::int32_t>();
+            sprite.height = reader.Read<std::int32_t>();
+            sprite.trimX = reader.Read<std::int32_t>();
+            sprite.trimY = reader.Read<std::int32_t>();
+            sprite.sourceWidth = reader.Read<std::int32_t>();
+            sprite.sourceHeight = reader.Read<std::int32_t>();
+
+            atlas.lookup.emplace(name, static_cast<std::uint32_t>(atlas.sprites.size()));
+            atlas.names.push_back(std::move(name));
+            atlas.sprites.push_back(sprite);
+        }
+
+        atlas.pages.reserve(pageCount);
+        for (std::uint32_t i = 0; i < pageCount; ++i) {
+            BakedAtlasPage page;
+            page.width = static_cast<int>(reader.Read<std::uint32_t>());
+            page.height = static_cast<int>(reader.Read<std::uint32_t>());
+            page.channels = static_cast<int>(reader.Read<std::uint32_t>());
+            auto rawSize = reader.Read<std::uint64_t>();
+            auto storedSize = reader.Read<std::uint64_t>();
+            const std::uint8_t* stored = reader.Take(storedSize);
+
+            if (rawSize != static_cast<std::uint64_t>(page.width) * page.height * page.channels) {
+                throw std::runtime_error("Baked atlas page has an invalid size: " + filepath.string());
+            }
+
+            if (flags & kFlagCompressed) {
+                page.pixels.resize(rawSize);
+                uLongf destSize = static_cast<uLongf>(rawSize);
+                if (uncompress(page.pixels.data(), &destSize, stored, static_cast<uLong>(storedSize)) != Z_OK || destSize != rawSize) {
+                    throw std::runtime_error("Failed to decompress baked atlas page: " + filepath.string());
+                }
+            }
+            else {
+                if (storedSize != rawSize) {
+                    throw std::runtime_error("Baked atlas page has an invalid size: " + filepath.string());
+                }
+                page.mapped = stored;
+                atlas.mapping = contents;
+            }
+
+            atlas.pages.push_back(std::move(page));
+        }
+
+        for (auto& sprite : atlas.sprites) {
+            if (sprite.page >= atlas.pages.size()) {
+                throw std::runtime_error("Baked atlas sprite references a missing page: " + filepath.string());
+            }
+            atlas.ComputeUVs(sprite);
+        }
+
+        return atlas;
+    }
+
+    void BakedAtlas::Save(const std::filesystem::path& filepath, bool compress) const {
+        std::vector<std::uint8_t> out;
+        out.insert(out.end(), kMagic, kMagic + sizeof(kMagic));
+        Write<std::uint32_t>(out, kVersion);
+        Write<std::uint32_t>(out, (compress ? kFlagCompressed : 0u) | (static_cast<std::uint32_t>(std::clamp(mipLevels, 1, 255)) << kMipLevelsShift));
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(pages.size()));
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(sprites.size()));
+
+        for (size_t i = 0; i < sprites.size(); ++i) {
+            const auto& name = names[i];
+            const auto& sprite = sprites[i];
+            if (name.size() > 0xFFFF) {
+                throw std::runtime_error("Sprite name is too long: " + name);
+            }
+
+            Write<std::uint16_t>(out, static_cast<std::uint16_t>(name.size()));
+            out.insert(out.end(), name.begin(), name.end());
+            Write<std::uint16_t>(out, sprite.page);
+            for (int value : { sprite.x, sprite.y, sprite.width, sprite.height, sprite.trimX, sprite.trimY, sprite.sourceWidth, sprite.sourceHeight }) {
+                Write<std::int32_t>(out, value);
+            }
+        }
+
+        for (const auto& page : pages) {
+            Write<std::uint32_t>(out, static_cast<std::uint32_t>(page.width));
+            Write<std::uint32_t>(out, static_cast<std::uint32_t>(page.height));
+            Write<std::uint32_t>(out, static_cast<std::uint32_t>(page.channels));
+            const size_t rawSize = page.SizeBytes();
+            if (!page.Data()) {
+                throw std::runtime_error("Baked atlas page pixels were already released.");
+            }
+            Write<std::uint64_t>(out, rawSize);
+
+            if (compress) {
+                uLongf compressedSize = compressBound(static_cast<uLong>(rawSize));
+                std::vector<Bytef> compressed(compressedSize);
+                if (compress2(compressed.data(), &compressedSize, page.Data(), static_cast<uLong>(rawSize), Z_BEST_COMPRESSION) != Z_OK) {
+                    throw std::runtime_error("Failed to compress baked atlas page.");
+                }
+                Write<std::uint64_t>(out, compressedSize);
+                out.insert(out.end(), compressed.begin(), compressed.begin() + compressedSize);
+            }
+            else {
+                Write<std::uint64_t>(out, rawSize);
+                out.insert(out.end(), page.Data(), page.Data() + rawSize);
+            }
+        }
+
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open baked atlas for writing: " + filepath.string());
+        }
+        file.write(reinterpret_cast<const char*>(out.data()), out.size());
+    }
+
+    std::uint16_t BakedAtlas::AddPage(BakedAtlasPage page) {
+        if (pages.size() >= 0xFFFF) {
+            throw std::runtime_error("Baked atlas has too many pages.");
+        }
+        pages.push_back(std::move(page));
+        return static_cast<std::uint16_t>(pages.size() - 1);
+    }
+
+    void BakedAtlas::AddSprite(const std::string& name, const BakedSprite& sprite) {
+        if (sprite.page >= pages.size()) {
+            throw std::runtime_error("Sprite '" + name + "' references a missing page.");
+        }
+        if (!lookup.emplace(name, static_cast<std::uint32_t>(sprites.size())).second) {
+            throw std::runtime_error("Sprite with name '" + name + "' already exists.");
+        }
+
+        names.push_back(name);
+        sprites.push_back(sprite);
+        ComputeUVs(sprites.back());
+    }
+
+    const BakedSprite* BakedAtlas::FindSprite(const std::string& name) const {
+        auto it = lookup.find(name);
+        return it != lookup.end() ? &sprites[it->second] : nullptr;
+    }
+
+    const BakedSprite& BakedAtlas::GetSprite(const std::string& name) const {
+        if (const BakedSprite* sprite = FindSprite(name)) {
+            return *sprite;
+        }
+        throw std::runtime_error("Sprite with name '" + name + "' not found.");
+    }
+
+    void BakedAtlas::ReleasePixels() {
+        for (auto& page : pages) {
+            page.pixels.clear();
+            page.pixels.shrink_to_fit();
+            page.mapped = nullptr;
+        }
+        mapping.reset();
+    }
+
+    void BakedAtlas::ComputeUVs(BakedSprite& sprite) const {
+        const auto& page = pages[sprite.page];
+        sprite.uMin = static_cast<float>(sprite.x) / page.width;
+        sprite.vMin = static_cast<float>(sprite.y) / page.height;
+        sprite.uMax = static_cast<float>(sprite.x + sprite.width) / page.width;
+        sprite.vMax = static_cast<float>(sprite.y + sprite.height) / page.height;
+    }
+
+} // namespace almond
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "alsMappedFile.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace almond {
+
+    // A sprite packed by the atlas baker. x/y/width/height is the trimmed rect inside its page;
+    // trimX/trimY place that rect inside the original sourceWidth x sourceHeight image.
+    struct BakedSprite {
+        std::uint16_t page = 0;
+        int x = 0, y = 0, width = 0, height = 0;
+        int trimX = 0, trimY = 0;
+        int sourceWidth = 0, sourceHeight = 0;
+        float uMin = 0.0f, vMin = 0.0f, uMax = 0.0f, vMax = 0.0f;
+    };
+
+    struct BakedAtlasPage {
+        int width = 0;
+        int height = 0;
+        int channels = 4;
+        std::vector<std::uint8_t> pixels;
+        const std::uint8_t* mapped = nullptr; // Set instead of pixels for uncompressed pages of a loaded file
+
+        const std::uint8_t* Data() const { return mapped ? mapped : pixels.data(); }
+        size_t SizeBytes() const { return static_cast<size_t>(width) * height * channels; }
+    };
+
+    // Pre-packed atlas pages plus a name -> sprite manifest, produced offline by the AtlasBaker tool.
+    //
+    // File layout (little-endian):
+    //   header   "ALAT", u32 version, u32 flags, u32 pageCount, u32 spriteCount
+    //            flags bit 0 = zlib pages, bits 8-15 = mip levels the gutters were sized for (0 = 1)
+    //   sprites  u16 nameLength, name bytes, u16 page, i32 x, y, width, height, trimX, trimY, sourceWidth, sourceHeight
+    //   pages    u32 width, height, channels, u64 rawSize, u64 storedSize, pixel bytes (zlib if flagged)
+    class BakedAtlas {
+    public:
+        static constexpr std::uint32_t kVersion = 1;
+        static constexpr std::uint32_t kFlagCompressed = 1u << 0;
+        static constexpr std::uint32_t kMipLevelsShift = 8;
+
+        static BakedAtlas Load(const std::filesystem::path& filepath);
+        void Save(const std::filesystem::path& filepath, bool compress) const;
+
+        // Used by the baker while building an atlas
+        std::uint16_t AddPage(BakedAtlasPage page);
+        void AddSprite(const std::string& name, const BakedSprite& sprite);
+
+        // Number of mip levels that sample without bleeding between sprites: the baker aligned
+        // every sprite to 2^(levels-1) texels and extruded its edges that far into the gutter
+        void SetMipLevels(int levels) { mipLevels = levels; }
+        int GetMipLevels() const { return mipLevels; }
+
+        // O(1) lookup; returns nullptr if the name is not in the manifest
+        const BakedSprite* FindSprite(const std::string& name) const;
+        const BakedSprite& GetSprite(const std::string& name) const;
+
+        const std::vector<BakedAtlasPage>& GetPages() const { return pages; }
+        const std::vector<std::string>& GetSpriteNames() const { return names; }
+        const std::vector<BakedSprite>& GetSprites() const { return sprites; }
+
+        // Frees CPU-side pixels (and the file mapping) once the pages have been uploaded
+        void ReleasePixels();
+
+    private:
+        std::vector<BakedAtlasPage> pages;
+        std::shared_ptr<const MappedFile> mapping; // Backs every page's mapped pointer
+        int mipLevels = 1;
+        std::vector<BakedSprite> sprites;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::uint32_t> lookup;
+
+        void ComputeUVs(BakedSprite& sprite) const;
+    };
+
+} // namespace almond
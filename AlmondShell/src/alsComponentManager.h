@@ -1,10 +1,15 @@
 #pragma once
 
+#include "alsMemoryTracker.h"
+#include "alsPoolAllocator.h"
+
+#include <functional>
 #include <unordered_map>
 #include <vector>
 #include <typeindex>
 #include <cassert>
 #include <memory>
+#include <utility>
 
 namespace almond {
 // Renaming Entity type alias to EntityID to avoid conflict
@@ -19,17 +24,28 @@ public:
     T& getComponent(EntityID entity);
 
 private:
-    std::unordered_map<EntityID, std::unordered_map<std::type_index, std::unique_ptr<void>>> components;
+    // Type-erased owner; the deleter remembers the component type and returns it to its pool
+    using ComponentPtr = std::unique_ptr<void, void(*)(void*)>;
+
+    // Components, and the map nodes that hold them, come from size-class pools rather than the heap
+    template<typename Key, typename Value>
+    using PooledMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>, PoolAllocator<std::pair<const Key, Value>>>;
+
+    PooledMap<EntityID, PooledMap<std::type_index, ComponentPtr>> components;
 };
 
 template<typename T>
 void ComponentManager::addComponent(EntityID entity, T component) {
-    components[entity][std::type_index(typeid(T))] = std::make_unique<T>(component);
+    ALMOND_MEMORY_TAG(ECS);
+    components[entity].insert_or_assign(std::type_index(typeid(T)),
+        ComponentPtr(MakePooled<T>(std::move(component)).release(), [](void* p) { PoolDeleter<T>()(static_cast<T*>(p)); }));
 }
 
 template<typename T>
 T& ComponentManager::getComponent(EntityID entity) {
-    assert(components[entity].count(std::type_index(typeid(T))) > 0 && "Component not found!");
-    return *static_cast<T*>(components[entity][std::type_index(typeid(T))].get());
+    auto& entityComponents = components[entity];
+    auto it = entityComponents.find(std::type_index(typeid(T)));
+    assert(it != entityComponents.end() && "Component not found!");
+    return *static_cast<T*>(it->second.get());
 }
 } // namespace almond
@@ -0,0 +1,362 @@
+#include "alsCompressedImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace almond {
+
+    namespace {
+        template <typename T>
+        T ReadLE(const std::uint8_t* p) {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        template <typename T>
+        void Write(std::vector<std::uint8_t>& out, T value) {
+            const size_t offset = out.size();
+            out.resize(offset + sizeof(T));
+            std::memcpy(out.data() + offset, &value, sizeof(T));
+        }
+
+        void WriteFile(const std::filesystem::path& filepath, const std::vector<std::uint8_t>& out) {
+            std::ofstream file(filepath, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Failed to open compressed texture for writing: " + filepath.string());
+            }
+            file.write(reinterpret_cast<const char*>(out.data()), out.size());
+        }
+
+        constexpr std::uint32_t FourCC(char a, char b, char c, char d) {
+            return std::uint32_t(std::uint8_t(a)) | (std::uint32_t(std::uint8_t(b)) << 8) |
+                (std::uint32_t(std::uint8_t(c)) << 16) | (std::uint32_t(std::uint8_t(d)) << 24);
+        }
+
+        // DDS: "DDS " magic, 124-byte header, optional 20-byte DX10 header, then levels largest first
+        constexpr size_t kDDSHeaderEnd = 128;
+        constexpr size_t kDDSDX10End = 148;
+        constexpr std::uint32_t kDDPFFourCC = 0x4;
+        enum : std::uint32_t { DXGI_BC1 = 71, DXGI_BC1_SRGB = 72, DXGI_BC3 = 77, DXGI_BC3_SRGB = 78, DXGI_BC7 = 98, DXGI_BC7_SRGB = 99 };
+
+        // KTX2: 12-byte identifier, fixed header, level index (largest first), data format descriptor,
+        // level data (smallest first). sRGB variants are accepted and treated like the UNORM ones,
+        // matching how the engine uploads uncompressed art.
+        constexpr std::uint8_t kKTX2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+        constexpr size_t kKTX2HeaderEnd = 80;
+        enum : std::uint32_t {
+            VK_BC1_RGB = 131, VK_BC1_RGB_SRGB = 132, VK_BC1_RGBA = 133, VK_BC1_RGBA_SRGB = 134,
+            VK_BC3 = 137, VK_BC3_SRGB = 138, VK_BC7 = 145, VK_BC7_SRGB = 146,
+            VK_ETC2_RGB8 = 147, VK_ETC2_RGB8_SRGB = 148, VK_ETC2_RGBA8 = 151, VK_ETC2_RGBA8_SRGB = 152,
+            VK_ASTC_4x4 = 157, VK_ASTC_4x4_SRGB = 158
+        };
+
+        std::uint32_t ToVkFormat(CompressedFormat format) {
+            switch (format) {
+            case CompressedFormat::BC1: return VK_BC1_RGBA;
+            case CompressedFormat::BC3: return VK_BC3;
+            case CompressedFormat::BC7: return VK_BC7;
+            case CompressedFormat::ETC2_RGB8: return VK_ETC2_RGB8;
+            case CompressedFormat::ETC2_RGBA8: return VK_ETC2_RGBA8;
+            case CompressedFormat::ASTC_4x4: return VK_ASTC_4x4;
+            }
+            return 0;
+        }
+
+        bool FromVkFormat(std::uint32_t vkFormat, CompressedFormat& format) {
+            switch (vkFormat) {
+            case VK_BC1_RGB: case VK_BC1_RGB_SRGB: case VK_BC1_RGBA: case VK_BC1_RGBA_SRGB: format = CompressedFormat::BC1; return true;
+            case VK_BC3: case VK_BC3_SRGB: format = CompressedFormat::BC3; return true;
+            case VK_BC7: case VK_BC7_SRGB: format = CompressedFormat::BC7; return true;
+            case VK_ETC2_RGB8: case VK_ETC2_RGB8_SRGB: format = CompressedFormat::ETC2_RGB8; return true;
+            case VK_ETC2_RGBA8: case VK_ETC2_RGBA8_SRGB: format = CompressedFormat::ETC2_RGBA8; return true;
+            case VK_ASTC_4x4: case VK_ASTC_4x4_SRGB: format = CompressedFormat::ASTC_4x4; return true;
+            default: return false;
+            }
+        }
+
+        // Basic data format descriptor block (Khronos Data Format spec) for a 4x4 block format
+        std::vector<std::uint8_t> MakeDFD(CompressedFormat format) {
+            struct Sample { std::uint16_t bitOffset; std::uint8_t bitLength; std::uint8_t channel; };
+            std::uint8_t colorModel = 0;
+            std::vector<Sample> samples;
+            switch (format) {
+            case CompressedFormat::BC1: colorModel = 128; samples = { { 0, 63, 0 } }; break;
+            case CompressedFormat::BC3: colorModel = 130; samples = { { 0, 63, 15 }, { 64, 63, 0 } }; break;
+            case CompressedFormat::BC7: colorModel = 134; samples = { { 0, 127, 0 } }; break;
+            case CompressedFormat::ETC2_RGB8: colorModel = 161; samples = { { 0, 63, 2 } }; break;
+            case CompressedFormat::ETC2_RGBA8: colorModel = 161; samples = { { 0, 63, 15 }, { 64, 63, 2 } }; break;
+            case CompressedFormat::ASTC_4x4: colorModel = 162; samples = { { 0, 127, 0 } }; break;
+            }
+
+            const std::uint32_t blockSize = 24 + 16 * static_cast<std::uint32_t>(samples.size());
+            std::vector<std::uint8_t> dfd;
+            Write<std::uint32_t>(dfd, 4 + blockSize);
+            Write<std::uint32_t>(dfd, 0);                             // Khronos vendor, basic descriptor
+            Write<std::uint32_t>(dfd, 2u | (blockSize << 16));        // Version 2
+            Write<std::uint32_t>(dfd, colorModel | (1u << 8) | (1u << 16)); // BT.709 primaries, linear transfer
+            Write<std::uint32_t>(dfd, 3u | (3u << 8));                // 4x4x1x1 texel block
+            Write<std::uint32_t>(dfd, static_cast<std::uint32_t>(CompressedImage::BlockBytes(format)));
+            Write<std::uint32_t>(dfd, 0);
+            for (const auto& sample : samples) {
+                Write<std::uint32_t>(dfd, sample.bitOffset | (std::uint32_t(sample.bitLength) << 16) | (std::uint32_t(sample.channel) << 24));
+                Write<std::uint32_t>(dfd, 0);
+                Write<std::uint32_t>(dfd, 0);
+                Write<std::uint32_t>(dfd, 0xFFFFFFFFu);
+            }
+            return dfd;
+        }
+    }
+
+    CompressedImage::CompressedImage(CompressedFormat format, int width, int height)
+        : format(format), width(width), height(height) {}
+
+    bool CompressedImage::IsCompressedFile(const std::filesystem::path& filepath) {
+        const auto extension = filepath.extension();
+        return extension == ".dds" || extension == ".ktx2";
+    }
+
+    int CompressedImage::BlockBytes(CompressedFormat format) {
+        return (format == CompressedFormat::BC1 || format == CompressedFormat::ETC2_RGB8) ? 8 : 16;
+    }
+
+    size_t CompressedImage::LevelSize(CompressedFormat format, int width, int height) {
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+    }
+
+    size_t CompressedImage::SizeBytes() const {
+        size_t total = 0;
+        for (const auto& level : levels) total += level.size;
+        return total;
+    }
+
+    void CompressedImage::AddLevel(int levelWidth, int levelHeight, const std::uint8_t* blocks, size_t size) {
+        if (size != LevelSize(format, levelWidth, levelHeight)) {
+            throw std::runtime_error("Compressed level size does not match its dimensions.");
+        }
+        levels.push_back({ levelWidth, levelHeight, storage.size(), size });
+        storage.insert(storage.end(), blocks, blocks + size);
+    }
+
+    CompressedImage CompressedImage::Load(const std::filesystem::path& filepath) {
+        auto file = std::make_shared<const MappedFile>(filepath);
+        if (filepath.extension() == ".dds") {
+            return LoadDDS(std::move(file), filepath);
+        }
+        else if (filepath.extension() == ".ktx2") {
+            return LoadKTX2(std::move(file), filepath);
+        }
+        throw std::runtime_error("Unsupported compressed texture container: " + filepath.string());
+    }
+
+    void CompressedImage::Save(const std::filesystem::path& filepath) const {
+        if (filepath.extension() == ".dds") {
+            SaveDDS(filepath);
+        }
+        else if (filepath.extension() == ".ktx2") {
+            SaveKTX2(filepath);
+        }
+        else {
+            throw std::runtime_error("Unsupported compressed texture container: " + filepath.string());
+        }
+    }
+
+    CompressedImage CompressedImage::LoadDDS(std::shared_ptr<const MappedFile> file, const std::filesystem::path& filepath) {
+        const std::uint8_t* data = file->data();
+        const size_t size = file->size();
+        if (size < kDDSHeaderEnd || ReadLE<std::uint32_t>(data) != FourCC('D', 'D', 'S', ' ') || ReadLE<std::uint32_t>(data + 4) != 124) {
+            throw std::runtime_error("Invalid DDS file: " + filepath.string());
+        }
+
+        CompressedImage image;
+        image.height = static_cast<int>(ReadLE<std::uint32_t>(data + 12));
+        image.width = static_cast<int>(ReadLE<std::uint32_t>(data + 16));
+        const std::uint32_t levelCount = std::max<std::uint32_t>(1, ReadLE<std::uint32_t>(data + 28));
+        const std::uint32_t pixelFlags = ReadLE<std::uint32_t>(data + 80);
+        const std::uint32_t fourCC = ReadLE<std::uint32_t>(data + 84);
+
+        if (!(pixelFlags & kDDPFFourCC)) {
+            throw std::runtime_error("DDS file is not block compressed: " + filepath.string());
+        }
+
+        size_t offset = kDDSHeaderEnd;
+        if (fourCC == FourCC('D', 'X', 'T', '1')) {
+            image.format = CompressedFormat::BC1;
+        }
+        else if (fourCC == FourCC('D', 'X', 'T', '5')) {
+            image.format = CompressedFormat::BC3;
+        }
+        else if (fourCC == FourCC('D', 'X', '1', '0') && size >= kDDSDX10End) {
+            switch (ReadLE<std::uint32_t>(data + 128)) {
+            case DXGI_BC1: case DXGI_BC1_SRGB: image.format = CompressedFormat::BC1; break;
+            case DXGI_BC3: case DXGI_BC3_SRGB: image.format = CompressedFormat::BC3; break;
+            case DXGI_BC7: case DXGI_BC7_SRGB: image.format = CompressedFormat::BC7; break;
+            default: throw std::runtime_error("Unsupported DDS DXGI format: " + filepath.string());
+            }
+            if (ReadLE<std::uint32_t>(data + 140) > 1) {
+                throw std::runtime_error("DDS texture arrays are not supported: " + filepath.string());
+            }
+            offset = kDDSDX10End;
+        }
+        else {
+            throw std::runtime_error("Unsupported DDS format: " + filepath.string());
+        }
+
+        if (image.width <= 0 || image.height <= 0 || levelCount > 32) {
+            throw std::runtime_error("Invalid DDS dimensions: " + filepath.string());
+        }
+
+        for (std::uint32_t i = 0; i < levelCount; ++i) {
+            const int w = std::max(1, image.width >> i);
+            const int h = std::max(1, image.height >> i);
+            const size_t levelSize = LevelSize(image.format, w, h);
+            if (levelSize > size - offset) {
+                throw std::runtime_error("Truncated DDS file: " + filepath.string());
+            }
+            image.levels.push_back({ w, h, offset, levelSize });
+            offset += levelSize;
+        }
+
+        image.mapped = data;
+        image.mapping = std::move(file);
+        return image;
+    }
+
+    CompressedImage CompressedImage::LoadKTX2(std::shared_ptr<const MappedFile> file, const std::filesystem::path& filepath) {
+        const std::uint8_t* data = file->data();
+        const size_t size = file->size();
+        if (size < kKTX2HeaderEnd || std::memcmp(data, kKTX2Identifier, sizeof(kKTX2Identifier)) != 0) {
+            throw std::runtime_error("Invalid KTX2 file: " + filepath.string());
+        }
+
+        CompressedImage image;
+        if (!FromVkFormat(ReadLE<std::uint32_t>(data + 12), image.format)) {
+            throw std::runtime_error("Unsupported KTX2 format: " + filepath.string());
+        }
+        image.width = static_cast<int>(ReadLE<std::uint32_t>(data + 20));
+        image.height = static_cast<int>(ReadLE<std::uint32_t>(data + 24));
+        const std::uint32_t depth = ReadLE<std::uint32_t>(data + 28);
+        const std::uint32_t layers = ReadLE<std::uint32_t>(data + 32);
+        const std::uint32_t faces = ReadLE<std::uint32_t>(data + 36);
+        const std::uint32_t levelCount = std::max<std::uint32_t>(1, ReadLE<std::uint32_t>(data + 40));
+        const std::uint32_t supercompression = ReadLE<std::uint32_t>(data + 44);
+
+        if (depth > 1 || layers > 1 || faces != 1) {
+            throw std::runtime_error("Only plain 2D KTX2 textures are supported: " + filepath.string());
+        }
+        if (supercompression != 0) {
+            throw std::runtime_error("Supercompressed KTX2 files are not supported: " + filepath.string());
+        }
+        if (image.width <= 0 || image.height <= 0 || levelCount > 32 || kKTX2HeaderEnd + levelCount * 24 > size) {
+            throw std::runtime_error("Invalid KTX2 header: " + filepath.string());
+        }
+
+        for (std::uint32_t i = 0; i < levelCount; ++i) {
+            const std::uint8_t* entry = data + kKTX2HeaderEnd + i * 24;
+            const std::uint64_t offset = ReadLE<std::uint64_t>(entry);
+            const std::uint64_t length = ReadLE<std::uint64_t>(entry + 8);
+            const int w = std::max(1, image.width >> i);
+            const int h = std::max(1, image.height >> i);
+            if (length != LevelSize(image.format, w, h) || offset > size || length > size - offset) {
+                throw std::runtime_error("Invalid KTX2 level " + std::to_string(i) + ": " + filepath.string());
+            }
+            image.levels.push_back({ w, h, static_cast<size_t>(offset), static_cast<size_t>(length) });
+        }
+
+        image.mapped = data;
+        image.mapping = std::move(file);
+        return image;
+    }
+
+    void CompressedImage::SaveDDS(const std::filesystem::path& filepath) const {
+        std::uint32_t fourCC = 0;
+        switch (format) {
+        case CompressedFormat::BC1: fourCC = FourCC('D', 'X', 'T', '1'); break;
+        case CompressedFormat::BC3: fourCC = FourCC('D', 'X', 'T', '5'); break;
+        case CompressedFormat::BC7: fourCC = FourCC('D', 'X', '1', '0'); break;
+        default: throw std::runtime_error("DDS cannot hold ETC2 or ASTC data; save as .ktx2 instead.");
+        }
+
+        std::vector<std::uint8_t> out;
+        out.reserve(kDDSDX10End + SizeBytes());
+        Write<std::uint32_t>(out, FourCC('D', 'D', 'S', ' '));
+        Write<std::uint32_t>(out, 124);
+        Write<std::uint32_t>(out, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000); // caps, size, pixel format, mips, linear size
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(height));
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(width));
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(levels.empty() ? 0 : levels[0].size));
+        Write<std::uint32_t>(out, 0);
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(levels.size()));
+        out.resize(76, 0);                                 // Reserved
+        Write<std::uint32_t>(out, 32);                     // Pixel format size
+        Write<std::uint32_t>(out, kDDPFFourCC);
+        Write<std::uint32_t>(out, fourCC);
+        out.resize(108, 0);                                // Bit count and masks
+        Write<std::uint32_t>(out, 0x1000 | (levels.size() > 1 ? 0x400008u : 0u)); // Texture, complex + mipmap
+        out.resize(kDDSHeaderEnd, 0);
+
+        if (format == CompressedFormat::BC7) {
+            Write<std::uint32_t>(out, DXGI_BC7);
+            Write<std::uint32_t>(out, 3);                  // Texture2D
+            Write<std::uint32_t>(out, 0);
+            Write<std::uint32_t>(out, 1);                  // Array size
+            Write<std::uint32_t>(out, 0);
+        }
+
+        for (const auto& level : levels) {
+            out.insert(out.end(), Data() + level.offset, Data() + level.offset + level.size);
+        }
+        WriteFile(filepath, out);
+    }
+
+    void CompressedImage::SaveKTX2(const std::filesystem::path& filepath) const {
+        const std::vector<std::uint8_t> dfd = MakeDFD(format);
+        const size_t blockBytes = static_cast<size_t>(BlockBytes(format));
+        const size_t dfdOffset = kKTX2HeaderEnd + levels.size() * 24;
+
+        // Level data follows the descriptor, smallest level first, each aligned to a block
+        std::vector<size_t> levelOffsets(levels.size());
+        size_t offset = dfdOffset + dfd.size();
+        for (size_t i = levels.size(); i-- > 0;) {
+            offset = (offset + blockBytes - 1) / blockBytes * blockBytes;
+            levelOffsets[i] = offset;
+            offset += levels[i].size;
+        }
+
+        std::vector<std::uint8_t> out;
+        out.reserve(offset);
+        out.insert(out.end(), kKTX2Identifier, kKTX2Identifier + sizeof(kKTX2Identifier));
+        Write<std::uint32_t>(out, ToVkFormat(format));
+        Write<std::uint32_t>(out, 1);                      // typeSize is 1 for block formats
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(width));
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(height));
+        Write<std::uint32_t>(out, 0);                      // Depth
+        Write<std::uint32_t>(out, 0);                      // Layers
+        Write<std::uint32_t>(out, 1);                      // Faces
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(levels.size()));
+        Write<std::uint32_t>(out, 0);                      // No supercompression
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(dfdOffset));
+        Write<std::uint32_t>(out, static_cast<std::uint32_t>(dfd.size()));
+        Write<std::uint32_t>(out, 0);                      // No key/value data
+        Write<std::uint32_t>(out, 0);
+        Write<std::uint64_t>(out, 0);                      // No supercompression global data
+        Write<std::uint64_t>(out, 0);
+
+        for (size_t i = 0; i < levels.size(); ++i) {
+            Write<std::uint64_t>(out, levelOffsets[i]);
+            Write<std::uint64_t>(out, levels[i].size);
+            Write<std::uint64_t>(out, levels[i].size);
+        }
+        out.insert(out.end(), dfd.begin(), dfd.end());
+
+        for (size_t i = levels.size(); i-- > 0;) {
+            out.resize(levelOffsets[i], 0);
+            out.insert(out.end(), Data() + levels[i].offset, Data() + levels[i].offset + levels[i].size);
+        }
+        WriteFile(filepath, out);
+    }
+
+} // namespace almond
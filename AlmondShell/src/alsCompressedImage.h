@@ -0,0 +1,73 @@
+#pragma once
+
+#include "alsMappedFile.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace almond {
+
+    // Block-compressed formats the engine can upload as is
+    enum class CompressedFormat {
+        BC1,        // DXT1, 4x4 blocks of 8 bytes, RGB with 1-bit alpha
+        BC3,        // DXT5, 4x4 blocks of 16 bytes, RGB + interpolated alpha
+        BC7,        // BPTC, 4x4 blocks of 16 bytes, high quality RGBA
+        ETC2_RGB8,  // 4x4 blocks of 8 bytes
+        ETC2_RGBA8, // 4x4 blocks of 16 bytes
+        ASTC_4x4    // 4x4 blocks of 16 bytes
+    };
+
+    struct CompressedLevel {
+        int width = 0;
+        int height = 0;
+        size_t offset = 0; // Into CompressedImage::Data()
+        size_t size = 0;
+    };
+
+    // A mip chain of compressed blocks read from a DDS or KTX2 container. Level data points into
+    // the file mapping when the file is loaded, so nothing is copied before the upload.
+    class CompressedImage {
+    public:
+        static bool IsCompressedFile(const std::filesystem::path& filepath);
+
+        // Picks the container from the extension (.dds / .ktx2)
+        static CompressedImage Load(const std::filesystem::path& filepath);
+        void Save(const std::filesystem::path& filepath) const;
+
+        // Used by the encoder tool; levels are appended largest first
+        CompressedImage(CompressedFormat format, int width, int height);
+        void AddLevel(int width, int height, const std::uint8_t* blocks, size_t size);
+
+        CompressedFormat GetFormat() const { return format; }
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+        const std::vector<CompressedLevel>& GetLevels() const { return levels; }
+        const std::uint8_t* Data() const { return mapped ? mapped : storage.data(); }
+        size_t SizeBytes() const;
+
+        // The mapping backing Data(), if any; lets a worker fault the pages in ahead of an upload
+        const MappedFile* GetMapping() const { return mapping.get(); }
+
+        static int BlockBytes(CompressedFormat format);
+        static size_t LevelSize(CompressedFormat format, int width, int height);
+
+    private:
+        CompressedImage() = default;
+
+        static CompressedImage LoadDDS(std::shared_ptr<const MappedFile> file, const std::filesystem::path& filepath);
+        static CompressedImage LoadKTX2(std::shared_ptr<const MappedFile> file, const std::filesystem::path& filepath);
+        void SaveDDS(const std::filesystem::path& filepath) const;
+        void SaveKTX2(const std::filesystem::path& filepath) const;
+
+        CompressedFormat format = CompressedFormat::BC1;
+        int width = 0;
+        int height = 0;
+        std::vector<CompressedLevel> levels;
+        std::vector<std::uint8_t> storage;
+        const std::uint8_t* mapped = nullptr; // Start of the file when loaded; offsets are file offsets
+        std::shared_ptr<const MappedFile> mapping;
+    };
+
+} // namespace almond
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "alsLogger.h"
+#include "alsPoolAllocator.h"
 #include "alsRobustTime.h"
 
 #include <deque>
@@ -108,8 +109,8 @@ namespace almond {
         }
 
         // Clone method: creates a new instance with the same ID and position
-        std::unique_ptr<almond::Entity> clone() const {
-            return std::make_unique<almond::Entity>(id, posX, posY, logger.getLogFileName(), m_timeSystem );
+        PoolPtr<almond::Entity> clone() const {
+            return MakePooled<almond::Entity>(id, posX, posY, logger.getLogFileName(), m_timeSystem );
         }
 
     private:
@@ -129,7 +130,11 @@ namespace almond {
             auto now = std::chrono::system_clock::now();
             auto timeT = std::chrono::system_clock::to_time_t(now);
             std::tm tm;
+#if defined(_WIN32) || defined(_WIN64)
             if (localtime_s(&tm, &timeT) != 0) {
+#else
+            if (localtime_r(&timeT, &tm) == nullptr) {
+#endif
                 throw std::runtime_error("Failed to convert time to local time");
             }
             char buffer[80];
@@ -0,0 +1,28 @@
+#include "alsEventSystem.h"
+
+namespace almond {
+
+    std::string EventTypeToString(EventType type) {
+        switch (type) {
+        case EventType::MouseButtonClick: return "MouseButtonClick";
+        case EventType::MouseMove: return "MouseMove";
+        case EventType::KeyPress: return "KeyPress";
+        case EventType::TextInput: return "TextInput";
+        default: return "Unknown";
+        }
+    }
+
+    EventType StringToEventType(const std::string& str) {
+        if (str == "MouseButtonClick") return EventType::MouseButtonClick;
+        if (str == "MouseMove") return EventType::MouseMove;
+        if (str == "KeyPress") return EventType::KeyPress;
+        if (str == "TextInput") return EventType::TextInput;
+        return EventType::Unknown;
+    }
+
+    void EventSystem::RegisterCallback(const std::function<void(const Event&)>& callback) {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        callbacks.push_back(callback);
+    }
+
+} // namespace almond
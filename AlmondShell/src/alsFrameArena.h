@@ -0,0 +1,165 @@
+#pragma once
+
+#include "alsMemoryTracker.h"
+#include "alsMetrics.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace almond {
+
+    // Bump allocator over a list of blocks. Deallocation is a no-op and Reset() rewinds to the first
+    // block in O(1) while keeping every block, so once the arena has grown to a frame's peak it never
+    // goes back to the upstream resource. (std::pmr::monotonic_buffer_resource::release() hands its
+    // blocks back, which would put a malloc in every frame.)
+    class LinearArena : public std::pmr::memory_resource {
+    public:
+        explicit LinearArena(size_t blockSize = 256 * 1024, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+            : blockSize(blockSize), upstream(upstream) {}
+
+        ~LinearArena() override {
+            for (const Block& block : blocks) upstream->deallocate(block.data, block.size, alignof(std::max_align_t));
+        }
+
+        LinearArena(const LinearArena&) = delete;
+        LinearArena& operator=(const LinearArena&) = delete;
+
+        // Everything allocated since the last Reset() becomes invalid
+        void Reset() {
+            current = 0;
+            offset = 0;
+            used = 0;
+        }
+
+        size_t BytesUsed() const { return used; }
+        size_t HighWater() const { return highWater; }
+
+        size_t Capacity() const {
+            size_t total = 0;
+            for (const Block& block : blocks) total += block.size;
+            return total;
+        }
+
+    private:
+        struct Block {
+            std::byte* data;
+            size_t size;
+        };
+
+        size_t blockSize;
+        std::pmr::memory_resource* upstream;
+        std::vector<Block> blocks;
+        size_t current = 0;  // Block being bumped
+        size_t offset = 0;   // Into that block
+        size_t used = 0;
+        size_t highWater = 0;
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            while (current < blocks.size()) {
+                const Block& block = blocks[current];
+                const size_t start = (offset + alignment - 1) & ~(alignment - 1);
+                if (start + bytes <= block.size) {
+                    offset = start + bytes;
+                    Track(bytes);
+                    return block.data + start;
+                }
+                ++current; // The rest of this block is wasted until the next Reset()
+                offset = 0;
+            }
+
+            // Grow: oversized requests get a block of their own
+            const size_t size = (std::max)(blockSize, bytes + alignment);
+            ALMOND_MEMORY_TAG(Allocators);
+            blocks.push_back({ static_cast<std::byte*>(upstream->allocate(size, alignof(std::max_align_t))), size });
+            metrics::Registry::Get().GetCounter("memory.arena_blocks").Add();
+            current = blocks.size() - 1;
+            offset = 0;
+            return do_allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void*, size_t, size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        void Track(size_t bytes) {
+            used += bytes;
+            highWater = (std::max)(highWater, used);
+        }
+    };
+
+    // Scratch memory for data that only lives for a frame or two: containers built and thrown away
+    // during an update, staging for uploads, batch lists. Each thread allocates from its own pair of
+    // LinearArenas, so allocation never takes a lock, and the pair is double-buffered: memory handed
+    // out during frame N stays valid until BeginFrame() starts frame N + 2. A thread's arena is reset
+    // the first time it allocates in a new frame, which costs nothing for threads that sit idle.
+    //
+    //   std::pmr::vector<size_t> scratch(FrameArena::Get().Resource());
+    //
+    // Before the first BeginFrame() (tools, benchmarks, tests) Resource() is the ordinary heap.
+    class FrameArena {
+    public:
+        static constexpr size_t kMaxThreads = 64; // Threads started after this many use the heap
+
+        static FrameArena& Get() {
+            static FrameArena instance;
+            return instance;
+        }
+
+        // Once per frame, on the thread that owns the frame loop
+        void BeginFrame() {
+            frame.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        std::pmr::memory_resource* Resource() {
+            const std::uint64_t current = frame.load(std::memory_order_acquire);
+            const size_t slot = ThreadSlot();
+            if (current == 0 || slot >= kMaxThreads) {
+                return std::pmr::new_delete_resource();
+            }
+
+            ThreadArenas* arenas = threads[slot].load(std::memory_order_acquire);
+            if (!arenas) {
+                arenas = new ThreadArenas();
+                threads[slot].store(arenas, std::memory_order_release);
+            }
+            LinearArena& arena = arenas->buffers[current & 1];
+            if (arenas->frame != current) {
+                arenas->frame = current;
+                if (arena.BytesUsed() > 0) usage.Record(arena.BytesUsed());
+                arena.Reset();
+            }
+            return &arena;
+        }
+
+        ~FrameArena() {
+            for (auto& slot : threads) delete slot.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct ThreadArenas {
+            std::array<LinearArena, 2> buffers;
+            std::uint64_t frame = 0;  // Frame the owning thread last allocated in
+        };
+
+        std::atomic<std::uint64_t> frame{ 0 };
+        std::array<std::atomic<ThreadArenas*>, kMaxThreads> threads{};
+        metrics::Histogram& usage = metrics::Registry::Get().GetHistogram("memory.frame_arena_bytes"); // Per thread per frame
+
+        FrameArena() = default;
+
+        static size_t ThreadSlot() {
+            static std::atomic<size_t> nextSlot{ 0 };
+            thread_local const size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+            return slot;
+        }
+    };
+
+} // namespace almond
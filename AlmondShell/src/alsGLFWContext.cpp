@@ -9,11 +9,20 @@
     #include "alsOpenGLTexture.h" // OpenGL texture manager
     #include "alsOpenGLRenderer.h"
     #include "alsOpenGLTextureAtlas.h"
+    #include "alsOpenGLGridTexture.h"
+    #include "alsTextureStreamer.h"
+    #include "alsOpenGLGpuProfiler.h"
 #endif
 
+#include "alsFrameArena.h"
 #include "alsGLFWSandSim.h"
+#include "alsMemoryTracker.h"
+#include "alsMetrics.h"
+#include "alsProfiler.h"
+#include "alsThreadPool.h"
 
 #include <iostream>
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 #include <stdexcept>
@@ -42,6 +51,15 @@ namespace almond {
     glm::vec2 texOffset = glm::vec2(0.0f, 256.0f);
     glm::vec2 texSize = glm::vec2(1.0f, 1.0f);
 
+    std::unique_ptr<ThreadPool> jobSystem;
+    std::unique_ptr<TextureStreamer> textureStreamer; // Async texture loads, finalized once per frame
+    std::unique_ptr<OpenGLGridTexture> sandTexture;   // The sand grid as a palette texture, drawn full screen
+    std::unique_ptr<metrics::MetricsReporter> metricsReporter; // Appends a JSON line of metrics every second
+#ifdef ALMOND_PROFILING
+    std::unique_ptr<profiler::GpuProfiler> gpuProfiler;
+    const char* const profileTracePath = "almond_trace.json";
+#endif
+
 
     void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
         if (action == GLFW_PRESS) {
@@ -55,6 +73,23 @@ namespace almond {
             //isGameOfLife = !isGameOfLife;
             //isSnakeGame = false;
         }
+
+#ifdef ALMOND_PROFILING
+        // F9 starts a capture; pressing it again writes the trace (open in ui.perfetto.dev)
+        if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+            auto& profiler = profiler::Profiler::Get();
+            if (!profiler.IsCapturing()) {
+                profiler.BeginCapture();
+                std::cout << "Profiler capture started\n";
+            }
+            else {
+                profiler.EndCapture();
+                if (profiler.WriteChromeTrace(profileTracePath)) {
+                    std::cout << "Profiler capture written to " << profileTracePath << "\n";
+                }
+            }
+        }
+#endif
     }
 
     void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
@@ -100,6 +135,8 @@ namespace almond {
     }
 
     void initGLFW() {
+        ALMOND_MEMORY_STARTUP(); // First, so the leak report runs after everything created below is gone
+
         if (!glfwInit()) {
             throw std::runtime_error("Failed to initialize GLFW");
         }
@@ -121,6 +158,24 @@ namespace almond {
             throw std::runtime_error("Failed to initialize GLAD");
         }
 
+#ifdef _DEBUG
+        glEnable(GL_DEBUG_OUTPUT);
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(DebugCallback, nullptr);
+#endif
+
+        // Decode on worker threads, upload on this one
+        unsigned int workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        jobSystem = std::make_unique<ThreadPool>(workerCount);
+        textureStreamer = std::make_unique<TextureStreamer>(*jobSystem);
+
+        metricsReporter = std::make_unique<metrics::MetricsReporter>(metrics::MetricsReporter::Options{ std::chrono::milliseconds(1000), "almond_metrics.jsonl" });
+
+        ALMOND_PROFILE_THREAD("Main");
+#ifdef ALMOND_PROFILING
+        gpuProfiler = std::make_unique<profiler::GpuProfiler>();
+#endif
+
         // glfwSwapInterval(1); // Enable vsync
         glViewport(0, 0, width, height); // Update OpenGL viewport
 
@@ -147,6 +202,10 @@ namespace almond {
         auto lastTime = std::chrono::steady_clock::now();
         int frameCount = 0;
 
+        // Every frame's duration, so the dumps show p99 stutter that the FPS average hides
+        metrics::Histogram& frameTimes = metrics::Registry::Get().GetHistogram("frame.time_ns");
+        metrics::Gauge& fpsGauge = metrics::Registry::Get().GetGauge("frame.fps");
+
         //grab the grid
         const auto& grid = sandSim.getGrid();
 
@@ -168,6 +227,7 @@ namespace almond {
         };
 
         isAtlas = true;
+        ALMOND_MEMORY_TAG(Renderer); // From here to the end of the loop, except where callees tag their own
         // Texture Atlas Setup
         if(isAtlas == true)
         {
@@ -203,6 +263,13 @@ namespace almond {
             
         }
         //  *texture = renderer.GetTexture("C:/Users/iammi/OneDrive/Documents/repos/AlmondShell/AlmondShell/assets/images/bmp3.bmp");
+
+        // One cell byte per texel, coloured by the material table
+        sandTexture = std::make_unique<OpenGLGridTexture>(width, height, OpenGLGridTexture::CellFormat::Byte,
+            "../../assets/shaders/gridvert.glsl", "../../assets/shaders/gridfrag.glsl");
+        std::vector<std::uint32_t> materialColors;
+        for (const auto& material : kMaterials) materialColors.push_back(material.color);
+        sandTexture->SetPalette(materialColors.data(), materialColors.size());
         commands.push_back(std::make_unique<almond::SetVec2Uniform>("scale", glm::vec2(1.0f, 1.0f)));
         
         // Enable wireframe mode
@@ -223,14 +290,24 @@ namespace almond {
         FontRenderer fontRenderer(fontManager, renderer, fontVAO, fontVBO, fontEBO);
         fontRenderer.RenderText("Almond Shell by Adam Rushford", 25.0f, 570.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
 */
+        auto lastFrameTime = std::chrono::steady_clock::now();
         while (!glfwWindowShouldClose(glfwWindow)) {
+            ALMOND_PROFILE_FRAME();
+            FrameArena::Get().BeginFrame(); // Scratch from two frames ago is reused from here on
+#ifdef ALMOND_PROFILING
+            gpuProfiler->BeginFrame();
+#endif
             auto currentTime = std::chrono::steady_clock::now();
             frameCount++;
+            frameTimes.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(currentTime - lastFrameTime).count());
+            lastFrameTime = currentTime;
 
             // Calculate FPS
             std::chrono::duration<float> elapsedTime = currentTime - lastTime;
             if (elapsedTime.count() >= 1.0f) {
                 std::cout << "FPS: " << frameCount << "\n";
+                fpsGauge.Set(frameCount / elapsedTime.count());
+                ALMOND_MEMORY_PUBLISH();
                 frameCount = 0;
                 lastTime = currentTime;
             }
@@ -238,36 +315,37 @@ namespace almond {
             // Clear screen
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+            // Finish any streamed textures that fit in this frame's upload budget
+            {
+                ALMOND_PROFILE_SCOPE("Texture streaming");
+                textureStreamer->Update();
+            }
+
             // Process input
             ProcessInput(0, 0, 4);
             if(isAtlas == true)
             {
                 // Update simulation
-                sandSim.update();
-
-                // Initialize and fill activeParticles with the positions of active particles
-                std::vector<std::pair<int, int>> activeParticles;
-                for (int y = 0; y < height; ++y) {
-                    for (int x = 0; x < width; ++x) {
-                        if (grid[y * width + x] > 0) {
-                            activeParticles.emplace_back(x, y);
-                        }
-                    }
+                {
+                    ALMOND_PROFILE_SCOPE("Sand update");
+                    sandSim.update(jobSystem.get());
                 }
 
-                if (renderer->GetRenderMode(almond::RenderMode::TextureAtlas))
+                // Upload only the rows that changed, then draw the whole grid as one triangle
                 {
-                    // Render particles
-                    if (quad) {
-                        for (const auto& particle : activeParticles) {
-                            float xpos = (float)particle.first / width * 2.0f - 1.0f; // Normalize to [-1, 1] range
-                            float ypos = (float)particle.second / height * 2.0f - 1.0f; // Normalize to [-1, 1] range
-                            commands.push_back(std::make_shared<almond::DrawCommand>(quad, 0, almond::RenderMode::TextureAtlas, xpos, ypos));//, texOffset, texSize
-                        }
+                    ALMOND_PROFILE_SCOPE("Sand upload");
+                    ALMOND_PROFILE_GPU_SCOPE(*gpuProfiler, "Sand upload");
+                    int firstRow = 0, lastRow = 0;
+                    if (sandSim.takeDirtyRows(firstRow, lastRow)) {
+                        sandTexture->MarkDirtyRows(firstRow, lastRow);
                     }
+                    sandTexture->Upload(grid.data());
+                }
+                {
+                    ALMOND_PROFILE_SCOPE("Sand draw");
+                    ALMOND_PROFILE_GPU_SCOPE(*gpuProfiler, "Sand draw");
+                    sandTexture->Draw();
                 }
-
-                renderer->DrawBatch(quad, *textureA, commands);
             }
             else {
                 // A Single Textured Quad Rendered to Screen
@@ -283,7 +361,10 @@ namespace almond {
            // fontRenderer.RenderText("Almond Shell by Adam Rushford", 25.0f, 570.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
 
             // Swap buffers and poll events
-            glfwSwapBuffers(glfwWindow);
+            {
+                ALMOND_PROFILE_SCOPE("Swap buffers");
+                glfwSwapBuffers(glfwWindow);
+            }
             glfwPollEvents();
         }
 
@@ -291,6 +372,15 @@ namespace almond {
     }
 
     void cleanupGLFW() {
+        // GL objects must go before the context does
+        textureStreamer.reset();
+        sandTexture.reset();
+#ifdef ALMOND_PROFILING
+        gpuProfiler.reset();
+#endif
+        jobSystem.reset();
+        metricsReporter.reset();
+
         if (glfwWindow) {
             glfwDestroyWindow(glfwWindow);
             glfwWindow = nullptr;
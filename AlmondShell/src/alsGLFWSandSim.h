@@ -1,110 +1,100 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsSandGrid.h"
 
 #ifdef ALMOND_USING_OPENGL
 
 #include <vector>
+#include <algorithm>
+#include <climits>
 #include <cstdlib>
 #include <iostream>
 #include <tuple>
-#include <algorithm> // for std::count_if
+#include <utility>
 
+// Sand simulation for the GLFW backend; the simulation itself is an almond::SandGrid
 class SandSimulation {
 public:
     SandSimulation(int width, int height)
-        : width(width), height(height), grid(width* height, 0) {
+        : grid(width, height) {
         std::cout << "Initializing sand simulation\n";
+        MarkDirtyRows(0, grid.getHeight() - 1);
     }
 
     // Randomize the grid with some initial sand particles
     void randomize() {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                grid[y * width + x] = (rand() % 5 == 0); // Adjust density as needed
-            }
-        }
+        grid.randomize((static_cast<std::uint64_t>(rand()) << 32) | static_cast<std::uint64_t>(rand()));
+        MarkDirtyRows(0, grid.getHeight() - 1);
     }
 
+    // Resizing starts a new, empty world
     void setWidth(int width)
     {
-        this->width = width;
-        this->grid.resize(width * height);
+        grid.resize(width, grid.getHeight());
+        MarkDirtyRows(0, grid.getHeight() - 1);
     }
     void setHeight(int height)
     {
-        this->height = height;
-        this->grid.resize(width * height);
+        grid.resize(grid.getWidth(), height);
+        MarkDirtyRows(0, grid.getHeight() - 1);
     }
 
     size_t getActiveParticles() const {
-        return std::count_if(grid.begin(), grid.end(), [](uint8_t particle) { return particle > 0; });
+        return grid.countParticles();
     }
 
-
     bool isParticleAt(int x, int y) const {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            return grid[y * width + x] > 0;
-        }
-        return false;
+        return grid.get(x, y) > 0;
     }
 
-    // Update the sand simulation logic
-    void update() {
-        std::vector<uint8_t> newGrid(width * height, 0);
-
-        // Update particles starting from the bottom
-        for (int y = height - 2; y >= 0; --y) {
-            for (int x = 0; x < width; ++x) {
-                if (grid[y * width + x]) {
-                    // Check if the cell below is empty
-                    if (y + 1 < height && !grid[(y + 1) * width + x]) {
-                        newGrid[(y + 1) * width + x] = 1; // Drop sand down
-                    }
-                    else if (x > 0 && y + 1 < height && !grid[(y + 1) * width + (x - 1)]) {
-                        newGrid[(y + 1) * width + (x - 1)] = 1; // Diagonal left
-                    }
-                    else if (x + 1 < width && y + 1 < height && !grid[(y + 1) * width + (x + 1)]) {
-                        newGrid[(y + 1) * width + (x + 1)] = 1; // Diagonal right
-                    }
-                    else {
-                        newGrid[y * width + x] = 1; // Stay in place if no space to fall
-                    }
-                }
-            }
-        }
-
-        // Ensure particles at the bottom row remain in place
-        for (int x = 0; x < width; ++x) {
-            if (grid[(height - 1) * width + x]) {
-                newGrid[(height - 1) * width + x] = 1;
-            }
-        }
-
-        grid = newGrid;
+    // Update the sand simulation logic; pass the job system to spread awake chunks across workers
+    void update(almond::ThreadPool* pool = nullptr) {
+        grid.step(pool);
+        grid.forEachDirtyRect([this](int, int y, int, int h) { MarkDirtyRows(y, y + h - 1); });
     }
 
-    // Add a sand particle at a given position
+    // Add a particle at a given position; sandType is an almond::Material value (1 is sand)
     void addSandAt(int x, int y, uint8_t sandType = 1) {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            grid[y * width + x] = sandType; // Add a sand particle
-        }
+        grid.set(x, y, sandType); // Add a sand particle
+        MarkDirtyRows(y, y);
 #ifdef DEBUG_MODE
         std::cout << "adding sand at x: " << x << " y: " << y << "\n";
 #endif
 
     }
 
-    // Returns the grid for rendering
+    // Returns the grid for rendering: one almond::Material per cell, colours in almond::kMaterials
     const std::vector<uint8_t>& getGrid() const {
-        return grid;
+        return grid.getCells();
+    }
+
+    // Regions changed since the last update, one per awake chunk: fn(x, y, w, h)
+    template <typename Fn>
+    void forEachDirtyRect(Fn&& fn) const {
+        grid.forEachDirtyRect(std::forward<Fn>(fn));
     }
 
+    // Rows changed by updates, brush strokes or resets since the last call, for texture uploads.
+    // Returns false when nothing changed.
+    bool takeDirtyRows(int& first, int& last) {
+        if (dirtyFirst > dirtyLast) return false;
+        first = dirtyFirst;
+        last = dirtyLast;
+        dirtyFirst = INT_MAX;
+        dirtyLast = INT_MIN;
+        return true;
+    }
 
 private:
-    int width;
-    int height;
-    std::vector<uint8_t> grid; // Store what particle type it is
+    almond::SandGrid grid;
+    int dirtyFirst = INT_MAX;
+    int dirtyLast = INT_MIN;
+
+    void MarkDirtyRows(int first, int last) {
+        dirtyFirst = std::min(dirtyFirst, first);
+        dirtyLast = std::max(dirtyLast, last);
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
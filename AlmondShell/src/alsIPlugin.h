@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 namespace almond::plugin {
 
     class IPlugin {
@@ -9,4 +12,51 @@ namespace almond::plugin {
         virtual ~IPlugin() = default;
     };
 
+    // Optional metadata a plugin exports alongside CreatePlugin:
+    //
+    //   extern "C" const almond::plugin::PluginInfo* GetPluginInfo();
+    //
+    // Plain C data, read before the plugin is created. Plugins without it are named after their
+    // file and have no dependencies.
+    struct PluginInfo {
+        const char* name;
+        const char* version;
+        const char* const* dependencies;  // Names of plugins that must be initialized first
+        size_t dependencyCount;
+    };
+
+    // Frame hooks. IPlugin stays as it is for existing plugins; a plugin that wants per-frame calls
+    // also exports
+    //
+    //   extern "C" bool GetPluginHooks(std::uint32_t abiVersion, almond::plugin::IPlugin* plugin,
+    //                                  almond::plugin::PluginHooks* hooks);
+    //
+    // which is called once, right after CreatePlugin. It returns false if it was built for a different
+    // abiVersion, and the plugin is not loaded; otherwise it fills in the hooks it implements and
+    // leaves the rest null. The engine
+    // keeps the pointers in flat tables, so a frame costs one indirect call per hook. Everything
+    // here is plain C data so plugins need not share the engine's compiler or runtime.
+    inline constexpr std::uint32_t kPluginAbiVersion = 1;
+
+    enum PluginFlags : std::uint32_t {
+        kPluginThreadSafe = 1u << 0,  // Hooks may run on any worker, alongside other plugins' hooks
+    };
+
+    // Flat copy of an almond::Event; the string map is not passed across the boundary
+    struct PluginEvent {
+        std::uint32_t type;  // almond::EventType
+        float x;
+        float y;
+        std::int32_t key;
+        char text[2];
+    };
+
+    struct PluginHooks {
+        std::uint32_t flags;
+        void* context;  // Passed back to every hook; usually the plugin, as the type the hooks cast it back to
+        void (*update)(void* context, float deltaTime);
+        void (*fixedUpdate)(void* context, float fixedDeltaTime);
+        void (*onEvent)(void* context, const PluginEvent* event);
+    };
+
 } // namespace almond::plugin
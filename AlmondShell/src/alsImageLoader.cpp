@@ -1,12 +1,292 @@
 #include "alsImageLoader.h"
+#include "alsPixelKernels.h"
 
-#include <fstream>
+#include <algorithm>
+#include <array>
 #include <stdexcept>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
 
+#include <zlib.h>
+
 namespace almond {
 
+    namespace {
+        // Header fields sit at unaligned offsets, so they are assembled byte by byte
+        uint32_t ReadLE32(const uint8_t* p) {
+            return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        }
+
+        uint16_t ReadLE16(const uint8_t* p) {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        struct BmpInfo {
+            int width = 0;
+            int height = 0;          // Always positive; bottomUp carries the row order
+            int bitsPerPixel = 0;
+            bool bottomUp = true;
+            size_t pixelOffset = 0;
+            size_t stride = 0;       // Rows are padded to 4-byte boundaries
+        };
+
+        // Validates the headers and that the whole pixel array lies inside the file
+        BmpInfo ParseBMP(const uint8_t* data, size_t size, const std::filesystem::path& filepath) {
+            if (size < 54 || std::memcmp(data, "BM", 2) != 0) {
+                throw std::runtime_error("Invalid BMP file: " + filepath.string());
+            }
+
+            BmpInfo info;
+            info.pixelOffset = ReadLE32(data + 10);
+            const uint32_t headerSize = ReadLE32(data + 14);
+            info.width = static_cast<int32_t>(ReadLE32(data + 18));
+            info.height = static_cast<int32_t>(ReadLE32(data + 22));
+            info.bitsPerPixel = ReadLE16(data + 28);
+            const uint32_t compression = ReadLE32(data + 30);
+
+            if (info.bitsPerPixel != 24 && info.bitsPerPixel != 32) {
+                throw std::runtime_error("Unsupported BMP bit depth: " + filepath.string());
+            }
+
+            // BI_RGB, or BI_BITFIELDS when the masks describe plain BGRA
+            constexpr uint32_t kRGB = 0, kBitFields = 3;
+            if (compression == kBitFields && info.bitsPerPixel == 32) {
+                if (headerSize < 40 || size < 66 ||
+                    ReadLE32(data + 54) != 0x00FF0000u || ReadLE32(data + 58) != 0x0000FF00u || ReadLE32(data + 62) != 0x000000FFu) {
+                    throw std::runtime_error("Unsupported BMP channel masks: " + filepath.string());
+                }
+            }
+            else if (compression != kRGB) {
+                throw std::runtime_error("Unsupported BMP compression: " + filepath.string());
+            }
+
+            // Negative height marks a top-down bitmap
+            info.bottomUp = info.height > 0;
+            if (!info.bottomUp) info.height = -info.height;
+            if (info.width <= 0 || info.height <= 0) {
+                throw std::runtime_error("Invalid BMP dimensions: " + filepath.string());
+            }
+
+            info.stride = (static_cast<size_t>(info.width) * (info.bitsPerPixel / 8) + 3) & ~size_t(3);
+            if (info.pixelOffset > size || info.stride * info.height > size - info.pixelOffset) {
+                throw std::runtime_error("Truncated BMP file: " + filepath.string());
+            }
+            return info;
+        }
+
+        uint32_t ReadBE32(const uint8_t* p) {
+            return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+        }
+
+        struct PngInfo {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            int bitDepth = 0;
+            int colorType = 0;
+            int interlace = 0;
+            int samples = 0; // Samples per pixel
+
+            std::array<uint8_t, 256 * 4> palette{}; // RGBA, alpha from tRNS; unused entries stay transparent black
+            uint32_t paletteSize = 0;
+            bool hasColorKey = false;
+            uint16_t colorKey[3] = {}; // tRNS for grey / truecolor
+
+            size_t BitsPerPixel() const { return static_cast<size_t>(bitDepth) * samples; }
+            size_t RowBytes(uint32_t pixels) const { return (pixels * BitsPerPixel() + 7) / 8; }
+            size_t FilterStride() const { return (BitsPerPixel() + 7) / 8; } // Distance to the "left" byte
+        };
+
+        int PaethPredictor(int a, int b, int c) {
+            int p = a + b - c;
+            int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            if (pa <= pb && pa <= pc) return a;
+            return pb <= pc ? b : c;
+        }
+
+#if defined(ALMOND_PIXEL_SSE2)
+        // Pixel-at-a-time SIMD for the sequential filters: the dependency on the left pixel
+        // prevents wider vectors, but one register per pixel still beats byte loops.
+        __m128i LoadPixel(const uint8_t* p, size_t bpp) {
+            int value = 0;
+            std::memcpy(&value, p, bpp);
+            return _mm_cvtsi32_si128(value);
+        }
+
+        void StorePixel(uint8_t* p, __m128i v, size_t bpp) {
+            int value = _mm_cvtsi128_si32(v);
+            std::memcpy(p, &value, bpp);
+        }
+
+        __m128i Abs16(__m128i v) {
+            return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+        }
+
+        __m128i Select(__m128i mask, __m128i a, __m128i b) {
+            return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+        }
+
+        void UnfilterSub(uint8_t* row, size_t rowBytes, size_t bpp) {
+            __m128i a = _mm_setzero_si128();
+            for (size_t i = 0; i + bpp <= rowBytes; i += bpp) {
+                a = _mm_add_epi8(a, LoadPixel(row + i, bpp));
+                StorePixel(row + i, a, bpp);
+            }
+        }
+
+        void UnfilterAverage(uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp) {
+            const __m128i one = _mm_set1_epi8(1);
+            __m128i a = _mm_setzero_si128();
+            for (size_t i = 0; i + bpp <= rowBytes; i += bpp) {
+                __m128i b = LoadPixel(prior + i, bpp);
+                // avg_epu8 rounds up; subtract the carry to get floor((a + b) / 2)
+                __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+                a = _mm_add_epi8(LoadPixel(row + i, bpp), avg);
+                StorePixel(row + i, a, bpp);
+            }
+        }
+
+        void UnfilterPaeth(uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i a = zero, c = zero;
+            for (size_t i = 0; i + bpp <= rowBytes; i += bpp) {
+                __m128i b = _mm_unpacklo_epi8(LoadPixel(prior + i, bpp), zero);
+                __m128i x = LoadPixel(row + i, bpp);
+
+                __m128i pa = _mm_sub_epi16(b, c);  // |p - a|
+                __m128i pb = _mm_sub_epi16(a, c);  // |p - b|
+                __m128i pc = Abs16(_mm_add_epi16(pa, pb));
+                pa = Abs16(pa);
+                pb = Abs16(pb);
+
+                __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                __m128i predictor = Select(_mm_cmpeq_epi16(smallest, pa), a,
+                    Select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+                __m128i result = _mm_add_epi8(_mm_packus_epi16(predictor, predictor), x);
+                StorePixel(row + i, result, bpp);
+                a = _mm_unpacklo_epi8(result, zero);
+                c = b;
+            }
+        }
+#endif
+
+        void Unfilter(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp) {
+#if defined(ALMOND_PIXEL_SSE2)
+            const bool simd = (bpp == 3 || bpp == 4);
+#else
+            const bool simd = false;
+#endif
+            switch (filter) {
+            case 0: // None
+                break;
+            case 1: // Sub
+#if defined(ALMOND_PIXEL_SSE2)
+                if (simd) { UnfilterSub(row, rowBytes, bpp); break; }
+#endif
+                for (size_t i = bpp; i < rowBytes; ++i) row[i] = static_cast<uint8_t>(row[i] + row[i - bpp]);
+                break;
+            case 2: // Up
+                pixel::AddBytes(row, prior, rowBytes);
+                break;
+            case 3: // Average
+#if defined(ALMOND_PIXEL_SSE2)
+                if (simd) { UnfilterAverage(row, prior, rowBytes, bpp); break; }
+#endif
+                for (size_t i = 0; i < rowBytes; ++i) {
+                    int left = i >= bpp ? row[i - bpp] : 0;
+                    row[i] = static_cast<uint8_t>(row[i] + ((left + prior[i]) >> 1));
+                }
+                break;
+            case 4: // Paeth
+#if defined(ALMOND_PIXEL_SSE2)
+                if (simd) { UnfilterPaeth(row, prior, rowBytes, bpp); break; }
+#endif
+                for (size_t i = 0; i < rowBytes; ++i) {
+                    int left = i >= bpp ? row[i - bpp] : 0;
+                    int upLeft = i >= bpp ? prior[i - bpp] : 0;
+                    row[i] = static_cast<uint8_t>(row[i] + PaethPredictor(left, prior[i], upLeft));
+                }
+                break;
+            default:
+                throw std::runtime_error("Invalid PNG filter type.");
+            }
+        }
+
+        // Reads sample n of a packed row as a raw value (no scaling)
+        uint16_t ReadSample(const uint8_t* row, size_t n, int bitDepth) {
+            switch (bitDepth) {
+            case 16: return static_cast<uint16_t>((row[n * 2] << 8) | row[n * 2 + 1]);
+            case 8: return row[n];
+            default: {
+                size_t bit = n * bitDepth;
+                int shift = 8 - bitDepth - static_cast<int>(bit % 8);
+                return static_cast<uint16_t>((row[bit / 8] >> shift) & ((1 << bitDepth) - 1));
+            }
+            }
+        }
+
+        uint8_t ScaleTo8(uint16_t value, int bitDepth) {
+            switch (bitDepth) {
+            case 16: return static_cast<uint8_t>(value >> 8);
+            case 8: return static_cast<uint8_t>(value);
+            default: return static_cast<uint8_t>(value * 255 / ((1 << bitDepth) - 1));
+            }
+        }
+
+        // Converts one unfiltered row into RGBA8
+        void ConvertRow(const PngInfo& info, const uint8_t* row, uint32_t width, uint8_t* out) {
+            // Fast paths for the formats sprites actually use
+            if (info.bitDepth == 8 && !info.hasColorKey) {
+                if (info.colorType == 6) {
+                    std::memcpy(out, row, static_cast<size_t>(width) * 4);
+                    return;
+                }
+                if (info.colorType == 2) {
+                    pixel::ExpandRGBToRGBA(row, out, width);
+                    return;
+                }
+            }
+
+            for (uint32_t x = 0; x < width; ++x) {
+                uint8_t* px = out + static_cast<size_t>(x) * 4;
+                switch (info.colorType) {
+                case 0: { // Grey
+                    uint16_t g = ReadSample(row, x, info.bitDepth);
+                    px[0] = px[1] = px[2] = ScaleTo8(g, info.bitDepth);
+                    px[3] = (info.hasColorKey && g == info.colorKey[0]) ? 0 : 255;
+                    break;
+                }
+                case 2: { // RGB
+                    uint16_t r = ReadSample(row, x * 3, info.bitDepth);
+                    uint16_t g = ReadSample(row, x * 3 + 1, info.bitDepth);
+                    uint16_t b = ReadSample(row, x * 3 + 2, info.bitDepth);
+                    px[0] = ScaleTo8(r, info.bitDepth);
+                    px[1] = ScaleTo8(g, info.bitDepth);
+                    px[2] = ScaleTo8(b, info.bitDepth);
+                    px[3] = (info.hasColorKey && r == info.colorKey[0] && g == info.colorKey[1] && b == info.colorKey[2]) ? 0 : 255;
+                    break;
+                }
+                case 3: { // Palette
+                    std::memcpy(px, &info.palette[ReadSample(row, x, info.bitDepth) * 4], 4);
+                    break;
+                }
+                case 4: { // Grey + alpha
+                    px[0] = px[1] = px[2] = ScaleTo8(ReadSample(row, x * 2, info.bitDepth), info.bitDepth);
+                    px[3] = ScaleTo8(ReadSample(row, x * 2 + 1, info.bitDepth), info.bitDepth);
+                    break;
+                }
+                case 6: { // RGBA
+                    for (int c = 0; c < 4; ++c) {
+                        px[c] = ScaleTo8(ReadSample(row, x * 4 + c, info.bitDepth), info.bitDepth);
+                    }
+                    break;
+                }
+                }
+            }
+        }
+    }
+
     ImageLoader::ImageData ImageLoader::LoadAlmondImage(const std::filesystem::path& filepath) {
         if (filepath.extension() == ".bmp") {
             return LoadBMP(filepath);
@@ -19,65 +299,262 @@ namespace almond {
         }
     }
 
-    ImageLoader::ImageData ImageLoader::LoadBMP(const std::filesystem::path& filepath) {
-        std::ifstream file(filepath, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Failed to open BMP file: " + filepath.string());
-        }
+    ImageLoader::ImageView ImageLoader::MapAlmondImage(const std::filesystem::path& filepath) {
+        auto mapping = std::make_shared<const MappedFile>(filepath);
+        ImageView view;
 
-        // BMP Header
-        char header[54];
-        file.read(header, 54);
+        if (filepath.extension() == ".bmp") {
+            BmpInfo info = ParseBMP(mapping->data(), mapping->size(), filepath);
+            if (info.bitsPerPixel == 32) {
+                // Already 4 bytes per pixel with no row padding: GL reads it as BGRA in place
+                view.width = info.width;
+                view.height = info.height;
+                view.channels = 4;
+                view.rowStride = info.stride;
+                view.bottomUp = info.bottomUp;
+                view.order = PixelOrder::BGRA;
+                view.pixels = mapping->data() + info.pixelOffset;
+                view.mapping = std::move(mapping);
+                return view;
+            }
+        }
 
-        if (std::memcmp(header, "BM", 2) != 0) {
-            throw std::runtime_error("Invalid BMP file: " + filepath.string());
+        ImageData image;
+        if (filepath.extension() == ".bmp") {
+            image = DecodeBMP(mapping->data(), mapping->size(), filepath);
+        }
+        else if (filepath.extension() == ".png") {
+            image = DecodePNG(mapping->data(), mapping->size(), filepath);
+        }
+        else {
+            throw std::runtime_error("Unsupported file format: " + filepath.string());
         }
 
-        // Extract image dimensions
-        int width = *reinterpret_cast<int*>(&header[18]);
-        int height = *reinterpret_cast<int*>(&header[22]);
-        int bitsPerPixel = *reinterpret_cast<short*>(&header[28]);
+        view.width = image.width;
+        view.height = image.height;
+        view.channels = image.channels;
+        view.rowStride = static_cast<size_t>(image.width) * image.channels;
+        view.storage = std::move(image.pixels);
+        view.pixels = view.storage.data();
+        return view;
+    }
 
-        if (bitsPerPixel != 24 && bitsPerPixel != 32) {
-            throw std::runtime_error("Unsupported BMP bit depth: " + filepath.string());
+    void ImageLoader::SetRowOrder(ImageView& view, bool bottomUp) {
+        if (view.bottomUp == bottomUp || view.height < 2) {
+            view.bottomUp = bottomUp;
+            return;
         }
 
-        int channels = bitsPerPixel / 8;
+        if (view.IsMapped()) {
+            // The mapping is read-only, so the flip happens while copying it out
+            const size_t rowSize = static_cast<size_t>(view.width) * view.channels;
+            std::vector<uint8_t> flipped(rowSize * view.height);
+            for (int y = 0; y < view.height; ++y) {
+                std::memcpy(&flipped[rowSize * (view.height - 1 - y)], view.pixels + view.rowStride * y, rowSize);
+            }
+            view.storage = std::move(flipped);
+            view.pixels = view.storage.data();
+            view.rowStride = rowSize;
+            view.mapping.reset();
+        }
+        else {
+            pixel::FlipVertically(view.storage.data(), view.width, view.height, view.channels);
+        }
+        view.bottomUp = bottomUp;
+    }
 
-        // Calculate row padding (BMP files often pad rows to 4-byte boundaries)
-        int rowPadding = (4 - (width * channels) % 4) % 4;
+    ImageLoader::ImageData ImageLoader::LoadBMP(const std::filesystem::path& filepath) {
+        MappedFile file(filepath);
+        return DecodeBMP(file.data(), file.size(), filepath);
+    }
 
-        // Read pixel data
-        int dataSize = width * height * channels;
-        std::vector<uint8_t> pixels(dataSize);
-        file.seekg(*reinterpret_cast<int*>(&header[10])); // Pixel data offset
+    ImageLoader::ImageData ImageLoader::DecodeBMP(const uint8_t* data, size_t size, const std::filesystem::path& filepath) {
+        const BmpInfo info = ParseBMP(data, size, filepath);
+        const int width = info.width;
+        const int height = info.height;
+        const size_t rowSize = static_cast<size_t>(width) * (info.bitsPerPixel / 8);
 
-        // BMP stores pixels bottom-to-top; we must handle padding and flip the image
+        // Convert row by row straight from the mapping into top-down RGBA
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
         for (int y = 0; y < height; ++y) {
-            file.read(reinterpret_cast<char*>(&pixels[(height - y - 1) * width * channels]), width * channels);
-            file.ignore(rowPadding); // Skip padding at the end of the row
-        }
+            const uint8_t* src = data + info.pixelOffset + info.stride * y;
+            uint8_t* dst = &pixels[static_cast<size_t>(info.bottomUp ? height - y - 1 : y) * width * 4];
 
-        // If the image is 24-bit (RGB), add an alpha channel (fully opaque)
-        if (channels == 3) {
-            std::vector<uint8_t> rgbaData(width * height * 4);
-            for (int i = 0; i < width * height; ++i) {
-                rgbaData[i * 4 + 0] = pixels[i * 3 + 0]; // Red
-                rgbaData[i * 4 + 1] = pixels[i * 3 + 1]; // Green
-                rgbaData[i * 4 + 2] = pixels[i * 3 + 2]; // Blue
-                rgbaData[i * 4 + 3] = 255; // Alpha (fully opaque)
+            // BMP stores BGR(A)
+            if (info.bitsPerPixel == 24) {
+                pixel::ExpandRGBToRGBA(src, dst, width, true);
+            }
+            else {
+                std::memcpy(dst, src, rowSize);
             }
-            return { width, height, 4, rgbaData };
+        }
+        if (info.bitsPerPixel == 32) {
+            pixel::SwapRedBlue32(pixels.data(), static_cast<size_t>(width) * height);
         }
 
-        // If the image is 32-bit (RGBA), no modification is needed
-        return { width, height, 4, pixels };
+        return { width, height, 4, std::move(pixels) };
     }
 
     ImageLoader::ImageData ImageLoader::LoadPNG(const std::filesystem::path& filepath) {
-        // For simplicity, let's support PNG loading later
-        // PNG decoding requires parsing the format (chunks, filtering, etc.)
-        throw std::runtime_error("PNG loading not implemented yet.");
+        MappedFile file(filepath);
+        return DecodePNG(file.data(), file.size(), filepath);
+    }
+
+    ImageLoader::ImageData ImageLoader::DecodePNG(const uint8_t* file, size_t fileSize, const std::filesystem::path& filepath) {
+        static constexpr uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+        if (fileSize < 8 || std::memcmp(file, kSignature, 8) != 0) {
+            throw std::runtime_error("Invalid PNG file: " + filepath.string());
+        }
+
+        PngInfo info;
+        std::vector<uint8_t> compressed;
+        bool sawHeader = false;
+        bool sawEnd = false;
+
+        for (size_t offset = 8; offset + 12 <= fileSize && !sawEnd;) {
+            const uint32_t length = ReadBE32(&file[offset]);
+            const uint8_t* type = &file[offset + 4];
+            const uint8_t* data = &file[offset + 8];
+            if (length > fileSize - offset - 12) {
+                throw std::runtime_error("Truncated PNG chunk: " + filepath.string());
+            }
+
+            if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+                info.width = ReadBE32(data);
+                info.height = ReadBE32(data + 4);
+                info.bitDepth = data[8];
+                info.colorType = data[9];
+                info.interlace = data[12];
+                sawHeader = true;
+            }
+            else if (std::memcmp(type, "PLTE", 4) == 0) {
+                info.paletteSize = std::min<uint32_t>(length / 3, 256);
+                for (uint32_t i = 0; i < info.paletteSize; ++i) {
+                    info.palette[i * 4 + 0] = data[i * 3 + 0];
+                    info.palette[i * 4 + 1] = data[i * 3 + 1];
+                    info.palette[i * 4 + 2] = data[i * 3 + 2];
+                    info.palette[i * 4 + 3] = 255;
+                }
+            }
+            else if (std::memcmp(type, "tRNS", 4) == 0) {
+                if (info.colorType == 3) {
+                    for (uint32_t i = 0; i < length && i < info.paletteSize; ++i) info.palette[i * 4 + 3] = data[i];
+                }
+                else if (info.colorType == 0 && length >= 2) {
+                    info.colorKey[0] = static_cast<uint16_t>((data[0] << 8) | data[1]);
+                    info.hasColorKey = true;
+                }
+                else if (info.colorType == 2 && length >= 6) {
+                    for (int c = 0; c < 3; ++c) info.colorKey[c] = static_cast<uint16_t>((data[c * 2] << 8) | data[c * 2 + 1]);
+                    info.hasColorKey = true;
+                }
+            }
+            else if (std::memcmp(type, "IDAT", 4) == 0) {
+                compressed.insert(compressed.end(), data, data + length);
+            }
+            else if (std::memcmp(type, "IEND", 4) == 0) {
+                sawEnd = true;
+            }
+
+            offset += 12 + static_cast<size_t>(length);
+        }
+
+        // Samples per pixel, and the bit depths the PNG spec allows for each colour type. Palette
+        // indices are at most 8 bits, so they always land inside the 256-entry palette.
+        bool validDepth = false;
+        switch (info.colorType) {
+        case 0:
+            info.samples = 1;
+            validDepth = info.bitDepth == 1 || info.bitDepth == 2 || info.bitDepth == 4 || info.bitDepth == 8 || info.bitDepth == 16;
+            break;
+        case 3:
+            info.samples = 1;
+            validDepth = info.bitDepth == 1 || info.bitDepth == 2 || info.bitDepth == 4 || info.bitDepth == 8;
+            break;
+        case 2: info.samples = 3; validDepth = info.bitDepth == 8 || info.bitDepth == 16; break;
+        case 4: info.samples = 2; validDepth = info.bitDepth == 8 || info.bitDepth == 16; break;
+        case 6: info.samples = 4; validDepth = info.bitDepth == 8 || info.bitDepth == 16; break;
+        default: info.samples = 0; break;
+        }
+
+        if (!sawHeader || !validDepth || info.width == 0 || info.height == 0 || info.interlace > 1) {
+            throw std::runtime_error("Unsupported PNG format: " + filepath.string());
+        }
+
+        // Adam7 passes: (x start, y start, x step, y step); a single full pass when not interlaced
+        struct Pass { uint32_t x0, y0, dx, dy; };
+        static constexpr Pass kAdam7[7] = { {0,0,8,8}, {4,0,8,8}, {0,4,4,8}, {2,0,4,4}, {0,2,2,4}, {1,0,2,2}, {0,1,1,2} };
+        static constexpr Pass kSinglePass[1] = { {0,0,1,1} };
+        const Pass* passes = info.interlace ? kAdam7 : kSinglePass;
+        const int passCount = info.interlace ? 7 : 1;
+
+        auto passWidth = [&](const Pass& p) { return info.width > p.x0 ? (info.width - p.x0 + p.dx - 1) / p.dx : 0; };
+        auto passHeight = [&](const Pass& p) { return info.height > p.y0 ? (info.height - p.y0 + p.dy - 1) / p.dy : 0; };
+
+        size_t rawSize = 0;
+        for (int i = 0; i < passCount; ++i) {
+            uint32_t w = passWidth(passes[i]), h = passHeight(passes[i]);
+            if (w && h) rawSize += static_cast<size_t>(h) * (1 + info.RowBytes(w));
+        }
+
+        // Inflate straight into a buffer of the exact decoded size
+        std::vector<uint8_t> raw(rawSize);
+        z_stream stream{};
+        if (inflateInit(&stream) != Z_OK) {
+            throw std::runtime_error("Failed to initialize inflate for PNG: " + filepath.string());
+        }
+        stream.next_in = compressed.data();
+        stream.avail_in = static_cast<uInt>(compressed.size());
+        stream.next_out = raw.data();
+        stream.avail_out = static_cast<uInt>(raw.size());
+        int status = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        if ((status != Z_STREAM_END && status != Z_BUF_ERROR) || stream.avail_out != 0) {
+            throw std::runtime_error("Corrupt PNG image data: " + filepath.string());
+        }
+
+        ImageData image;
+        image.width = static_cast<int>(info.width);
+        image.height = static_cast<int>(info.height);
+        image.channels = 4;
+        image.pixels.resize(static_cast<size_t>(info.width) * info.height * 4);
+
+        const size_t bpp = info.FilterStride();
+        std::vector<uint8_t> zeroRow(info.RowBytes(info.width), 0);
+        std::vector<uint8_t> converted(static_cast<size_t>(info.width) * 4);
+        uint8_t* cursor = raw.data();
+
+        for (int i = 0; i < passCount; ++i) {
+            const Pass& pass = passes[i];
+            const uint32_t w = passWidth(pass), h = passHeight(pass);
+            if (!w || !h) continue;
+
+            const size_t rowBytes = info.RowBytes(w);
+            const uint8_t* prior = zeroRow.data();
+
+            for (uint32_t y = 0; y < h; ++y) {
+                uint8_t filter = cursor[0];
+                uint8_t* row = cursor + 1;
+                Unfilter(filter, row, prior, rowBytes, bpp);
+
+                const uint32_t dstY = pass.y0 + y * pass.dy;
+                if (!info.interlace) {
+                    ConvertRow(info, row, w, &image.pixels[static_cast<size_t>(dstY) * info.width * 4]);
+                }
+                else {
+                    ConvertRow(info, row, w, converted.data());
+                    for (uint32_t x = 0; x < w; ++x) {
+                        std::memcpy(&image.pixels[(static_cast<size_t>(dstY) * info.width + pass.x0 + x * pass.dx) * 4], &converted[x * 4], 4);
+                    }
+                }
+
+                prior = row;
+                cursor += 1 + rowBytes;
+            }
+        }
+
+        return image;
     }
 
 } // namespace almond
@@ -3,9 +3,12 @@
 //#include "alsExports_DLL.h"
 
 //#include <string>
+#include "alsMappedFile.h"
+
 #include <vector>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 
 namespace almond {
 
@@ -19,13 +22,47 @@ namespace almond {
             std::vector<uint8_t> pixels; // Pixel data in row-major order (empty by default)
         };
 
+        enum class PixelOrder { RGBA, BGRA };
+
+        // Pixels that either point straight into a memory-mapped file (when the file's layout can
+        // be uploaded as is) or into storage decoded from it. Move-only: pixels may point into storage.
+        struct ImageView {
+            int width = 0;
+            int height = 0;
+            int channels = 0;
+            size_t rowStride = 0;          // Bytes from one row to the next
+            bool bottomUp = false;         // First row is the bottom of the image, as GL expects
+            PixelOrder order = PixelOrder::RGBA;
+            const uint8_t* pixels = nullptr;
+            std::shared_ptr<const MappedFile> mapping; // Keeps mapped pixels valid
+            std::vector<uint8_t> storage;              // Owned pixels when the file had to be decoded
+
+            ImageView() = default;
+            ImageView(ImageView&&) = default;
+            ImageView& operator=(ImageView&&) = default;
+            ImageView(const ImageView&) = delete;
+            ImageView& operator=(const ImageView&) = delete;
+
+            bool IsMapped() const { return pixels && storage.empty(); }
+            size_t SizeBytes() const { return rowStride * height; }
+        };
+
         // Loads an image from file and returns its data
         static ImageData LoadAlmondImage(const std::filesystem::path& filepath);
 
+        // Maps the file and returns a view of it without copying when the pixel layout allows
+        // (32-bit BGRA bitmaps); other files are decoded from the mapping into the view's storage
+        static ImageView MapAlmondImage(const std::filesystem::path& filepath);
+
+        // Puts the view's rows in the requested order, copying out of the mapping only if needed
+        static void SetRowOrder(ImageView& view, bool bottomUp);
+
     private:
         // Helper methods for specific formats
         static ImageData LoadBMP(const std::filesystem::path& filepath);
         static ImageData LoadPNG(const std::filesystem::path& filepath);
+        static ImageData DecodeBMP(const uint8_t* data, size_t size, const std::filesystem::path& filepath);
+        static ImageData DecodePNG(const uint8_t* data, size_t size, const std::filesystem::path& filepath);
 
         // Add support for other formats as needed
     };
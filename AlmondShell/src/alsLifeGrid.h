@@ -0,0 +1,204 @@
+#pragma once
+
+#include "alsProfiler.h"
+#include "alsThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#define ALMOND_LIFE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace almond {
+namespace life {
+
+    // Next state of one word from its 3x3 neighbourhood of words. Each neighbour direction is a
+    // bit plane; the planes are summed with full/half adders into a count per bit lane:
+    //   alive next = (count == 3) | (alive & count == 2)
+    inline std::uint64_t StepWord(std::uint64_t aboveLeft, std::uint64_t above, std::uint64_t aboveRight,
+        std::uint64_t left, std::uint64_t centre, std::uint64_t right,
+        std::uint64_t belowLeft, std::uint64_t below, std::uint64_t belowRight) {
+        // West/east neighbour planes: cell x looks at x - 1 / x + 1, carrying across words
+        const std::uint64_t aw = (above << 1) | (aboveLeft >> 63), ae = (above >> 1) | (aboveRight << 63);
+        const std::uint64_t cw = (centre << 1) | (left >> 63), ce = (centre >> 1) | (right << 63);
+        const std::uint64_t bw = (below << 1) | (belowLeft >> 63), be = (below >> 1) | (belowRight << 63);
+
+        // Column sums per row (0..3 above and below, 0..2 beside)
+        const std::uint64_t a0 = aw ^ above ^ ae, a1 = (aw & above) | (ae & (aw ^ above));
+        const std::uint64_t b0 = bw ^ below ^ be, b1 = (bw & below) | (be & (bw ^ below));
+        const std::uint64_t c0 = cw ^ ce, c1 = cw & ce;
+
+        // count = ones + 2 * (a1 + b1 + c1 + carry); 3 or 2 means the twos total is exactly 1
+        const std::uint64_t ones = a0 ^ b0 ^ c0, carry = (a0 & b0) | (c0 & (a0 ^ b0));
+        const std::uint64_t twos0 = a1 ^ b1 ^ c1, twos1 = (a1 & b1) | (c1 & (a1 ^ b1));
+        return ~twos1 & (twos0 ^ carry) & (ones | centre);
+    }
+
+} // namespace life
+
+    // Conway's Game of Life on a bit-packed grid: 64 cells per word, neighbour counts computed for
+    // a whole word at once with bit-parallel adders (four words at a time with AVX2). Cells outside
+    // the grid are dead. Two buffers are swapped each step, so stepping never allocates, and row
+    // bands are spread across a ThreadPool when one is given.
+    //
+    // Each row carries a zero guard word on both sides and the grid has a zero guard row above and
+    // below, so the kernel reads neighbours without any bounds checks.
+    class LifeGrid {
+    public:
+        LifeGrid(int width, int height)
+            : width(std::max(1, width)), height(std::max(1, height)),
+            wordsPerRow((this->width + 63) / 64), stride(wordsPerRow + 2),
+            lastWordMask(this->width % 64 == 0 ? ~0ull : (1ull << (this->width % 64)) - 1),
+            current(static_cast<size_t>(stride) * (this->height + 2), 0),
+            next(current.size(), 0) {
+        }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        int getWordsPerRow() const { return wordsPerRow; }
+
+        // Bit (x % 64) of word (x / 64) is the cell at x; bits past the width are always zero
+        const std::uint64_t* row(int y) const { return &current[RowOffset(y)]; }
+
+        // Calls fn(x, y) for every live cell, row by row
+        template <typename Fn>
+        void forEachLiveCell(Fn&& fn) const {
+            for (int y = 0; y < height; ++y) {
+                const std::uint64_t* words = row(y);
+                for (int w = 0; w < wordsPerRow; ++w) {
+                    for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                        fn(w * 64 + std::countr_zero(bits), y);
+                    }
+                }
+            }
+        }
+
+        bool get(int x, int y) const {
+            if (x < 0 || x >= width || y < 0 || y >= height) return false;
+            return (row(y)[x >> 6] >> (x & 63)) & 1;
+        }
+
+        void set(int x, int y, bool alive) {
+            if (x < 0 || x >= width || y < 0 || y >= height) return;
+            std::uint64_t& word = current[RowOffset(y) + (x >> 6)];
+            const std::uint64_t bit = 1ull << (x & 63);
+            word = alive ? (word | bit) : (word & ~bit);
+        }
+
+        void clear() {
+            std::fill(current.begin(), current.end(), 0);
+        }
+
+        // Roughly half the cells alive, filled a word at a time from a xorshift generator
+        void randomize(std::uint64_t seed) {
+            std::uint64_t state = seed ? seed : 0x9E3779B97F4A7C15ull;
+            for (int y = 0; y < height; ++y) {
+                std::uint64_t* words = &current[RowOffset(y)];
+                for (int w = 0; w < wordsPerRow; ++w) {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    words[w] = state;
+                }
+                words[wordsPerRow - 1] &= lastWordMask;
+            }
+        }
+
+        size_t population() const {
+            size_t count = 0;
+            for (int y = 0; y < height; ++y) {
+                const std::uint64_t* words = row(y);
+                for (int w = 0; w < wordsPerRow; ++w) {
+                    count += static_cast<size_t>(std::popcount(words[w]));
+                }
+            }
+            return count;
+        }
+
+        // Advances one generation. Rows are split into bands of at least minBandRows so each job has
+        // enough work to be worth scheduling.
+        void step(ThreadPool* pool = nullptr, int minBandRows = 64) {
+            ALMOND_PROFILE_SCOPE("LifeGrid::step");
+            if (!pool || pool->size() == 0 || height <= minBandRows) {
+                StepRows(0, height);
+            }
+            else {
+                const int targetBands = static_cast<int>(pool->size() + 1) * 4;
+                const int bandRows = std::max(minBandRows, (height + targetBands - 1) / targetBands);
+                const int bands = (height + bandRows - 1) / bandRows;
+                pool->parallelFor(static_cast<size_t>(bands), [this, bandRows](size_t band) {
+                    const int begin = static_cast<int>(band) * bandRows;
+                    StepRows(begin, std::min(height, begin + bandRows));
+                });
+            }
+            current.swap(next);
+        }
+
+    private:
+        int width;
+        int height;
+        int wordsPerRow;
+        int stride;
+        std::uint64_t lastWordMask;
+        std::vector<std::uint64_t> current;
+        std::vector<std::uint64_t> next;
+
+        // Offset of the first real word of row y (skipping the guard row and the left guard word)
+        size_t RowOffset(int y) const {
+            return static_cast<size_t>(y + 1) * stride + 1;
+        }
+
+        void StepRows(int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                const size_t offset = RowOffset(y);
+                StepRow(&current[offset - stride], &current[offset], &current[offset + stride], &next[offset]);
+                next[offset + wordsPerRow - 1] &= lastWordMask;
+            }
+        }
+
+#if defined(ALMOND_LIFE_AVX2)
+        static __m256i StepWords(const std::uint64_t* a, const std::uint64_t* c, const std::uint64_t* b) {
+            auto load = [](const std::uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); };
+            auto west = [](__m256i word, __m256i prev) { return _mm256_or_si256(_mm256_slli_epi64(word, 1), _mm256_srli_epi64(prev, 63)); };
+            auto east = [](__m256i word, __m256i nextWord) { return _mm256_or_si256(_mm256_srli_epi64(word, 1), _mm256_slli_epi64(nextWord, 63)); };
+            auto majority = [](__m256i x, __m256i y, __m256i z) {
+                return _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_xor_si256(x, y)));
+            };
+
+            const __m256i above = load(a), centre = load(c), below = load(b);
+            const __m256i aw = west(above, load(a - 1)), ae = east(above, load(a + 1));
+            const __m256i cw = west(centre, load(c - 1)), ce = east(centre, load(c + 1));
+            const __m256i bw = west(below, load(b - 1)), be = east(below, load(b + 1));
+
+            const __m256i a0 = _mm256_xor_si256(_mm256_xor_si256(aw, above), ae), a1 = majority(aw, above, ae);
+            const __m256i b0 = _mm256_xor_si256(_mm256_xor_si256(bw, below), be), b1 = majority(bw, below, be);
+            const __m256i c0 = _mm256_xor_si256(cw, ce), c1 = _mm256_and_si256(cw, ce);
+
+            const __m256i ones = _mm256_xor_si256(_mm256_xor_si256(a0, b0), c0), carry = majority(a0, b0, c0);
+            const __m256i twos0 = _mm256_xor_si256(_mm256_xor_si256(a1, b1), c1), twos1 = majority(a1, b1, c1);
+            return _mm256_andnot_si256(twos1, _mm256_and_si256(_mm256_xor_si256(twos0, carry), _mm256_or_si256(ones, centre)));
+        }
+#endif
+
+        // Guard words make [-1] and [wordsPerRow] valid reads for every row
+        void StepRow(const std::uint64_t* above, const std::uint64_t* centre, const std::uint64_t* below, std::uint64_t* out) const {
+            int w = 0;
+#if defined(ALMOND_LIFE_AVX2)
+            for (; w + 4 <= wordsPerRow; w += 4) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + w), StepWords(above + w, centre + w, below + w));
+            }
+#endif
+            for (; w < wordsPerRow; ++w) {
+                out[w] = life::StepWord(above[w - 1], above[w], above[w + 1],
+                    centre[w - 1], centre[w], centre[w + 1],
+                    below[w - 1], below[w], below[w + 1]);
+            }
+        }
+    };
+
+} // namespace almond
@@ -78,8 +78,8 @@ namespace almond {
                         event.key = std::stoi(value);
                     }
                     else if (key == "text") {
-                        strncpy_s(event.text, value.c_str(), sizeof(event.text) - 1);
-                        event.text[sizeof(event.text) - 1] = '\0';
+                        const size_t length = value.copy(event.text, sizeof(event.text) - 1);
+                        event.text[length] = '\0';
                     }
                     else {
                         event.data[key] = value;
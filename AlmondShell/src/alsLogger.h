@@ -1,12 +1,12 @@
 #pragma once
 
+#include "alsMemoryTracker.h"
 #include "alsRobustTime.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <mutex>
 #include <stdexcept>
-#include <format>
 #include <chrono>
 #include <filesystem>
 
@@ -49,6 +49,7 @@ namespace almond {
         }
 
         void log(const std::string& message, LogLevel level = LogLevel::INFO) {
+            ALMOND_MEMORY_TAG(Logging);
             std::lock_guard<std::mutex> lock(mutex);
 
             // Only log messages that meet or exceed the current log level
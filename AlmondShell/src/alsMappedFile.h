@@ -0,0 +1,129 @@
+#pragma once
+
+#ifdef _WIN32
+#include "framework.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+namespace almond {
+
+    // Read-only mapping of a whole file. Nothing is copied up front: pages are faulted in from the
+    // page cache as the decoder (or the driver, during an upload) touches them.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(const std::filesystem::path& filepath) {
+#ifdef _WIN32
+            HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                throw std::runtime_error("Failed to open file: " + filepath.string());
+            }
+
+            LARGE_INTEGER fileSize{};
+            if (!GetFileSizeEx(file, &fileSize)) {
+                CloseHandle(file);
+                throw std::runtime_error("Failed to query file size: " + filepath.string());
+            }
+            length = static_cast<size_t>(fileSize.QuadPart);
+
+            if (length > 0) {
+                // The view keeps the mapping object alive, so neither handle is needed afterwards
+                HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping) {
+                    bytes = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    CloseHandle(mapping);
+                }
+            }
+            CloseHandle(file);
+#else
+            int fd = open(filepath.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Failed to open file: " + filepath.string());
+            }
+
+            struct stat info {};
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                throw std::runtime_error("Failed to query file size: " + filepath.string());
+            }
+            length = static_cast<size_t>(info.st_size);
+
+            if (length > 0) {
+                void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (view != MAP_FAILED) {
+                    bytes = static_cast<const std::uint8_t*>(view);
+                    madvise(view, length, MADV_SEQUENTIAL);
+                }
+            }
+            close(fd);
+#endif
+            if (length > 0 && !bytes) {
+                length = 0;
+                throw std::runtime_error("Failed to map file: " + filepath.string());
+            }
+        }
+
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+            : bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)) {}
+
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                Close();
+                bytes = std::exchange(other.bytes, nullptr);
+                length = std::exchange(other.length, 0);
+            }
+            return *this;
+        }
+
+        const std::uint8_t* data() const { return bytes; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+
+        // Touches every page in [offset, offset + count) so later reads do not block on disk.
+        // Worth calling from a worker before handing a mapped range to the GL thread.
+        void Prefetch(size_t offset, size_t count) const {
+            if (offset >= length) return;
+            count = (count < length - offset) ? count : length - offset;
+            volatile std::uint8_t sink = 0;
+            for (size_t i = 0; i < count; i += 4096) {
+                sink = sink ^ bytes[offset + i];
+            }
+            if (count > 0) {
+                sink = sink ^ bytes[offset + count - 1];
+            }
+        }
+
+    private:
+        const std::uint8_t* bytes = nullptr;
+        size_t length = 0;
+
+        void Close() {
+            if (!bytes) return;
+#ifdef _WIN32
+            UnmapViewOfFile(bytes);
+#else
+            munmap(const_cast<std::uint8_t*>(bytes), length);
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+    };
+
+} // namespace almond
@@ -0,0 +1,98 @@
+#include "alsMemoryTracker.h"
+
+#if defined(ALMOND_MEMORY_TRACKING)
+
+#include <cstdlib>
+#include <new>
+
+// Replacement global allocation functions. Every block is preceded by a header recording its size,
+// its tag and how far it sits from what malloc returned, so delete can credit the right tag and
+// over-aligned blocks can be handed back. Linking this file into a program replaces operator new
+// for the whole program, plugins included where the platform shares one heap.
+
+namespace {
+
+    using almond::memory::Tag;
+    using almond::memory::Tracker;
+
+    struct alignas(16) Header {
+        std::size_t size;
+        std::uint32_t offset;  // From the start of the malloc block to the user pointer
+        Tag tag;
+    };
+    static_assert(sizeof(Header) == 16, "The header must keep default-aligned blocks aligned");
+
+    constexpr std::size_t kDefaultAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    void* TryAllocate(std::size_t size, std::size_t alignment) noexcept {
+        // Default-aligned blocks sit straight after the header; over-aligned ones need slack to
+        // slide forward into
+        const std::size_t slack = alignment > kDefaultAlignment ? alignment : 0;
+        if (size > SIZE_MAX - sizeof(Header) - slack) return nullptr;
+
+        auto* raw = static_cast<unsigned char*>(std::malloc(sizeof(Header) + slack + size));
+        if (!raw) return nullptr;
+
+        auto address = reinterpret_cast<std::uintptr_t>(raw) + sizeof(Header);
+        if (slack) address = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+        auto* user = reinterpret_cast<unsigned char*>(address);
+
+        const Tag tag = Tracker::CurrentTag();
+        Header* header = reinterpret_cast<Header*>(user) - 1;
+        header->size = size;
+        header->offset = static_cast<std::uint32_t>(user - raw);
+        header->tag = tag;
+        Tracker::Get().Allocated(tag, size);
+        return user;
+    }
+
+    void* Allocate(std::size_t size, std::size_t alignment) {
+        for (;;) {
+            if (void* block = TryAllocate(size, alignment)) return block;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* AllocateNoThrow(std::size_t size, std::size_t alignment) noexcept {
+        try {
+            return Allocate(size, alignment);
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+    void Deallocate(void* block) noexcept {
+        if (!block) return;
+        const Header* header = static_cast<const Header*>(block) - 1;
+        Tracker::Get().Freed(header->tag, header->size);
+        std::free(static_cast<unsigned char*>(block) - header->offset);
+    }
+
+} // namespace
+
+void* operator new(std::size_t size) { return Allocate(size, kDefaultAlignment); }
+void* operator new[](std::size_t size) { return Allocate(size, kDefaultAlignment); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, kDefaultAlignment); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, kDefaultAlignment); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return Allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return Allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateNoThrow(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* block) noexcept { Deallocate(block); }
+void operator delete[](void* block) noexcept { Deallocate(block); }
+void operator delete(void* block, std::size_t) noexcept { Deallocate(block); }
+void operator delete[](void* block, std::size_t) noexcept { Deallocate(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { Deallocate(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { Deallocate(block); }
+void operator delete(void* block, std::align_val_t) noexcept { Deallocate(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { Deallocate(block); }
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept { Deallocate(block); }
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept { Deallocate(block); }
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept { Deallocate(block); }
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept { Deallocate(block); }
+
+#endif
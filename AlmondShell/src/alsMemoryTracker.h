@@ -0,0 +1,358 @@
+#pragma once
+
+#include "alsMetrics.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Memory tracking by subsystem. Heap allocations are charged to the tag of the innermost
+// ALMOND_MEMORY_TAG scope on the allocating thread (Untagged outside any scope) and credited back
+// to the same tag when freed, whichever thread frees them. Per tag the tracker keeps live bytes, the
+// high-water mark, live and total allocation counts and an optional budget that warns on stderr
+// when exceeded.
+//
+// The macros below compile to nothing unless ALMOND_MEMORY_TRACKING is defined (CMake option
+// ALMOND_MEMORY_TRACKING). When compiled in, alsMemoryTracker.cpp replaces the global operator
+// new and delete: each block carries a 16-byte header with its size and tag, and an allocation
+// costs a few relaxed atomic adds on top of malloc.
+//
+//   ALMOND_MEMORY_TAG(Snapshots);  // Charges the enclosing block's heap allocations to snapshots
+//   ALMOND_MEMORY_STARTUP();       // Reads budgets from ALMOND_MEMORY_BUDGETS, reports leaks at exit
+//   ALMOND_MEMORY_PUBLISH();       // Copies every tag into memory.<tag>.bytes / .peak gauges
+//
+// Memory the heap never sees, such as GPU storage, is charged explicitly with TrackedBytes.
+
+namespace almond::memory {
+
+    enum class Tag : std::uint8_t {
+        Untagged,
+        Renderer,    // CPU-side renderer state: meshes, atlases' bookkeeping, text batches, streaming
+        Gpu,         // Texture storage on the GPU, charged through TrackedBytes
+        ECS,
+        Snapshots,
+        Logging,
+        Plugins,
+        Allocators,  // Pool slabs and frame arena blocks; kept for the life of the process by design
+        Count
+    };
+
+    inline constexpr size_t kTagCount = static_cast<size_t>(Tag::Count);
+
+    constexpr std::string_view TagName(Tag tag) {
+        switch (tag) {
+        case Tag::Untagged: return "untagged";
+        case Tag::Renderer: return "renderer";
+        case Tag::Gpu: return "gpu";
+        case Tag::ECS: return "ecs";
+        case Tag::Snapshots: return "snapshots";
+        case Tag::Logging: return "logging";
+        case Tag::Plugins: return "plugins";
+        case Tag::Allocators: return "allocators";
+        case Tag::Count: break;
+        }
+        return "unknown";
+    }
+
+    struct TagStats {
+        std::int64_t bytes = 0;
+        std::int64_t peak = 0;
+        std::int64_t liveAllocations = 0;
+        std::int64_t totalAllocations = 0;
+        std::uint64_t budget = 0;  // 0 when unlimited
+    };
+
+    namespace detail {
+        inline thread_local Tag currentTag = Tag::Untagged;
+    }
+
+    // Called from operator new and delete, so nothing here may allocate; warnings go through
+    // fprintf rather than iostreams for the same reason. Constant-initialized and trivially
+    // destructible, so it is usable before main and by blocks freed during static destruction.
+    class Tracker {
+    public:
+        static Tracker& Get() {
+            static Tracker instance;
+            return instance;
+        }
+
+        static Tag CurrentTag() { return detail::currentTag; }
+
+        void Allocated(Tag tag, size_t size) {
+            Entry& entry = entries[Index(tag)];
+            const std::int64_t bytes = entry.bytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed) + static_cast<std::int64_t>(size);
+            entry.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+            entry.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+            std::int64_t peak = entry.peak.load(std::memory_order_relaxed);
+            while (bytes > peak && !entry.peak.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {}
+
+            const std::uint64_t budget = entry.budget.load(std::memory_order_relaxed);
+            if (budget != 0 && static_cast<std::uint64_t>(bytes) > budget && !entry.overBudget.exchange(true, std::memory_order_relaxed)) {
+                std::fprintf(stderr, "Memory budget exceeded: %s is using %lld bytes of %llu\n",
+                    TagName(tag).data(), static_cast<long long>(bytes), static_cast<unsigned long long>(budget));
+            }
+        }
+
+        void Freed(Tag tag, size_t size) {
+            Entry& entry = entries[Index(tag)];
+            const std::int64_t bytes = entry.bytes.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed) - static_cast<std::int64_t>(size);
+            entry.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+            // Re-arm the warning once usage has fallen well back under budget, so hovering at the
+            // limit does not flood the log
+            const std::uint64_t budget = entry.budget.load(std::memory_order_relaxed);
+            if (budget != 0 && bytes >= 0 && static_cast<std::uint64_t>(bytes) < budget - budget / 8) {
+                entry.overBudget.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // For sub-allocators: size bytes of memory already charged to owner (a pool slab) are handed
+        // to the tag that will use them, which is charged as for a heap allocation, and handed back
+        // later. owner keeps only what is not lent out.
+        void Lent(Tag owner, Tag user, size_t size) {
+            entries[Index(owner)].bytes.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+            Allocated(user, size);
+        }
+
+        void Returned(Tag owner, Tag user, size_t size) {
+            Freed(user, size);
+            entries[Index(owner)].bytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+        }
+
+        // 0 removes the budget
+        void SetBudget(Tag tag, std::uint64_t bytes) {
+            entries[Index(tag)].budget.store(bytes, std::memory_order_relaxed);
+        }
+
+        // "renderer=512M,snapshots=256M,gpu=2G"; sizes take an optional K, M or G suffix. Unknown
+        // tags and malformed entries are reported and skipped.
+        void LoadBudgets(std::string_view spec) {
+            while (!spec.empty()) {
+                const size_t comma = spec.find(',');
+                const std::string_view item = spec.substr(0, comma);
+                spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+                if (item.empty()) continue;
+
+                const size_t equals = item.find('=');
+                Tag tag = Tag::Count;
+                std::uint64_t bytes = 0;
+                if (equals == std::string_view::npos || !ParseTag(item.substr(0, equals), tag) || !ParseSize(item.substr(equals + 1), bytes)) {
+                    std::fprintf(stderr, "Ignoring memory budget '%.*s'\n", static_cast<int>(item.size()), item.data());
+                    continue;
+                }
+                SetBudget(tag, bytes);
+            }
+        }
+
+        TagStats Stats(Tag tag) const {
+            const Entry& entry = entries[Index(tag)];
+            TagStats stats;
+            stats.bytes = entry.bytes.load(std::memory_order_relaxed);
+            stats.peak = entry.peak.load(std::memory_order_relaxed);
+            stats.liveAllocations = entry.liveAllocations.load(std::memory_order_relaxed);
+            stats.totalAllocations = entry.totalAllocations.load(std::memory_order_relaxed);
+            stats.budget = entry.budget.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        // Budgets from the environment, and a leak report once static destructors have run. Call
+        // early in startup: the report is registered with atexit, so it only runs after objects
+        // constructed later than this call have been destroyed.
+        void Startup() {
+            if (const char* budgets = std::getenv("ALMOND_MEMORY_BUDGETS")) LoadBudgets(budgets);
+            if (!leakReportInstalled.exchange(true)) {
+                std::atexit([] { Tracker::Get().ReportLeaks(stderr); });
+            }
+        }
+
+        // Sets memory.<tag>.bytes and memory.<tag>.peak, so MetricsReporter dumps show which
+        // subsystem grew over a long run
+        void Publish() {
+            for (size_t i = 0; i < kTagCount; ++i) {
+                if (!gauges[i].bytes) {
+                    const std::string prefix = "memory." + std::string(TagName(static_cast<Tag>(i)));
+                    gauges[i].bytes = &metrics::Registry::Get().GetGauge(prefix + ".bytes");
+                    gauges[i].peak = &metrics::Registry::Get().GetGauge(prefix + ".peak");
+                }
+                const TagStats stats = Stats(static_cast<Tag>(i));
+                gauges[i].bytes->Set(static_cast<double>(stats.bytes));
+                gauges[i].peak->Set(static_cast<double>(stats.peak));
+            }
+        }
+
+        void Report(std::ostream& out) const {
+            out << std::left << std::setw(12) << "tag" << std::right << std::setw(16) << "bytes" << std::setw(16) << "peak"
+                << std::setw(12) << "live" << std::setw(14) << "total" << std::setw(16) << "budget" << "\n";
+            for (size_t i = 0; i < kTagCount; ++i) {
+                const TagStats stats = Stats(static_cast<Tag>(i));
+                out << std::left << std::setw(12) << TagName(static_cast<Tag>(i)) << std::right
+                    << std::setw(16) << stats.bytes << std::setw(16) << stats.peak
+                    << std::setw(12) << stats.liveAllocations << std::setw(14) << stats.totalAllocations
+                    << std::setw(16) << (stats.budget ? std::to_string(stats.budget) : std::string("-")) << "\n";
+            }
+        }
+
+        // Lists every tag that still holds memory; returns whether any did. Untagged memory (the
+        // runtime's own statics) and allocator slabs are expected to outlive main and are listed
+        // separately rather than counted as leaks.
+        bool ReportLeaks(std::FILE* out) const {
+            bool leaked = false;
+            for (size_t i = 0; i < kTagCount; ++i) {
+                const Tag tag = static_cast<Tag>(i);
+                const TagStats stats = Stats(tag);
+                if (stats.bytes == 0 && stats.liveAllocations == 0) continue;
+
+                const bool expected = tag == Tag::Untagged || tag == Tag::Allocators;
+                leaked |= !expected;
+                std::fprintf(out, "%s %s: %lld bytes in %lld allocations (peak %lld)\n",
+                    expected ? "Retained at exit" : "LEAK", TagName(tag).data(),
+                    static_cast<long long>(stats.bytes), static_cast<long long>(stats.liveAllocations), static_cast<long long>(stats.peak));
+            }
+            return leaked;
+        }
+
+    private:
+        struct Entry {
+            std::atomic<std::int64_t> bytes{ 0 };
+            std::atomic<std::int64_t> peak{ 0 };
+            std::atomic<std::int64_t> liveAllocations{ 0 };
+            std::atomic<std::int64_t> totalAllocations{ 0 };
+            std::atomic<std::uint64_t> budget{ 0 };
+            std::atomic<bool> overBudget{ false };
+        };
+
+        struct Gauges {
+            metrics::Gauge* bytes = nullptr;
+            metrics::Gauge* peak = nullptr;
+        };
+
+        std::array<Entry, kTagCount> entries{};
+        std::array<Gauges, kTagCount> gauges{};  // Resolved on the first Publish()
+        std::atomic<bool> leakReportInstalled{ false };
+
+        constexpr Tracker() = default;
+
+        static size_t Index(Tag tag) {
+            const size_t index = static_cast<size_t>(tag);
+            return index < kTagCount ? index : 0;
+        }
+
+        static bool ParseTag(std::string_view name, Tag& tag) {
+            for (size_t i = 0; i < kTagCount; ++i) {
+                if (TagName(static_cast<Tag>(i)) == name) {
+                    tag = static_cast<Tag>(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static bool ParseSize(std::string_view text, std::uint64_t& bytes) {
+            std::uint64_t value = 0;
+            size_t i = 0;
+            for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) value = value * 10 + static_cast<std::uint64_t>(text[i] - '0');
+            if (i == 0) return false;
+
+            const std::string_view suffix = text.substr(i);
+            if (suffix.empty()) bytes = value;
+            else if (suffix == "K" || suffix == "k") bytes = value << 10;
+            else if (suffix == "M" || suffix == "m") bytes = value << 20;
+            else if (suffix == "G" || suffix == "g") bytes = value << 30;
+            else return false;
+            return true;
+        }
+    };
+
+    // Storage for a width x height texture, plus a third again for a full mip chain
+    constexpr std::uint64_t TextureBytes(std::uint64_t width, std::uint64_t height, std::uint64_t bytesPerTexel, bool mipmapped) {
+        const std::uint64_t base = width * height * bytesPerTexel;
+        return mipmapped ? base + base / 3 : base;
+    }
+
+    // Charges heap allocations made on this thread to a tag until the end of the scope
+    class TagScope {
+    public:
+        explicit TagScope(Tag tag) : previous(detail::currentTag) { detail::currentTag = tag; }
+        ~TagScope() { detail::currentTag = previous; }
+
+        TagScope(const TagScope&) = delete;
+        TagScope& operator=(const TagScope&) = delete;
+
+    private:
+        Tag previous;
+    };
+
+    // Charges memory the heap never sees (GPU storage, mappings) to a tag for the owner's lifetime.
+    // Set() replaces the previous amount, so owners call it again after a resize. A copy charges the
+    // same amount again, matching owners that are copied along with their handles. Empty and free
+    // when tracking is compiled out.
+    class TrackedBytes {
+    public:
+        explicit TrackedBytes(Tag tag) {
+#if defined(ALMOND_MEMORY_TRACKING)
+            this->tag = tag;
+#else
+            (void)tag;
+#endif
+        }
+
+        ~TrackedBytes() { Set(0); }
+
+        TrackedBytes(const TrackedBytes& other) : TrackedBytes(other.GetTag()) { Set(other.Get()); }
+
+        TrackedBytes& operator=(const TrackedBytes& other) {
+            if (this != &other) {
+                Set(0);
+#if defined(ALMOND_MEMORY_TRACKING)
+                tag = other.tag;
+#endif
+                Set(other.Get());
+            }
+            return *this;
+        }
+
+        void Set(std::uint64_t bytes) {
+#if defined(ALMOND_MEMORY_TRACKING)
+            if (bytes == current) return;
+            if (current != 0) Tracker::Get().Freed(tag, static_cast<size_t>(current));
+            if (bytes != 0) Tracker::Get().Allocated(tag, static_cast<size_t>(bytes));
+            current = bytes;
+#else
+            (void)bytes;
+#endif
+        }
+
+#if defined(ALMOND_MEMORY_TRACKING)
+        std::uint64_t Get() const { return current; }
+        Tag GetTag() const { return tag; }
+
+    private:
+        Tag tag;
+        std::uint64_t current = 0;
+#else
+        std::uint64_t Get() const { return 0; }
+        Tag GetTag() const { return Tag::Untagged; }
+#endif
+    };
+
+} // namespace almond::memory
+
+#if defined(ALMOND_MEMORY_TRACKING)
+#define ALMOND_MEMORY_CONCAT_INNER(a, b) a##b
+#define ALMOND_MEMORY_CONCAT(a, b) ALMOND_MEMORY_CONCAT_INNER(a, b)
+#define ALMOND_MEMORY_TAG(tag) ::almond::memory::TagScope ALMOND_MEMORY_CONCAT(almondMemoryTag, __LINE__)(::almond::memory::Tag::tag)
+#define ALMOND_MEMORY_STARTUP() ::almond::memory::Tracker::Get().Startup()
+#define ALMOND_MEMORY_PUBLISH() ::almond::memory::Tracker::Get().Publish()
+#else
+#define ALMOND_MEMORY_TAG(tag) ((void)0)
+#define ALMOND_MEMORY_STARTUP() ((void)0)
+#define ALMOND_MEMORY_PUBLISH() ((void)0)
+#endif
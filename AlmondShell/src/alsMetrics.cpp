@@ -0,0 +1,177 @@
+#include "alsMetrics.h"
+
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace almond::metrics {
+
+    namespace {
+
+#ifdef _WIN32
+        using SocketHandle = SOCKET;
+#else
+        using SocketHandle = int;
+#endif
+
+        void WriteName(std::ostringstream& out, const std::string& name) {
+            out << '"';
+            for (char c : name) {
+                if (c == '"' || c == '\\') out << '\\';
+                out << c;
+            }
+            out << "\":";
+        }
+
+    }
+
+    std::string FormatJson(const Snapshot& snapshot, const Snapshot* previous, double intervalSeconds) {
+        std::ostringstream out;
+        const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+        out << "{\"time_ms\":" << now.count() << ",\"interval_s\":" << intervalSeconds;
+
+        out << ",\"counters\":{";
+        bool first = true;
+        for (const auto& [name, total] : snapshot.counters) {
+            if (!first) out << ',';
+            first = false;
+            WriteName(out, name);
+            out << "{\"total\":" << total;
+            if (previous && intervalSeconds > 0.0) {
+                auto before = previous->counters.find(name);
+                const std::uint64_t last = before != previous->counters.end() ? before->second : 0;
+                out << ",\"per_second\":" << static_cast<double>(total - last) / intervalSeconds;
+            }
+            out << '}';
+        }
+
+        out << "},\"gauges\":{";
+        first = true;
+        for (const auto& [name, value] : snapshot.gauges) {
+            if (!first) out << ',';
+            first = false;
+            WriteName(out, name);
+            out << value;
+        }
+
+        out << "},\"histograms\":{";
+        first = true;
+        for (const auto& [name, summary] : snapshot.histograms) {
+            if (!first) out << ',';
+            first = false;
+            WriteName(out, name);
+            out << "{\"count\":" << summary.count << ",\"min\":" << summary.min << ",\"mean\":" << summary.mean
+                << ",\"p50\":" << summary.p50 << ",\"p95\":" << summary.p95 << ",\"p99\":" << summary.p99
+                << ",\"max\":" << summary.max << '}';
+        }
+        out << "}}";
+        return out.str();
+    }
+
+    MetricsReporter::MetricsReporter(Options options)
+        : options(std::move(options)), previousTime(std::chrono::steady_clock::now()) {
+        if (!this->options.filePath.empty()) {
+            file.open(this->options.filePath, std::ios::app);
+            if (!file) std::cerr << "Failed to open metrics file: " << this->options.filePath << std::endl;
+        }
+        if (this->options.udpPort > 0) OpenSocket();
+
+        // Start the first window now rather than at process start
+        previous = Registry::Get().TakeSnapshot(true);
+        worker = std::thread(&MetricsReporter::Run, this);
+    }
+
+    MetricsReporter::~MetricsReporter() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+
+        ReportNow(); // The partial last interval
+        CloseSocket();
+    }
+
+    void MetricsReporter::ReportNow() {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - previousTime).count();
+
+        Snapshot snapshot = Registry::Get().TakeSnapshot(true);
+        Send(FormatJson(snapshot, &previous, seconds));
+        previous = std::move(snapshot);
+        previousTime = now;
+    }
+
+    void MetricsReporter::Run() {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        while (!wake.wait_for(lock, options.interval, [this] { return stopping; })) {
+            lock.unlock();
+            ReportNow();
+            lock.lock();
+        }
+    }
+
+    void MetricsReporter::Send(const std::string& line) {
+        if (file.is_open()) {
+            file << line << '\n';
+            file.flush();
+        }
+        if (hasSocket) {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<unsigned short>(options.udpPort));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            // Best effort: nobody listening is not an error
+            sendto(static_cast<SocketHandle>(udpSocket), line.data(), static_cast<int>(line.size()), 0,
+                reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        }
+    }
+
+    void MetricsReporter::OpenSocket() {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            std::cerr << "Failed to start Winsock for metrics" << std::endl;
+            return;
+        }
+        SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle == INVALID_SOCKET) {
+            WSACleanup();
+            std::cerr << "Failed to open metrics socket" << std::endl;
+            return;
+        }
+#else
+        SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle < 0) {
+            std::cerr << "Failed to open metrics socket" << std::endl;
+            return;
+        }
+#endif
+        udpSocket = static_cast<std::uintptr_t>(handle);
+        hasSocket = true;
+    }
+
+    void MetricsReporter::CloseSocket() {
+        if (!hasSocket) return;
+#ifdef _WIN32
+        closesocket(static_cast<SocketHandle>(udpSocket));
+        WSACleanup();
+#else
+        close(static_cast<SocketHandle>(udpSocket));
+#endif
+        hasSocket = false;
+    }
+
+} // namespace almond::metrics
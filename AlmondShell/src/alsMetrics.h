@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Always-on engine metrics: counters, gauges and frame-time histograms in one process-wide registry.
+// Recording is a relaxed atomic add, so hot paths look their metric up once and keep the reference:
+//
+//   static metrics::Counter& drawCalls = metrics::Registry::Get().GetCounter("render.draw_calls");
+//   drawCalls.Add();
+//
+// Registry::TakeSnapshot() reads everything in-process; MetricsReporter dumps it periodically.
+
+namespace almond::metrics {
+
+    // Monotonic count of events, e.g. draw calls or bytes uploaded
+    class Counter {
+    public:
+        void Add(std::uint64_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+        std::uint64_t Get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<std::uint64_t> value{ 0 };
+    };
+
+    // Most recent value of something that goes up and down, e.g. FPS or queue depth
+    class Gauge {
+    public:
+        void Set(double newValue) { value.store(newValue, std::memory_order_relaxed); }
+        double Get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> value{ 0.0 };
+    };
+
+    struct HistogramSummary {
+        std::uint64_t count = 0;
+        std::uint64_t min = 0;
+        std::uint64_t max = 0;
+        double mean = 0.0;
+        std::uint64_t p50 = 0;
+        std::uint64_t p95 = 0;
+        std::uint64_t p99 = 0;
+    };
+
+    // Log-linear histogram in the style of HdrHistogram: values below 256 get a bucket each and every
+    // power of two above that is split into 128 buckets, so a percentile is reported within 0.8% of
+    // the true value (rounded up). Values are clamped to 2^36 (about 68 s in nanoseconds). Record() is
+    // lock-free and safe from any thread.
+    class Histogram {
+    public:
+        static constexpr int kSubBucketBits = 8;
+        static constexpr int kMaxShift = 28;
+        static constexpr std::uint64_t kMaxValue = (std::uint64_t(1) << (kMaxShift + kSubBucketBits)) - 1;
+        static constexpr size_t kBucketCount = (kMaxShift + 2) << (kSubBucketBits - 1);
+
+        void Record(std::uint64_t value) {
+            value = value > kMaxValue ? kMaxValue : value;
+            buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(value, std::memory_order_relaxed);
+
+            std::uint64_t seen = min.load(std::memory_order_relaxed);
+            while (value < seen && !min.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+            seen = max.load(std::memory_order_relaxed);
+            while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+        }
+
+        // With reset, the next summary only covers values recorded after this one. A value recorded
+        // while this runs lands in exactly one of the two windows, though its min/max may be lost.
+        HistogramSummary Summarize(bool reset) {
+            std::vector<std::uint64_t> counts(kBucketCount);
+            std::uint64_t total = 0;
+            for (size_t i = 0; i < kBucketCount; ++i) {
+                counts[i] = reset ? buckets[i].exchange(0, std::memory_order_relaxed) : buckets[i].load(std::memory_order_relaxed);
+                total += counts[i];
+            }
+
+            HistogramSummary summary;
+            const std::uint64_t sumValue = reset ? sum.exchange(0, std::memory_order_relaxed) : sum.load(std::memory_order_relaxed);
+            const std::uint64_t minValue = reset ? min.exchange(kEmptyMin, std::memory_order_relaxed) : min.load(std::memory_order_relaxed);
+            const std::uint64_t maxValue = reset ? max.exchange(0, std::memory_order_relaxed) : max.load(std::memory_order_relaxed);
+            if (reset) count.store(0, std::memory_order_relaxed);
+            if (total == 0) return summary;
+
+            summary.count = total;
+            summary.min = minValue == kEmptyMin ? 0 : minValue;
+            summary.max = maxValue;
+            summary.mean = static_cast<double>(sumValue) / static_cast<double>(total);
+            summary.p50 = Percentile(counts, total, 50.0, maxValue);
+            summary.p95 = Percentile(counts, total, 95.0, maxValue);
+            summary.p99 = Percentile(counts, total, 99.0, maxValue);
+            return summary;
+        }
+
+        std::uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+
+        static size_t BucketIndex(std::uint64_t value) {
+            const int bits = std::bit_width(value);
+            const int shift = bits > kSubBucketBits ? bits - kSubBucketBits : 0;
+            return (static_cast<size_t>(shift) << (kSubBucketBits - 1)) + static_cast<size_t>(value >> shift);
+        }
+
+        // Largest value that lands in the bucket
+        static std::uint64_t BucketUpperBound(size_t index) {
+            constexpr size_t half = size_t(1) << (kSubBucketBits - 1);
+            if (index < 2 * half) return index;
+            const int shift = static_cast<int>(index / half) - 1;
+            const std::uint64_t lower = static_cast<std::uint64_t>(index - shift * half) << shift;
+            return lower + (std::uint64_t(1) << shift) - 1;
+        }
+
+    private:
+        static constexpr std::uint64_t kEmptyMin = (std::numeric_limits<std::uint64_t>::max)();
+
+        std::unique_ptr<std::atomic<std::uint64_t>[]> buckets = std::make_unique<std::atomic<std::uint64_t>[]>(kBucketCount);
+        std::atomic<std::uint64_t> count{ 0 };
+        std::atomic<std::uint64_t> sum{ 0 };
+        std::atomic<std::uint64_t> min{ kEmptyMin };
+        std::atomic<std::uint64_t> max{ 0 };
+
+        static std::uint64_t Percentile(const std::vector<std::uint64_t>& counts, std::uint64_t total, double percentile, std::uint64_t maxValue) {
+            const auto rank = static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+            std::uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); ++i) {
+                seen += counts[i];
+                if (seen >= rank && seen > 0) return (std::min)(BucketUpperBound(i), maxValue);
+            }
+            return maxValue;
+        }
+    };
+
+    struct Snapshot {
+        std::map<std::string, std::uint64_t> counters;
+        std::map<std::string, double> gauges;
+        std::map<std::string, HistogramSummary> histograms;
+    };
+
+    class Registry {
+    public:
+        static Registry& Get() {
+            static Registry instance;
+            return instance;
+        }
+
+        // Created on first use; references stay valid for the life of the process
+        Counter& GetCounter(const std::string& name) { return Find(counters, name); }
+        Gauge& GetGauge(const std::string& name) { return Find(gauges, name); }
+        Histogram& GetHistogram(const std::string& name) { return Find(histograms, name); }
+
+        // With resetHistograms, each histogram starts a new window (counters never reset)
+        Snapshot TakeSnapshot(bool resetHistograms) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Snapshot snapshot;
+            for (const auto& [name, counter] : counters) snapshot.counters[name] = counter->Get();
+            for (const auto& [name, gauge] : gauges) snapshot.gauges[name] = gauge->Get();
+            for (const auto& [name, histogram] : histograms) snapshot.histograms[name] = histogram->Summarize(resetHistograms);
+            return snapshot;
+        }
+
+    private:
+        std::mutex mutex;
+        std::map<std::string, std::unique_ptr<Counter>> counters;
+        std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+
+        template <typename T>
+        T& Find(std::map<std::string, std::unique_ptr<T>>& metrics, const std::string& name) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& metric = metrics[name];
+            if (!metric) metric = std::make_unique<T>();
+            return *metric;
+        }
+    };
+
+    // The counters engine subsystems bump on their hot paths
+    struct EngineCounters {
+        Counter& drawCalls = Registry::Get().GetCounter("render.draw_calls");
+        Counter& stateChanges = Registry::Get().GetCounter("render.state_changes");   // Program, texture and VAO binds
+        Counter& uploadBytes = Registry::Get().GetCounter("render.upload_bytes");     // Texture data sent to the GPU
+        Counter& jobsExecuted = Registry::Get().GetCounter("jobs.executed");          // Run by pool workers
+        Counter& jobsRunInline = Registry::Get().GetCounter("jobs.run_inline");       // Queue full, ran on the caller
+        Counter& jobsCallerClaimed = Registry::Get().GetCounter("jobs.caller_claimed"); // parallelFor indices the caller took back from the pool
+    };
+
+    inline EngineCounters& Engine() {
+        static EngineCounters counters;
+        return counters;
+    }
+
+    // Formats a snapshot as one line of JSON. Counters report their total and, given the previous
+    // snapshot and the seconds between them, a per-second rate.
+    std::string FormatJson(const Snapshot& snapshot, const Snapshot* previous = nullptr, double intervalSeconds = 0.0);
+
+    // Dumps the registry every interval from a background thread: one JSON line appended to a file
+    // and/or sent as a UDP datagram to a port on 127.0.0.1 (e.g. for a local dashboard agent). Each
+    // dump starts a new histogram window, so percentiles cover the last interval only.
+    class MetricsReporter {
+    public:
+        struct Options {
+            std::chrono::milliseconds interval{ 1000 };
+            std::string filePath;   // Empty: no file
+            int udpPort = 0;        // 0: no socket
+        };
+
+        explicit MetricsReporter(Options options);
+        ~MetricsReporter();
+
+        MetricsReporter(const MetricsReporter&) = delete;
+        MetricsReporter& operator=(const MetricsReporter&) = delete;
+
+        // Dumps immediately, outside the schedule
+        void ReportNow();
+
+    private:
+        Options options;
+        std::ofstream file;
+        std::uintptr_t udpSocket = 0;
+        bool hasSocket = false;
+
+        std::mutex reportMutex;
+        Snapshot previous;
+        std::chrono::steady_clock::time_point previousTime;
+
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+        std::thread worker;
+
+        void Run();
+        void OpenSocket();
+        void CloseSocket();
+        void Send(const std::string& line);
+    };
+
+} // namespace almond::metrics
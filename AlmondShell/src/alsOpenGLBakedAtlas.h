@@ -0,0 +1,101 @@
+#pragma once
+
+#include "alsEngineConfig.h"
+#include "alsBakedAtlas.h"
+
+#ifdef ALMOND_USING_OPENGLTEXTURE
+
+#include <stdexcept>
+#include <vector>
+
+namespace almond {
+
+    // Loads an atlas produced by the AtlasBaker tool: one read, one upload per page and no packing
+    // at runtime. Every page is a layer of a single GL_TEXTURE_2D_ARRAY, so all sprites share one
+    // binding and a sprite's page is its layer. Sprite lookups go through the baked manifest.
+    //
+    // Atlases baked with --mip-levels N get a mip chain of that depth; the baker's sprite alignment
+    // and extruded gutters keep those levels from bleeding between sprites.
+    class OpenGLBakedAtlas {
+    public:
+        explicit OpenGLBakedAtlas(const std::filesystem::path& filepath)
+            : atlas(BakedAtlas::Load(filepath)) {
+            UploadPages();
+            atlas.ReleasePixels();
+        }
+
+        ~OpenGLBakedAtlas() {
+            if (texture != 0) {
+                glDeleteTextures(1, &texture);
+            }
+        }
+
+        OpenGLBakedAtlas(const OpenGLBakedAtlas&) = delete;
+        OpenGLBakedAtlas& operator=(const OpenGLBakedAtlas&) = delete;
+
+        // Shaders sample with sampler2DArray at vec3(uv, sprite.page)
+        void Bind(unsigned int slot = 0) const {
+            glActiveTexture(GL_TEXTURE0 + slot);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        }
+
+        GLuint GetTexture() const { return texture; }
+        size_t GetPageCount() const { return pageCount; }
+        const BakedAtlas& GetAtlas() const { return atlas; }
+
+        const BakedSprite* FindSprite(const std::string& name) const { return atlas.FindSprite(name); }
+        const BakedSprite& GetSprite(const std::string& name) const { return atlas.GetSprite(name); }
+
+    private:
+        BakedAtlas atlas;
+        GLuint texture = 0;
+        size_t pageCount = 0;
+
+        void UploadPages() {
+            const auto& pages = atlas.GetPages();
+            if (pages.empty()) {
+                throw std::runtime_error("Baked atlas has no pages.");
+            }
+
+            const auto& first = pages.front();
+            for (const auto& page : pages) {
+                if (page.width != first.width || page.height != first.height || page.channels != first.channels) {
+                    throw std::runtime_error("Baked atlas pages must share one size and format to form a texture array.");
+                }
+            }
+
+            pageCount = pages.size();
+            const int mipLevels = atlas.GetMipLevels();
+            GLenum internalFormat = (first.channels == 4) ? GL_RGBA8 : GL_RGB8;
+            GLenum dataFormat = (first.channels == 4) ? GL_RGBA : GL_RGB;
+
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, first.width, first.height,
+                static_cast<GLsizei>(pageCount), 0, dataFormat, GL_UNSIGNED_BYTE, nullptr);
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (size_t i = 0; i < pages.size(); ++i) {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), first.width, first.height, 1,
+                    dataFormat, GL_UNSIGNED_BYTE, pages[i].Data());
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+            if (mipLevels > 1) {
+                glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            }
+            else {
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        }
+    };
+
+} // namespace almond
+
+#endif
@@ -1,22 +1,48 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsMetrics.h"
+#include "alsTextureAtlasPacker.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <unordered_map>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 //#include <glm/glm.hpp> // glm::ivec2, glm::vec2
 
 namespace almond {
 
+    // Interleaved vertex used by batched text rendering: position, atlas UV and packed RGBA8 color
+    struct GlyphVertex {
+        float x, y;
+        float u, v;
+        std::uint32_t color;
+    };
+
+    // Upper bound on glyph quads submitted per draw call; larger batches are flushed in chunks
+    inline constexpr std::size_t kMaxGlyphsPerBatch = 16384;
+
+    enum class GlyphRenderMode {
+        Bitmap,             // Coverage bitmaps rasterized at the font size; crisp only near scale 1
+        SignedDistanceField // Distance fields rasterized once and reused at any scale
+    };
+
     class FontManager {
     public:
+        // Glyphs are packed into up to maxPages atlas pages of atlasWidth x atlasHeight texels.
+        // When every page is full the least recently used page is wiped and refilled on demand.
         FontManager(const std::filesystem::path& fontPath, unsigned int fontSize = 48,
-            int atlasWidth = 4096, int atlasHeight = 4096, int padding = 2)
-            : fontSize(fontSize), atlasWidth(atlasWidth), atlasHeight(atlasHeight), padding(padding) {
+            int atlasWidth = 4096, int atlasHeight = 4096, int padding = 2,
+            size_t maxPages = 4, GlyphRenderMode renderMode = GlyphRenderMode::Bitmap)
+            : fontSize(fontSize), atlasWidth(atlasWidth), atlasHeight(atlasHeight), padding(padding),
+              maxPages(std::max<size_t>(1, maxPages)), renderMode(renderMode) {
             if (!std::filesystem::exists(fontPath)) {
                 throw std::runtime_error("Font file does not exist: " + fontPath.string());
             }
@@ -31,113 +57,290 @@ namespace almond {
 
             FT_Set_Pixel_Sizes(ftFace, 0, fontSize);
 
-            initTextureAtlas();
+            addPage();
         }
 
         ~FontManager() noexcept {
-            glDeleteTextures(1, &textureAtlas);
+            for (auto& page : pages) {
+                glDeleteTextures(1, &page.texture);
+            }
+            if (zeroBuffer != 0) {
+                glDeleteBuffers(1, &zeroBuffer);
+            }
             FT_Done_Face(ftFace);
             FT_Done_FreeType(ftLibrary);
         }
 
+        FontManager(const FontManager&) = delete;
+        FontManager& operator=(const FontManager&) = delete;
+
         GLuint getTextureAtlas() const noexcept {
-            return textureAtlas;
+            return pages.front().texture;
+        }
+
+        GLuint getPageTexture(size_t page) const noexcept {
+            return pages[page].texture;
+        }
+
+        size_t getPageCount() const noexcept {
+            return pages.size();
+        }
+
+        GlyphRenderMode getRenderMode() const noexcept {
+            return renderMode;
+        }
+
+        // Incremented whenever a page is evicted; glyph UVs obtained earlier may be stale
+        std::uint64_t getGeneration() const noexcept {
+            return generation;
+        }
+
+        // Invoked right before a page is overwritten so pending draws can be submitted first
+        void setEvictionCallback(std::function<void()> callback) {
+            onEvict = std::move(callback);
+        }
+
+        // Marks a page as recently used so it is the last candidate for eviction
+        void touchPage(size_t page) noexcept {
+            pages[page].lastUsed = ++useClock;
+        }
+
+        // Distance between baselines in pixels at the loaded font size
+        float getLineHeight() const noexcept {
+            return static_cast<float>(ftFace->size->metrics.height >> 6);
         }
 
         struct Character {
-            GLuint textureID;            // Texture ID
+            GLuint textureID;            // Texture ID of the atlas page holding the glyph
             glm::ivec2 size;             // Size of the glyph in pixels
             glm::ivec2 bearing;          // Offset from baseline to top-left of the glyph
             int advance;                 // Horizontal offset to advance to the next glyph
             glm::vec2 texCoordStart;     // UV coordinates for the start
             glm::vec2 texCoordEnd;       // UV coordinates for the end
+            std::uint16_t page = 0;      // Atlas page index
         };
 
-        const Character& getCharacter(char c) {
-            auto it = characterMap.find(c);
-            if (it != characterMap.end()) {
-                return it->second;
+        const Character& getCharacter(char32_t codepoint) {
+            // ASCII is resolved through a flat table so Latin text never touches the hash map
+            if (codepoint < asciiGlyphs.size()) {
+                if (!asciiLoaded[codepoint]) {
+                    loadCharacterToAtlas(codepoint);
+                }
+                touchPage(asciiGlyphs[codepoint].page);
+                return asciiGlyphs[codepoint];
             }
 
-            // Lazy load character if not already loaded
-            loadCharacterToAtlas(c);
-            return characterMap.at(c);
+            auto it = characterMap.find(codepoint);
+            if (it == characterMap.end()) {
+                // Lazy load character if not already loaded
+                loadCharacterToAtlas(codepoint);
+                it = characterMap.find(codepoint);
+            }
+            touchPage(it->second.page);
+            return it->second;
+        }
+
+        const Character& getCharacter(char c) {
+            return getCharacter(static_cast<char32_t>(static_cast<unsigned char>(c)));
         }
 
     private:
+        struct AtlasPage {
+            GLuint texture = 0;
+            SkylinePacker packer;
+            std::uint64_t lastUsed = 0;
+            std::vector<char32_t> glyphs; // Codepoints resident on this page, dropped on eviction
+        };
+
         FT_Library ftLibrary{};
         FT_Face ftFace{};
         unsigned int fontSize;
-        GLuint textureAtlas = 0;
         unsigned int atlasWidth;
         unsigned int atlasHeight;
         unsigned int padding;
+        size_t maxPages;
+        GlyphRenderMode renderMode;
+
+        std::vector<AtlasPage> pages;
+        std::uint64_t useClock = 0;
+        std::uint64_t generation = 0;
+        std::function<void()> onEvict;
+        GLuint zeroBuffer = 0; // Page-sized zeroed PBO, for clearing pages without GL 4.4
 
-        unsigned int xOffset = padding;
-        unsigned int yOffset = padding;
-        int rowHeight = 0;
+        std::array<Character, 128> asciiGlyphs{};
+        std::array<bool, 128> asciiLoaded{};
+        std::unordered_map<char32_t, Character> characterMap;
 
-        std::unordered_map<char, Character> characterMap;
+        void addPage() {
+            AtlasPage page{ 0, SkylinePacker(atlasWidth - padding, atlasHeight - padding), 0, {} };
 
-        void initTextureAtlas() {
-            glGenTextures(1, &textureAtlas);
-            glBindTexture(GL_TEXTURE_2D, textureAtlas);
+            glGenTextures(1, &page.texture);
+            glBindTexture(GL_TEXTURE_2D, page.texture);
 
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
 
             if (glGetError() != GL_NO_ERROR) {
+                glDeleteTextures(1, &page.texture);
                 throw std::runtime_error("OpenGL texture initialization failed");
             }
 
             glBindTexture(GL_TEXTURE_2D, 0);
+            clearPage(page);
+            pages.push_back(std::move(page));
         }
 
-        void loadCharacterToAtlas(char c) {
-            if (FT_Load_Char(ftFace, c, FT_LOAD_RENDER)) {
-                std::cerr << "Failed to load character: " << c << std::endl;
+        // Zeroes a page's texels. Glyphs are uploaded without their padding gutter, so anything
+        // left in it (undefined storage, or an evicted glyph) would bleed into bilinear samples.
+        // Either way the clear stays on the GPU; nothing is allocated or sent per call.
+        void clearPage(const AtlasPage& page) {
+            if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_clear_texture) {
+                glClearTexImage(page.texture, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr); // Null data clears to zero
                 return;
             }
 
-            FT_GlyphSlot glyph = ftFace->glyph;
+            if (zeroBuffer == 0) {
+                const std::vector<unsigned char> zeros(static_cast<size_t>(atlasWidth) * atlasHeight, 0);
+                glGenBuffers(1, &zeroBuffer);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, zeroBuffer);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, zeros.size(), zeros.data(), GL_STATIC_DRAW);
+                metrics::Engine().uploadBytes.Add(zeros.size());
+            }
+            else {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, zeroBuffer);
+            }
 
-            if (xOffset + glyph->bitmap.width + padding > atlasWidth) {
-                xOffset = padding;
-                yOffset += rowHeight + padding;
-                rowHeight = 0;
+            glBindTexture(GL_TEXTURE_2D, page.texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlasWidth, atlasHeight, GL_RED, GL_UNSIGNED_BYTE, nullptr); // Offset 0 into the PBO
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        void evictPage(size_t index) {
+            if (onEvict) {
+                onEvict();
+            }
 
-                if (yOffset + glyph->bitmap.rows + padding > atlasHeight) {
-                    throw std::runtime_error("Texture atlas size is insufficient for all glyphs.");
+            AtlasPage& page = pages[index];
+            for (char32_t codepoint : page.glyphs) {
+                if (codepoint < asciiGlyphs.size()) {
+                    asciiLoaded[codepoint] = false;
+                }
+                else {
+                    characterMap.erase(codepoint);
                 }
             }
+            page.glyphs.clear();
+            page.packer.Reset();
+            clearPage(page);
+            ++generation;
+        }
 
-            glBindTexture(GL_TEXTURE_2D, textureAtlas);
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        // Finds room for a w x h glyph, growing or evicting pages as needed
+        std::tuple<size_t, int, int> allocate(unsigned int w, unsigned int h) {
+            if (w + padding > atlasWidth || h + padding > atlasHeight) {
+                throw std::runtime_error("Glyph is larger than a texture atlas page.");
+            }
 
-            glTexSubImage2D(GL_TEXTURE_2D, 0, xOffset, yOffset, glyph->bitmap.width, glyph->bitmap.rows,
-                GL_RED, GL_UNSIGNED_BYTE, glyph->bitmap.buffer);
+            for (size_t i = 0; i < pages.size(); ++i) {
+                auto [x, y] = pages[i].packer.Insert(w + padding, h + padding);
+                if (x != -1) return { i, x + static_cast<int>(padding), y + static_cast<int>(padding) };
+            }
+
+            size_t target = pages.size();
+            if (pages.size() < maxPages) {
+                addPage();
+            }
+            else {
+                target = 0;
+                for (size_t i = 1; i < pages.size(); ++i) {
+                    if (pages[i].lastUsed < pages[target].lastUsed) target = i;
+                }
+                evictPage(target);
+            }
+
+            auto [x, y] = pages[target].packer.Insert(w + padding, h + padding);
+            return { target, x + static_cast<int>(padding), y + static_cast<int>(padding) };
+        }
+
+        void storeCharacter(char32_t codepoint, const Character& character) {
+            if (codepoint < asciiGlyphs.size()) {
+                asciiGlyphs[codepoint] = character;
+                asciiLoaded[codepoint] = true;
+            }
+            else {
+                characterMap[codepoint] = character;
+            }
+        }
+
+        bool renderGlyph(char32_t codepoint) {
+            if (renderMode == GlyphRenderMode::Bitmap) {
+                return FT_Load_Char(ftFace, codepoint, FT_LOAD_RENDER) == 0;
+            }
+
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+            if (FT_Load_Char(ftFace, codepoint, FT_LOAD_DEFAULT)) return false;
+            return FT_Render_Glyph(ftFace->glyph, FT_RENDER_MODE_SDF) == 0;
+#else
+            throw std::runtime_error("Signed distance field glyphs require FreeType 2.11 or newer.");
+#endif
+        }
 
-            rowHeight = std::max(rowHeight, static_cast<int>(glyph->bitmap.rows));
+        void loadCharacterToAtlas(char32_t codepoint) {
+            if (!renderGlyph(codepoint)) {
+                std::cerr << "Failed to load character: U+" << std::hex << static_cast<std::uint32_t>(codepoint) << std::dec << std::endl;
+                // Cache an empty glyph so a missing codepoint is not retried every frame
+                storeCharacter(codepoint, Character{});
+                return;
+            }
+
+            FT_GlyphSlot glyph = ftFace->glyph;
+            const unsigned int glyphWidth = glyph->bitmap.width;
+            const unsigned int glyphHeight = glyph->bitmap.rows;
 
             Character character = {
-                0,  // textureID is unused here; textureAtlas handles this globally
-                glm::ivec2(glyph->bitmap.width, glyph->bitmap.rows),
+                pages.front().texture,
+                glm::ivec2(glyphWidth, glyphHeight),
                 glm::ivec2(glyph->bitmap_left, glyph->bitmap_top),
                 static_cast<int>(glyph->advance.x >> 6),
-                glm::vec2(static_cast<float>(xOffset) / atlasWidth, static_cast<float>(yOffset) / atlasHeight),
-                glm::vec2(static_cast<float>(xOffset + glyph->bitmap.width) / atlasWidth,
-                          static_cast<float>(yOffset + glyph->bitmap.rows) / atlasHeight)
+                glm::vec2(0.0f), glm::vec2(0.0f), 0
             };
 
-            characterMap[c] = character;
-            xOffset += glyph->bitmap.width + padding;
+            // Whitespace has no bitmap and needs no atlas space
+            if (glyphWidth == 0 || glyphHeight == 0) {
+                storeCharacter(codepoint, character);
+                return;
+            }
+
+            auto [pageIndex, xOffset, yOffset] = allocate(glyphWidth, glyphHeight);
+            AtlasPage& page = pages[pageIndex];
+
+            glBindTexture(GL_TEXTURE_2D, page.texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, glyph->bitmap.pitch);
 
+            glTexSubImage2D(GL_TEXTURE_2D, 0, xOffset, yOffset, glyphWidth, glyphHeight,
+                GL_RED, GL_UNSIGNED_BYTE, glyph->bitmap.buffer);
+            metrics::Engine().uploadBytes.Add(static_cast<std::uint64_t>(glyphWidth) * glyphHeight);
+
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
             glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
             glBindTexture(GL_TEXTURE_2D, 0);
+
+            character.textureID = page.texture;
+            character.page = static_cast<std::uint16_t>(pageIndex);
+            character.texCoordStart = glm::vec2(static_cast<float>(xOffset) / atlasWidth, static_cast<float>(yOffset) / atlasHeight);
+            character.texCoordEnd = glm::vec2(static_cast<float>(xOffset + glyphWidth) / atlasWidth,
+                                              static_cast<float>(yOffset + glyphHeight) / atlasHeight);
+
+            page.glyphs.push_back(codepoint);
+            storeCharacter(codepoint, character);
         }
     };
 }
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "alsEngineConfig.h"
+#include "alsProfiler.h"
+
+#ifdef ALMOND_USING_OPENGL
+
+#include <array>
+#include <cstdint>
+
+namespace almond::profiler {
+
+    // GPU side of the frame profiler. Each scope issues a GL_TIMESTAMP query for its start and a
+    // GL_TIME_ELAPSED query for its duration into a ring of frames, and the results are read back
+    // kFramesInFlight frames later when the slot comes round again, so the CPU never waits on the GPU.
+    // GL_TIME_ELAPSED queries cannot overlap, so a scope opened inside another is folded into the
+    // outer one. Nothing is issued outside a capture, so the last few frames of one have no GPU track.
+    //
+    // Needs a current GL context for its whole lifetime; call BeginFrame() once per frame.
+    class GpuProfiler {
+    public:
+        static constexpr int kFramesInFlight = 4;
+        static constexpr int kMaxScopesPerFrame = 32;
+
+        GpuProfiler() {
+            for (auto& frame : frames) {
+                glGenQueries(kMaxScopesPerFrame, frame.startQueries.data());
+                glGenQueries(kMaxScopesPerFrame, frame.elapsedQueries.data());
+            }
+        }
+
+        ~GpuProfiler() {
+            for (auto& frame : frames) {
+                glDeleteQueries(kMaxScopesPerFrame, frame.startQueries.data());
+                glDeleteQueries(kMaxScopesPerFrame, frame.elapsedQueries.data());
+            }
+        }
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        // Collects the oldest frame's results and starts reusing its queries
+        void BeginFrame() {
+            current = (current + 1) % kFramesInFlight;
+            FrameQueries& frame = frames[current];
+            Collect(frame);
+            depth = 0;
+
+            frame.used = 0;
+            if (!Profiler::Get().IsCapturing()) return;
+
+            // GL timestamps run on their own clock; remember where it sat relative to the capture's
+            GLint64 gpuNow = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+            frame.clockOffsetNs = static_cast<std::int64_t>(Profiler::Get().Now()) - gpuNow;
+        }
+
+        void BeginScope(const char* name) {
+            if (depth++ > 0 || !Profiler::Get().IsCapturing()) return;
+
+            FrameQueries& frame = frames[current];
+            if (frame.used >= kMaxScopesPerFrame) return;
+
+            frame.names[frame.used] = name;
+            glQueryCounter(frame.startQueries[frame.used], GL_TIMESTAMP);
+            glBeginQuery(GL_TIME_ELAPSED, frame.elapsedQueries[frame.used]);
+            open = true;
+        }
+
+        void EndScope() {
+            if (depth == 0 || --depth > 0 || !open) return;
+
+            glEndQuery(GL_TIME_ELAPSED);
+            ++frames[current].used;
+            open = false;
+        }
+
+    private:
+        struct FrameQueries {
+            std::array<GLuint, kMaxScopesPerFrame> startQueries{};
+            std::array<GLuint, kMaxScopesPerFrame> elapsedQueries{};
+            std::array<const char*, kMaxScopesPerFrame> names{};
+            int used = 0;
+            std::int64_t clockOffsetNs = 0;
+        };
+
+        std::array<FrameQueries, kFramesInFlight> frames;
+        int current = 0;
+        int depth = 0;
+        bool open = false;
+
+        // Results that are still not ready after kFramesInFlight frames are dropped
+        static void Collect(const FrameQueries& frame) {
+            for (int i = 0; i < frame.used; ++i) {
+                GLint available = 0;
+                glGetQueryObjectiv(frame.elapsedQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available) continue;
+
+                GLuint64 startNs = 0;
+                GLuint64 elapsedNs = 0;
+                glGetQueryObjectui64v(frame.startQueries[i], GL_QUERY_RESULT, &startNs);
+                glGetQueryObjectui64v(frame.elapsedQueries[i], GL_QUERY_RESULT, &elapsedNs);
+
+                const std::int64_t start = static_cast<std::int64_t>(startNs) + frame.clockOffsetNs;
+                Profiler::Get().RecordGpu(frame.names[i], start > 0 ? static_cast<std::uint64_t>(start) : 0, elapsedNs);
+            }
+        }
+    };
+
+    // Times the GL commands issued during its lifetime
+    class GpuScope {
+    public:
+        GpuScope(GpuProfiler& profiler, const char* name) : profiler(profiler) {
+            profiler.BeginScope(name);
+        }
+
+        ~GpuScope() {
+            profiler.EndScope();
+        }
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        GpuProfiler& profiler;
+    };
+
+} // namespace almond::profiler
+
+#if defined(ALMOND_PROFILING)
+#define ALMOND_PROFILE_GPU_SCOPE(gpuProfiler, name) ::almond::profiler::GpuScope ALMOND_PROFILE_CONCAT(almondGpuScope, __LINE__)(gpuProfiler, name)
+#else
+#define ALMOND_PROFILE_GPU_SCOPE(gpuProfiler, name) ((void)0)
+#endif
+
+#endif // ALMOND_USING_OPENGL
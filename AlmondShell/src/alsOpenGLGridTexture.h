@@ -0,0 +1,167 @@
+#pragma once
+
+#include "alsEngineConfig.h"
+#include "alsMemoryTracker.h"
+#include "alsMetrics.h"
+#include "alsOpenGLShader.h"
+
+#ifdef ALMOND_USING_OPENGLTEXTURE
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace almond {
+
+    // Draws a simulation grid (sand, Game of Life, ...) as a single full-screen triangle. The cells
+    // live in an integer texture, one byte per cell or one bit per cell for bit-packed grids, and the
+    // fragment shader (gridfrag.glsl) looks each one up in a 256-entry palette. Callers mark the rows
+    // that changed and Upload() sends just that band in one glTexSubImage2D, so a frame costs the
+    // same however many particles are alive.
+    class OpenGLGridTexture {
+    public:
+        enum class CellFormat {
+            Byte,   // One palette index per cell (GL_R8UI)
+            Bit     // 32 cells per 32-bit texel, lowest bit first (GL_R32UI); colours 0 and 1
+        };
+
+        OpenGLGridTexture(int width, int height, CellFormat format,
+            const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+            : shader(vertexShaderPath, fragmentShaderPath), format(format) {
+            glGenVertexArrays(1, &vao); // Core profile draws need a VAO, even an empty one
+
+            glGenTextures(1, &paletteTexture);
+            glBindTexture(GL_TEXTURE_2D, paletteTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, kPaletteSize, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            SetNearest();
+            SetPalette(nullptr, 0);
+
+            Resize(width, height);
+        }
+
+        ~OpenGLGridTexture() {
+            if (cellTexture != 0) glDeleteTextures(1, &cellTexture);
+            if (paletteTexture != 0) glDeleteTextures(1, &paletteTexture);
+            if (vao != 0) glDeleteVertexArrays(1, &vao);
+        }
+
+        OpenGLGridTexture(const OpenGLGridTexture&) = delete;
+        OpenGLGridTexture& operator=(const OpenGLGridTexture&) = delete;
+
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+
+        // Colours are 0xAABBGGRR, indexed by cell value; entries past count are transparent
+        void SetPalette(const std::uint32_t* colors, size_t count) {
+            std::array<std::uint32_t, kPaletteSize> entries{};
+            if (colors) {
+                std::copy(colors, colors + std::min<size_t>(count, kPaletteSize), entries.begin());
+            }
+            glBindTexture(GL_TEXTURE_2D, paletteTexture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kPaletteSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, entries.data());
+        }
+
+        // Reallocates the cell texture; every row is uploaded on the next Upload()
+        void Resize(int newWidth, int newHeight) {
+            width = std::max(1, newWidth);
+            height = std::max(1, newHeight);
+            texelWidth = format == CellFormat::Bit ? (width + 31) / 32 : width;
+
+            if (cellTexture != 0) glDeleteTextures(1, &cellTexture);
+            glGenTextures(1, &cellTexture);
+            glBindTexture(GL_TEXTURE_2D, cellTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, format == CellFormat::Bit ? GL_R32UI : GL_R8UI, texelWidth, height, 0,
+                GL_RED_INTEGER, PixelType(), nullptr);
+            SetNearest(); // Integer textures are incomplete with any other filter
+            gpuBytes.Set(memory::TextureBytes(texelWidth, height, format == CellFormat::Bit ? 4 : 1, false));
+
+            MarkAllDirty();
+        }
+
+        void MarkDirtyRows(int first, int last) {
+            dirtyFirst = std::min(dirtyFirst, std::max(first, 0));
+            dirtyLast = std::max(dirtyLast, std::min(last, height - 1));
+        }
+
+        void MarkAllDirty() {
+            MarkDirtyRows(0, height - 1);
+        }
+
+        // Uploads the dirty rows of `cells`, which points at row 0. rowLength is the distance between
+        // rows in texels (bytes, or 32-bit words for CellFormat::Bit); 0 means tightly packed.
+        void Upload(const void* cells, int rowLength = 0) {
+            if (dirtyFirst > dirtyLast) return;
+
+            const size_t texelSize = format == CellFormat::Bit ? 4 : 1;
+            const size_t pitch = static_cast<size_t>(rowLength > 0 ? rowLength : texelWidth) * texelSize;
+            const auto* first = static_cast<const std::uint8_t*>(cells) + dirtyFirst * pitch;
+
+            glBindTexture(GL_TEXTURE_2D, cellTexture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyFirst, texelWidth, dirtyLast - dirtyFirst + 1,
+                GL_RED_INTEGER, PixelType(), first);
+            metrics::Engine().uploadBytes.Add(static_cast<std::uint64_t>(texelWidth) * texelSize * (dirtyLast - dirtyFirst + 1));
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+            dirtyFirst = INT_MAX;
+            dirtyLast = INT_MIN;
+        }
+
+        // Stretches the grid over the current viewport; palette entries with alpha blend over it
+        void Draw() const {
+            shader.Use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, cellTexture);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, paletteTexture);
+            glUniform1i(glGetUniformLocation(shader.GetID(), "cells"), 0);
+            glUniform1i(glGetUniformLocation(shader.GetID(), "palette"), 1);
+            glUniform2i(glGetUniformLocation(shader.GetID(), "gridSize"), width, height);
+            glUniform1i(glGetUniformLocation(shader.GetID(), "packedBits"), format == CellFormat::Bit);
+
+            glBindVertexArray(vao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+            glActiveTexture(GL_TEXTURE0);
+
+            auto& counters = metrics::Engine();
+            counters.stateChanges.Add(3); // Two textures and the VAO; Use() counts the program
+            counters.drawCalls.Add();
+        }
+
+    private:
+        static constexpr int kPaletteSize = 256;
+
+        ShaderProgram shader;
+        CellFormat format;
+        GLuint vao = 0;
+        GLuint cellTexture = 0;
+        GLuint paletteTexture = 0;
+        int width = 0;
+        int height = 0;
+        int texelWidth = 0;
+        int dirtyFirst = INT_MAX;
+        int dirtyLast = INT_MIN;
+        memory::TrackedBytes gpuBytes{ memory::Tag::Gpu };
+
+        GLenum PixelType() const {
+            return format == CellFormat::Bit ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE;
+        }
+
+        static void SetNearest() {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        }
+    };
+
+} // namespace almond
+
+#endif
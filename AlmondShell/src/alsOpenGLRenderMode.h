@@ -1,6 +1,7 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsMetrics.h"
 #include "alsOpenGLMesh.h"
 #include "alsOpenGLShader.h"
 #include "alsOpenGLQuad.h"
@@ -94,7 +95,10 @@ namespace almond {
                 glDrawElements(GL_TRIANGLES, mesh->GetIndexCount(), GL_UNSIGNED_INT, nullptr);
             } else {
                 std::cerr << "ERROR: Neither mesh nor quad is valid." << std::endl;
+                return;
             }
+            metrics::Engine().stateChanges.Add();
+            metrics::Engine().drawCalls.Add();
 
             glBindVertexArray(0);
         }
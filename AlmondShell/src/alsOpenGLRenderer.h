@@ -1,13 +1,18 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsMetrics.h"
 #include "alsOpenGLFreeType.h"
 #include "alsOpenGLRenderMode.h"
 #include "alsOpenGLTexture.h"
 #include "alsOpenGLShader.h"
 #include "alsOpenGLTextureAtlas.h"
 #include "alsTextureAtlasPacker.h"
+#include "alsStringUtils.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 #include <optional>
@@ -80,10 +85,10 @@ namespace almond {
             }
 
             for (auto& atlas : m_atlasTextures) {
-                TexturePacker packer(atlasWidth, atlasHeight);
+                AtlasAllocator packer(atlasWidth, atlasHeight);
 
                 for (auto& texture : atlas.GetTextures()) {
-                    auto [x, y] = packer.Insert(texture.GetWidth(), texture.GetHeight());
+                    auto [x, y, w, h] = packer.Insert(texture.GetWidth(), texture.GetHeight());
                     if (x == -1 || y == -1) {
                         throw std::runtime_error("Failed to repack texture: insufficient space in atlas.");
                     }
@@ -239,6 +244,8 @@ namespace almond {
             glBindVertexArray(quad->GetVAO());
             glDrawElements(GL_TRIANGLES, quad->GetIndexCount(), GL_UNSIGNED_INT, nullptr);
             glBindVertexArray(0);
+            metrics::Engine().stateChanges.Add();
+            metrics::Engine().drawCalls.Add();
 
             if (m_renderMode == RenderMode::TextureAtlas) {
                //if (textureAtlas) textureAtlas->Unbind();
@@ -366,23 +373,30 @@ namespace almond {
 
             glBindVertexArray(outVAO);
 
-            // Setup VBO
+            // Setup VBO sized for a full text batch; contents are streamed every flush
             glBindBuffer(GL_ARRAY_BUFFER, outVBO);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, nullptr, GL_STATIC_DRAW);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(GlyphVertex) * 4 * kMaxGlyphsPerBatch, nullptr, GL_STREAM_DRAW);
 
             glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-
-            // Setup EBO
-            unsigned int indices[] = {
-                0, 1, 2,  // First triangle
-                0, 2, 3   // Second triangle
-            };
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (void*)offsetof(GlyphVertex, x));
+
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphVertex), (void*)offsetof(GlyphVertex, color));
+
+            // Setup EBO with the quad index pattern for every glyph slot in the batch
+            std::vector<unsigned int> indices(6 * kMaxGlyphsPerBatch);
+            for (unsigned int quad = 0; quad < kMaxGlyphsPerBatch; ++quad) {
+                const unsigned int base = quad * 4;
+                const unsigned int offset = quad * 6;
+                indices[offset + 0] = base + 0; // First triangle
+                indices[offset + 1] = base + 1;
+                indices[offset + 2] = base + 2;
+                indices[offset + 3] = base + 0; // Second triangle
+                indices[offset + 4] = base + 2;
+                indices[offset + 5] = base + 3;
+            }
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, outEBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
             // Unbind buffers
             glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -443,7 +457,7 @@ namespace almond {
         OpenGLTexture m_texture;
         OpenGLTextureAtlas m_textureatlas;
         std::vector<OpenGLTexture> m_textures;
-        std::vector<OpenGLTexture> m_atlastextures;
+        std::vector<OpenGLTextureAtlas> m_atlastextures;
         std::vector<OpenGLTextureAtlas> m_textureatlases;
         std::unordered_map<std::string, std::tuple<int, int, int, int>> m_textureMap;
         std::unordered_map<std::string, std::shared_ptr<Quad>> m_quads;
@@ -453,66 +467,216 @@ namespace almond {
 
     class FontRenderer {
     public:
-        FontRenderer(FontManager& fontManager, Renderer& renderer, GLuint vao, GLuint vbo, GLuint ebo)
-            : fontManager(fontManager), renderer(renderer), VAO(vao), VBO(vbo), EBO(ebo) {
+        // Laid-out glyph quads for one string at scale 1 with the pen starting at the origin.
+        // pages holds the atlas page of each quad (four vertices per quad).
+        struct GlyphRun {
+            std::vector<GlyphVertex> vertices;
+            std::vector<std::uint16_t> pages;
+            float width = 0.0f;
+        };
+
+        FontRenderer(FontManager& fontManager, Renderer& renderer, GLuint vao, GLuint vbo, GLuint ebo, size_t maxCachedRuns = 4096)
+            : fontManager(fontManager), renderer(renderer), VAO(vao), VBO(vbo), EBO(ebo), maxCachedRuns(maxCachedRuns),
+              cacheGeneration(fontManager.getGeneration()) {
+            // Anything queued against a page must be drawn before that page is overwritten
+            fontManager.setEvictionCallback([this]() { Flush(); });
+        }
+
+        ~FontRenderer() {
+            fontManager.setEvictionCallback(nullptr);
         }
 
+        FontRenderer(const FontRenderer&) = delete;
+        FontRenderer& operator=(const FontRenderer&) = delete;
+
+        // Draws a single string immediately; one draw call per atlas page it touches
         void RenderText(const std::string& text, float x, float y, float scale, const glm::vec3& color) {
-            // Activate the shader
-            renderer.GetShader()->Use();
-            renderer.GetShader()->SetUniform("textColor", color);
+            QueueText(text, x, y, scale, color);
+            Flush();
+        }
 
-            // Bind the VAO
-            glBindVertexArray(VAO);
+        // Appends a string to the pending batch. Static labels should keep cacheRun enabled so their
+        // layout is reused between frames; per-frame strings (timers, counters) should disable it.
+        void QueueText(const std::string& text, float x, float y, float scale, const glm::vec3& color, bool cacheRun = true) {
+            const std::uint32_t packedColor = PackColor(color);
+
+            if (cacheRun) {
+                AppendRun(GetGlyphRun(text), x, y, scale, packedColor);
+            }
+            else {
+                LayoutText(text, scratchRun);
+                AppendRun(scratchRun, x, y, scale, packedColor);
+            }
+        }
 
-            for (char c : text) {
-                const FontManager::Character& ch = fontManager.getCharacter(c);
+        // Submits every queued glyph with one draw call per atlas page and kMaxGlyphsPerBatch quads
+        void Flush() {
+            if (pendingQuads == 0) return;
 
-                float xpos = x + ch.bearing.x * scale;
-                float ypos = y - (ch.size.y - ch.bearing.y) * scale;
-                float w = ch.size.x * scale;
-                float h = ch.size.y * scale;
+            auto shader = renderer.GetShader();
+            shader->Use();
+            shader->SetUniform("isSDF", fontManager.getRenderMode() == GlyphRenderMode::SignedDistanceField);
 
-                // Update VBO with quad vertices
-                float vertices[6][4] = {
-                    { xpos, ypos + h, 0.0f, 0.0f },
-                    { xpos, ypos, 0.0f, 1.0f },
-                    { xpos + w, ypos, 1.0f, 1.0f },
-                    { xpos, ypos + h, 0.0f, 0.0f },
-                    { xpos + w, ypos, 1.0f, 1.0f },
-                    { xpos + w, ypos + h, 1.0f, 0.0f }
-                };
+            glActiveTexture(GL_TEXTURE0);
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-                glBindBuffer(GL_ARRAY_BUFFER, VBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+            for (size_t page = 0; page < pageBatches.size(); ++page) {
+                std::vector<GlyphVertex>& batch = pageBatches[page];
+                if (batch.empty()) continue;
 
-                // Bind EBO
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+                glBindTexture(GL_TEXTURE_2D, fontManager.getPageTexture(page));
+                metrics::Engine().stateChanges.Add();
 
-                // Render glyph texture over the quad
-                glBindTexture(GL_TEXTURE_2D, ch.textureID);
+                const size_t quadCount = batch.size() / 4;
+                for (size_t first = 0; first < quadCount; first += kMaxGlyphsPerBatch) {
+                    const size_t count = std::min(kMaxGlyphsPerBatch, quadCount - first);
 
-                // Draw the quad
-                //glDrawArrays(GL_TRIANGLES, 0, 6);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+                    // Orphan the previous contents so the driver does not stall on an in-flight draw
+                    glBufferData(GL_ARRAY_BUFFER, sizeof(GlyphVertex) * 4 * kMaxGlyphsPerBatch, nullptr, GL_STREAM_DRAW);
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GlyphVertex) * 4 * count, batch.data() + first * 4);
 
-                // Advance cursor for the next glyph
-                x += (ch.advance >> 6) * scale; // Bitshift by 6 to get pixel value
+                    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(count * 6), GL_UNSIGNED_INT, nullptr);
+                    metrics::Engine().uploadBytes.Add(sizeof(GlyphVertex) * 4 * count);
+                    metrics::Engine().drawCalls.Add();
+                }
+
+                batch.clear();
             }
+            pendingQuads = 0;
 
             // Unbind the VAO and texture
             glBindVertexArray(0);
             glBindTexture(GL_TEXTURE_2D, 0);
         }
 
+        const GlyphRun& GetGlyphRun(const std::string& text) {
+            // Evicted pages invalidate every cached UV
+            if (cacheGeneration != fontManager.getGeneration()) {
+                runCache.clear();
+                cacheGeneration = fontManager.getGeneration();
+            }
+
+            auto it = runCache.find(text);
+            if (it != runCache.end()) {
+                return it->second;
+            }
+
+            // Keep the cache bounded when callers feed it ever-changing strings
+            if (runCache.size() >= maxCachedRuns) {
+                runCache.clear();
+            }
+
+            GlyphRun& run = runCache[text];
+            LayoutText(text, run);
+            if (cacheGeneration != fontManager.getGeneration()) {
+                // Laying out this run evicted a page; everything else in the cache is stale now
+                GlyphRun fresh = std::move(run);
+                runCache.clear();
+                cacheGeneration = fontManager.getGeneration();
+                return runCache[text] = std::move(fresh);
+            }
+            return run;
+        }
+
+        void ClearRunCache() {
+            runCache.clear();
+        }
+
     private:
         FontManager& fontManager;
         Renderer& renderer;
         GLuint VAO;
         GLuint VBO;
         GLuint EBO;
-    };
+        size_t maxCachedRuns;
+        std::uint64_t cacheGeneration;
+
+        std::vector<std::vector<GlyphVertex>> pageBatches;
+        size_t pendingQuads = 0;
+        std::unordered_map<std::string, GlyphRun> runCache;
+        GlyphRun scratchRun;
+
+        static std::uint32_t PackColor(const glm::vec3& color) {
+            auto channel = [](float value) {
+                return static_cast<std::uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+            };
+            return channel(color.x) | (channel(color.y) << 8) | (channel(color.z) << 16) | (0xFFu << 24);
+        }
+
+        void LayoutText(const std::string& text, GlyphRun& run) {
+            // A glyph loaded late in the string can evict the page of an earlier one; lay out
+            // again until the run only references resident glyphs
+            for (size_t attempt = 0; attempt <= fontManager.getPageCount(); ++attempt) {
+                const std::uint64_t generation = fontManager.getGeneration();
+                LayoutTextOnce(text, run);
+                if (generation == fontManager.getGeneration()) return;
+            }
+            throw std::runtime_error("Text does not fit in the glyph atlas pages.");
+        }
+
+        void LayoutTextOnce(const std::string& text, GlyphRun& run) {
+            run.vertices.clear();
+            run.pages.clear();
+
+            float penX = 0.0f;
+            float penY = 0.0f;
+            float width = 0.0f;
+
+            for (size_t i = 0; i < text.size();) {
+                const char32_t codepoint = DecodeUtf8(text, i);
+                if (codepoint == U'\n') {
+                    width = std::max(width, penX);
+                    penX = 0.0f;
+                    penY -= fontManager.getLineHeight();
+                    continue;
+                }
+
+                const FontManager::Character& ch = fontManager.getCharacter(codepoint);
 
+                if (ch.size.x > 0 && ch.size.y > 0) {
+                    const float xpos = penX + ch.bearing.x;
+                    const float ypos = penY - (ch.size.y - ch.bearing.y);
+                    const float w = static_cast<float>(ch.size.x);
+                    const float h = static_cast<float>(ch.size.y);
+
+                    // Glyph bitmaps are stored top row first, so the top edge samples texCoordStart.y
+                    run.vertices.push_back({ xpos,     ypos + h, ch.texCoordStart.x, ch.texCoordStart.y, 0 });
+                    run.vertices.push_back({ xpos,     ypos,     ch.texCoordStart.x, ch.texCoordEnd.y,   0 });
+                    run.vertices.push_back({ xpos + w, ypos,     ch.texCoordEnd.x,   ch.texCoordEnd.y,   0 });
+                    run.vertices.push_back({ xpos + w, ypos + h, ch.texCoordEnd.x,   ch.texCoordStart.y, 0 });
+                    run.pages.push_back(ch.page);
+                }
+
+                // Advance cursor for the next glyph (already in pixels)
+                penX += static_cast<float>(ch.advance);
+            }
+
+            run.width = std::max(width, penX);
+        }
+
+        void AppendRun(const GlyphRun& run, float x, float y, float scale, std::uint32_t color) {
+            if (pageBatches.size() < fontManager.getPageCount()) {
+                pageBatches.resize(fontManager.getPageCount());
+            }
+
+            std::uint16_t lastPage = UINT16_MAX;
+            for (size_t quad = 0; quad < run.pages.size(); ++quad) {
+                const std::uint16_t page = run.pages[quad];
+                if (page != lastPage) {
+                    fontManager.touchPage(page);
+                    lastPage = page;
+                }
+
+                std::vector<GlyphVertex>& batch = pageBatches[page];
+                for (size_t corner = 0; corner < 4; ++corner) {
+                    const GlyphVertex& v = run.vertices[quad * 4 + corner];
+                    batch.push_back({ x + v.x * scale, y + v.y * scale, v.u, v.v, color });
+                }
+            }
+            pendingQuads += run.pages.size();
+        }
+    };
 
 }
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsMetrics.h"
 
 #include <string>
 #include <fstream>
@@ -37,6 +38,7 @@ namespace almond {
 
         void Use() const {
             glUseProgram(ID);
+            metrics::Engine().stateChanges.Add();
         }
 
         GLuint GetID() const {
@@ -1,30 +1,85 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsCompressedImage.h"
 #include "alsImageLoader.h"
+#include "alsMemoryTracker.h"
+#include "alsMetrics.h"
+#include "alsPixelKernels.h"
 #include "alsTexture.h"
 
 #ifdef ALMOND_USING_OPENGLTEXTURE
 
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <memory>
 
 namespace almond {
-    void GLAPIENTRY DebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
+    inline void GLAPIENTRY DebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
         std::cerr << "OpenGL Debug Output: " << message << std::endl;
     }
 
+    // Whether the current context can sample a compressed format, from its version and extensions
+    inline bool IsCompressedFormatSupported(CompressedFormat format) {
+        switch (format) {
+        case CompressedFormat::BC1:
+        case CompressedFormat::BC3: return GLAD_GL_EXT_texture_compression_s3tc != 0;
+        case CompressedFormat::BC7: return GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc;
+        case CompressedFormat::ETC2_RGB8:
+        case CompressedFormat::ETC2_RGBA8: return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_ES3_compatibility;
+        case CompressedFormat::ASTC_4x4: return GLAD_GL_KHR_texture_compression_astc_ldr != 0;
+        }
+        return false;
+    }
+
+    inline GLenum GetCompressedGLFormat(CompressedFormat format) {
+        switch (format) {
+        case CompressedFormat::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case CompressedFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case CompressedFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case CompressedFormat::ETC2_RGB8: return GL_COMPRESSED_RGB8_ETC2;
+        case CompressedFormat::ETC2_RGBA8: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case CompressedFormat::ASTC_4x4: return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+        }
+        return 0;
+    }
+
+    inline Texture::Format GetTextureFormat(CompressedFormat format) {
+        switch (format) {
+        case CompressedFormat::BC1: return Texture::Format::DXT1;
+        case CompressedFormat::BC3: return Texture::Format::DXT5;
+        case CompressedFormat::BC7: return Texture::Format::BC7;
+        case CompressedFormat::ETC2_RGB8:
+        case CompressedFormat::ETC2_RGBA8: return Texture::Format::ETC2;
+        case CompressedFormat::ASTC_4x4: return Texture::Format::ASTC;
+        }
+        return Texture::Format::RGBA8;
+    }
+
+    // Uploads every level of a compressed image into the bound texture, read straight from the
+    // image (usually its file mapping), or from the bound pixel-unpack buffer when the levels were
+    // packed into it back to back
+    inline void UploadCompressedLevels(const CompressedImage& image, bool fromUnpackBuffer = false) {
+        const GLenum internalFormat = GetCompressedGLFormat(image.GetFormat());
+        const auto& levels = image.GetLevels();
+        size_t packed = 0;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            const auto& level = levels[i];
+            const void* source = fromUnpackBuffer ? reinterpret_cast<const void*>(packed) : image.Data() + level.offset;
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), internalFormat, level.width, level.height, 0,
+                static_cast<GLsizei>(level.size), source);
+            packed += level.size;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size() - 1));
+    }
+
     class OpenGLTexture : public almond::Texture {
     public:
         OpenGLTexture() {}
         OpenGLTexture(const std::filesystem::path& filepath, Format format, bool generateMipmaps = true)
             : filepath(filepath), format(format), generateMipmaps(generateMipmaps)  {
             LoadTexture(filepath);
-
-            glEnable(GL_DEBUG_OUTPUT);
-            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-            glDebugMessageCallback(DebugCallback, nullptr);
         }
 
         ~OpenGLTexture() override {
@@ -45,6 +100,7 @@ namespace almond {
 
             glActiveTexture(GL_TEXTURE0 + slot);
             glBindTexture(GL_TEXTURE_2D, id);
+            metrics::Engine().stateChanges.Add();
 
             GLenum error = glGetError();
             if (error != GL_NO_ERROR) {
@@ -60,6 +116,7 @@ namespace almond {
         int GetHeight() const override { return height; }
         unsigned int GetID() const override { return id; }
         std::filesystem::path GetPath() const override { return filepath; }
+        Format GetFormat() const override { return format; }
 
         void SetFiltering(GLenum minFilter, GLenum magFilter) const override {
             glBindTexture(GL_TEXTURE_2D, id);
@@ -81,62 +138,94 @@ namespace almond {
         int height = 0;
         Format format = almond::Texture::Format::RGBA8;
         bool generateMipmaps = true;
-        ImageLoader::ImageData image;
         const std::filesystem::path filepath = "";
+        memory::TrackedBytes gpuBytes{ memory::Tag::Gpu };
 
-        void FlipImageVertically(unsigned char* data, int width, int height, int channels) {
-            int rowSize = width * channels;
-            std::vector<unsigned char> rowBuffer(rowSize);
-
-            for (int i = 0; i < height / 2; ++i) {
-                unsigned char* topRow = data + i * rowSize;
-                unsigned char* bottomRow = data + (height - i - 1) * rowSize;
-
-                // Swap the rows
-                std::memcpy(rowBuffer.data(), topRow, rowSize);
-                std::memcpy(topRow, bottomRow, rowSize);
-                std::memcpy(bottomRow, rowBuffer.data(), rowSize);
+        void LoadTexture(const std::filesystem::path& filepath) {
+            if (CompressedImage::IsCompressedFile(filepath)) {
+                LoadCompressedTexture(filepath);
+                return;
             }
-        }
 
-        void LoadTexture(const std::filesystem::path& filepath) {
-            image = ImageLoader::LoadAlmondImage(filepath.string().c_str());
+            // Bottom-up 32-bit bitmaps upload straight from the file mapping; nothing else is kept
+            // once the driver has its copy
+            auto image = ImageLoader::MapAlmondImage(filepath);
+            ImageLoader::SetRowOrder(image, true);
 
-            if (image.pixels.empty()) {
+            if (!image.pixels) {
                 throw std::runtime_error("Failed to load image: " + filepath.string());
             }
 
             width = image.width;
             height = image.height;
-            // Flip the image
-            FlipImageVertically(image.pixels.data(), width, height, image.channels);
             std::cout << "Loaded texture: " << filepath.string() << " (" << width << "x" << height << ")" << std::endl;
 
             glGenTextures(1, &id);
             glBindTexture(GL_TEXTURE_2D, id);
 
-            GLenum internalFormat = (image.channels == 4) ? GL_RGBA : GL_RGB;
-            GLenum dataFormat = (image.channels == 4) ? GL_RGBA : GL_RGB;
+            GLenum internalFormat = (image.channels == 4) ? GL_RGBA8 : GL_RGB8;
+            GLenum dataFormat = (image.channels == 4)
+                ? (image.order == ImageLoader::PixelOrder::BGRA ? GL_BGRA : GL_RGBA)
+                : GL_RGB;
             GLenum dataType = GL_UNSIGNED_BYTE;
 
-            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, dataType, image.pixels.data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(image.rowStride / image.channels));
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, dataType, image.pixels);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            // Without a mip filter the generated levels are never sampled, so only build them on request
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, generateMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-            // Generate mipmaps if needed
-            glGenerateMipmap(GL_TEXTURE_2D);
+            if (generateMipmaps) {
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
 
             GLenum error = glGetError();
             if (error != GL_NO_ERROR) {
                 throw std::runtime_error("OpenGL error during texture creation: " + std::to_string(error));
             }
+            gpuBytes.Set(memory::TextureBytes(width, height, image.channels == 4 ? 4 : 3, generateMipmaps));
 
             std::cout << "Texture loaded successfully." << std::endl;
         }
 
+        // DDS / KTX2: blocks go to the driver as stored, mip chain included. Mips are never generated
+        // here since drivers are not required to support that for compressed formats; bake them in.
+        void LoadCompressedTexture(const std::filesystem::path& filepath) {
+            CompressedImage image = CompressedImage::Load(filepath);
+            if (!IsCompressedFormatSupported(image.GetFormat())) {
+                throw std::runtime_error("Compressed texture format is not supported by this GPU: " + filepath.string());
+            }
+
+            width = image.GetWidth();
+            height = image.GetHeight();
+            format = GetTextureFormat(image.GetFormat());
+
+            glGenTextures(1, &id);
+            glBindTexture(GL_TEXTURE_2D, id);
+            UploadCompressedLevels(image);
+
+            const bool hasMips = image.GetLevels().size() > 1;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, hasMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            GLenum error = glGetError();
+            if (error != GL_NO_ERROR) {
+                throw std::runtime_error("OpenGL error during compressed texture creation: " + std::to_string(error));
+            }
+            gpuBytes.Set(image.SizeBytes());
+
+            std::cout << "Loaded compressed texture: " << filepath.string() << " (" << width << "x" << height << ", "
+                << image.GetLevels().size() << " levels)" << std::endl;
+        }
+
     };
 }
 
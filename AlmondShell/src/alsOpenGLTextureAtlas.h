@@ -2,18 +2,34 @@
 
 #include "alsEngineConfig.h"
 #include "alsImageLoader.h"  // Assuming ImageLoader is defined elsewhere
+#include "alsMemoryTracker.h"
+#include "alsMetrics.h"
 #include "alsOpenGLTexture.h"
 #include "alsTexture.h"
+#include "alsTextureAtlasPacker.h"
 
 #ifdef ALMOND_USING_OPENGLTEXTURE
 
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+
 namespace almond
 {
+    // Runtime-packed atlas. Each texture is surrounded by a gutter of its own extruded edge texels so
+    // bilinear filtering never reads a neighbour. With mipmaps on, placements are also aligned to
+    // 2^(mipLevels-1) texels with at least that much gutter, which keeps the first mipLevels levels
+    // bleed-free; mips are rebuilt lazily on the next Bind after the atlas changes.
     class OpenGLTextureAtlas : public almond::Texture {
     public:
-        OpenGLTextureAtlas(const std::filesystem::path& filepath = "../../assets/images/default.bmp", Format format = Format::RGBA8, bool generateMipmaps = true, GLuint initialWidth = 16384, GLuint initialHeight = 16384, GLuint maxSize = 32768)
-            : filepath(filepath), format(format), generateMipmaps(generateMipmaps), atlasWidth(initialWidth), atlasHeight(initialHeight), maxAtlasSize(maxSize) {
+        OpenGLTextureAtlas(const std::filesystem::path& filepath = "../../assets/images/default.bmp", Format format = Format::RGBA8, bool generateMipmaps = true, GLuint initialWidth = 16384, GLuint initialHeight = 16384, GLuint maxSize = 32768, int padding = 2, int mipLevels = 4)
+            : atlasWidth(initialWidth), atlasHeight(initialHeight), maxAtlasSize(maxSize), format(format), generateMipmaps(generateMipmaps),
+            padding(std::max(0, padding)), mipLevels(std::clamp(mipLevels, 1, 16)), filepath(filepath) {
+            ALMOND_MEMORY_TAG(Renderer);
             LoadAtlasTexture(filepath);
+            allocator = AtlasAllocator(atlasWidth, atlasHeight);
+            gpuBytes.Set(memory::TextureBytes(atlasWidth, atlasHeight, BytesPerTexel(), generateMipmaps));
         }
 
         ~OpenGLTextureAtlas() {
@@ -26,6 +42,11 @@ namespace almond
 
         void Bind(unsigned int slot = 0) const override {
             glBindTexture(GL_TEXTURE_2D, atlasID);
+            metrics::Engine().stateChanges.Add();
+            if (mipmapsDirty) {
+                glGenerateMipmap(GL_TEXTURE_2D);
+                mipmapsDirty = false;
+            }
         }
 
         void Unbind() const override {
@@ -105,24 +126,35 @@ namespace almond
         }
 
         std::tuple<int, int, int, int> TryAddTexture(const std::filesystem::path& filepath) {
+            ALMOND_MEMORY_TAG(Renderer);
             // Load the texture image
-            auto image = ImageLoader::LoadAlmondImage(filepath);
+            auto image = ImageLoader::MapAlmondImage(filepath);
+            ImageLoader::SetRowOrder(image, false);
 
-            if (!image.pixels.data()) {
+            if (!image.pixels) {
                 throw std::runtime_error("Failed to load image: " + filepath.string());
             }
 
 
-            // Find the best position for this texture in the atlas
-            auto [xOffset, yOffset, textureWidth, textureHeight] = PackTexture(image.width, image.height);
+            // Find the best position for this texture (plus its gutter) in the atlas
+            const int alignment = GetAlignment();
+            const int gutter = GetGutter();
+            auto [allocX, allocY, allocWidth, allocHeight] = PackTexture(
+                RoundUp(image.width + gutter * 2, alignment), RoundUp(image.height + gutter * 2, alignment));
 
             // If packing fails (e.g., no available space), return (-1, -1, -1, -1)
-            if (xOffset == -1 || yOffset == -1) {
+            if (allocX == -1 || allocY == -1) {
                 std::cerr << "Failed to find space for texture in atlas: " << filepath << std::endl;
                 return { -1, -1, -1, -1 };
             }
 
-            // Add the texture to the map
+            const int xOffset = allocX + gutter;
+            const int yOffset = allocY + gutter;
+            const int textureWidth = image.width;
+            const int textureHeight = image.height;
+
+            // Add the texture to the map; the allocator only ever sees the padded rect
+            allocations[filepath.string()] = { allocX, allocY, allocWidth, allocHeight };
             textureMap[filepath.string()] = { xOffset, yOffset, textureWidth, textureHeight };
 
             // add the texture to the stored atlas textures
@@ -135,13 +167,16 @@ namespace almond
             std::cout << "Texture Size: " << textureWidth << "x" << textureHeight << "\n";
 #endif
 
-            // Upload the texture to the atlas at the calculated position
+            // Upload the texture and its extruded gutter to the atlas at the calculated position
             glBindTexture(GL_TEXTURE_2D, atlasID);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, xOffset, yOffset,
-                textureWidth, textureHeight,
-                GL_RGBA, GL_UNSIGNED_BYTE,
-                image.pixels.data());
+            if (allocWidth == textureWidth && allocHeight == textureHeight) {
+                UploadView(image, xOffset, yOffset);
+            }
+            else {
+                UploadExtruded(image, allocX, allocY, allocWidth, allocHeight, gutter);
+            }
             glBindTexture(GL_TEXTURE_2D, 0);
+            mipmapsDirty = generateMipmaps;
 
             // Return the (x, y, width, height) position of the texture in the atlas
             return { xOffset, yOffset, textureWidth, textureHeight };
@@ -151,13 +186,6 @@ namespace almond
             // Store the texture position and dimensions in the texture map
             textureMap[filepath.string()] = { gridx, gridy, gridwidth, gridheight };
 
-            // Mark the space as occupied in the atlas (using a simple boolean grid to track space)
-            for (int i = gridx; i < gridx + gridwidth; ++i) {
-                for (int j = gridy; j < gridy + gridheight; ++j) {
-                    occupiedSpaces[i][j] = true;
-                }
-            }
-
             // Debugging info (optional)
 #ifdef _DEBUG
             std::cout << "Updated Atlas Data: " << filepath << " at position (" << gridx << ", " << gridy << ") with size "
@@ -165,10 +193,61 @@ namespace almond
 #endif
         }
 
-        std::vector<OpenGLTexture>& GetTextures() {
-            // Return the list of textures currently in the atlas
+        // Frees the texture's region for reuse; texels are left in place until overwritten
+        bool RemoveTexture(const std::filesystem::path& texturePath) {
+            auto it = allocations.find(texturePath.string());
+            if (it == allocations.end()) {
+                return false;
+            }
+
+            allocator.Remove(it->second);
+            textureMap.erase(it->first);
+            allocations.erase(it);
+            m_atlastextures.remove_if([&](const OpenGLTexture& texture) { return texture.GetPath() == texturePath; });
+            return true;
         }
 
+        // Repacks all live textures to reclaim space fragmented by removals. Texels are moved on the
+        // GPU into a fresh texture, so nothing is read back. Returns the number of textures moved.
+        size_t Defragment() {
+            auto moves = allocator.Defragment();
+            if (moves.empty()) {
+                return 0;
+            }
+
+            GLuint newAtlasID = CreateAtlasStorage(atlasWidth, atlasHeight);
+
+            // Whole padded rects move, so gutters come along and the alignment is preserved
+            for (auto& [path, allocation] : allocations) {
+                AtlasRect target = allocation;
+                for (const auto& [from, to] : moves) {
+                    if (from == allocation) {
+                        target = to;
+                        break;
+                    }
+                }
+
+                CopyRegion(atlasID, allocation.x, allocation.y, newAtlasID, target.x, target.y, allocation.width, allocation.height);
+
+                auto& [x, y, w, h] = textureMap[path];
+                x += target.x - allocation.x;
+                y += target.y - allocation.y;
+                allocation = target;
+            }
+
+            glDeleteTextures(1, &atlasID);
+            atlasID = newAtlasID;
+            mipmapsDirty = generateMipmaps;
+
+            return moves.size();
+        }
+
+        std::list<OpenGLTexture>& GetTextures() {
+            return m_atlastextures;
+        }
+
+        float GetOccupancy() const { return allocator.GetOccupancy(); }
+
         std::tuple<int, int, int, int> GetAtlasTextureMap(const std::string& texturePath) const {
             auto it = textureMap.find(texturePath);
             if (it != textureMap.end()) return it->second;
@@ -189,57 +268,71 @@ namespace almond
         GLuint atlasWidth = 16384;
         GLuint atlasHeight = 16384;
         GLuint maxAtlasSize = 32768; // Maximum size of the atlas (e.g., 32768 for 32k)
+        GLenum internalFormat = GL_RGBA;
+        GLenum dataFormat = GL_RGBA;
 
-        std::vector<OpenGLTexture> m_atlastextures;
-        std::unordered_map<std::string, std::tuple<int, int, int, int>> textureMap;
+        // A list so entries never relocate: OpenGLTexture owns its GL name and cannot be reassigned
+        std::list<OpenGLTexture> m_atlastextures;
+        std::unordered_map<std::string, std::tuple<int, int, int, int>> textureMap; // Inner rects, used for UVs
+        std::unordered_map<std::string, AtlasRect> allocations; // Padded rects owned by the allocator
         Format format = almond::Texture::Format::RGBA8;
         bool generateMipmaps = true;
-        ImageLoader::ImageData image;
+        int padding = 2;
+        int mipLevels = 4;
+        mutable bool mipmapsDirty = false;
         const std::filesystem::path filepath = "";
 
-        // Simple texture packing algorithm (MaxRects)
-        std::vector<std::vector<bool>> occupiedSpaces = std::vector<std::vector<bool>>(atlasWidth, std::vector<bool>(atlasHeight, false));
+        AtlasAllocator allocator = AtlasAllocator(0, 0); // Sized once the backing image is loaded
+        memory::TrackedBytes gpuBytes{ memory::Tag::Gpu };
+
+        static int RoundUp(int value, int multiple) {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        // Padded sizes are multiples of this, so every placement lands on a texel at each mip level
+        int GetAlignment() const {
+            return generateMipmaps ? 1 << (mipLevels - 1) : 1;
+        }
+
+        int GetGutter() const {
+            const int alignment = GetAlignment();
+            return generateMipmaps ? RoundUp(std::max(padding, alignment), alignment) : padding;
+        }
+
+        // Sampling state for the bound atlas texture
+        void ApplySampling() const {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, generateMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, generateMipmaps ? mipLevels - 1 : 0);
+        }
 
-        // Simple texture packing algorithm (MaxRects)
         std::tuple<int, int, int, int> PackTexture(GLuint texWidth, GLuint texHeight) {
-            if (texWidth > atlasWidth || texHeight > atlasHeight) {
+            if (texWidth > maxAtlasSize || texHeight > maxAtlasSize) {
                 throw std::runtime_error("Texture is too large for the current atlas size.");
             }
 
-            // Find a space for the new texture
-            for (GLuint y = 0; y + texHeight <= atlasHeight; ++y) {
-                for (GLuint x = 0; x + texWidth <= atlasWidth; ++x) {
-                    // Check if the space is free
-                    if (IsFreeSpace(x, y, texWidth, texHeight)) {
-                        // Texture fits, add it to the map and return its position
-                        return { x, y, texWidth, texHeight };
-                    }
+            while (true) {
+                AtlasRect rect = allocator.Insert(static_cast<int>(texWidth), static_cast<int>(texHeight));
+                if (rect.IsValid()) {
+                    return { rect.x, rect.y, rect.width, rect.height };
                 }
-            }
-
-            // If no space is available, resize the atlas
-            ResizeAtlas();
-            return PackTexture(texWidth, texHeight); // Retry packing in the resized atlas
-        }
 
-        bool IsFreeSpace(GLuint x, GLuint y, GLuint texWidth, GLuint texHeight) {
-            for (GLuint ty = y; ty < y + texHeight; ++ty) {
-                for (GLuint tx = x; tx < x + texWidth; ++tx) {
-                    if (textureMap.find(std::to_string(tx) + "_" + std::to_string(ty)) != textureMap.end()) {
-                        return false; // Space is already occupied
-                    }
+                // Out of room: grow the atlas, or give up once it has reached its maximum size
+                if (!ResizeAtlas()) {
+                    return { -1, -1, -1, -1 };
                 }
             }
-            return true; // The space is free
         }
 
-        void ResizeAtlas() 
+        // Grows the atlas entirely on the GPU: the old texels are copied into the new storage, so the
+        // CPU never touches (or allocates) the atlas contents and placements stay where they were.
+        bool ResizeAtlas()
         {
-            // Cache the atlas texture data before resizing
-            std::vector<unsigned char> cache(atlasWidth * atlasHeight * 4); // Assuming 4 channels (RGBA)
-            glBindTexture(GL_TEXTURE_2D, atlasID);
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, cache.data());
-            glBindTexture(GL_TEXTURE_2D, 0);
+            if (atlasWidth >= maxAtlasSize && atlasHeight >= maxAtlasSize) {
+                return false;
+            }
 
             // Double the atlas size, but don't exceed the maximum size
             GLuint newWidth = atlasWidth * 2;
@@ -249,39 +342,121 @@ namespace almond
             if (newWidth > maxAtlasSize) newWidth = maxAtlasSize;
             if (newHeight > maxAtlasSize) newHeight = maxAtlasSize;
 
+#ifdef _DEBUG
             std::cout << "Resizing Atlas: " << atlasWidth << "x" << atlasHeight << " -> " << newWidth << "x" << newHeight << std::endl;
+#endif
 
-            // Create a new texture with the resized dimensions
-            GLuint newAtlasID;
-            glGenTextures(1, &newAtlasID);
-            glBindTexture(GL_TEXTURE_2D, newAtlasID);
+            GLuint newAtlasID = CreateAtlasStorage(newWidth, newHeight);
+            CopyRegion(atlasID, 0, 0, newAtlasID, 0, 0, atlasWidth, atlasHeight);
 
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, newWidth, newHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, cache.data());
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glDeleteTextures(1, &atlasID);
+            atlasID = newAtlasID;
+
+            atlasWidth = newWidth;
+            atlasHeight = newHeight;
+            mipmapsDirty = generateMipmaps;
+            gpuBytes.Set(memory::TextureBytes(atlasWidth, atlasHeight, BytesPerTexel(), generateMipmaps));
+
+            // Existing placements stay put; the new area becomes free space
+            allocator.Grow(static_cast<int>(atlasWidth), static_cast<int>(atlasHeight));
+            return true;
+        }
 
-            // Transfer old textures to the new atlas
-            for (const auto& [path, texData] : textureMap) {
-                auto [x, y, w, h] = texData;
-                glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // Here you should transfer the texture data
+        // GPU-to-GPU copy of level 0. Uses glCopyImageSubData where available (GL 4.3 /
+        // ARB_copy_image), otherwise reads the source through a framebuffer.
+        static void CopyRegion(GLuint src, int srcX, int srcY, GLuint dst, int dstX, int dstY, int width, int height) {
+            if (GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_copy_image) {
+                glCopyImageSubData(src, GL_TEXTURE_2D, 0, srcX, srcY, 0,
+                    dst, GL_TEXTURE_2D, 0, dstX, dstY, 0, width, height, 1);
+                return;
             }
 
+            GLint previousReadFramebuffer = 0;
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+
+            GLuint fbo;
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src, 0);
+
+            glBindTexture(GL_TEXTURE_2D, dst);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dstX, dstY, srcX, srcY, width, height);
             glBindTexture(GL_TEXTURE_2D, 0);
 
-            // Delete old atlas texture
-            glDeleteTextures(1, &atlasID);
-            atlasID = newAtlasID;
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFramebuffer);
+            glDeleteFramebuffers(1, &fbo);
+        }
 
-            atlasWidth = newWidth;
-            atlasHeight = newHeight;
+        std::uint64_t BytesPerTexel() const {
+            return internalFormat == GL_RGB ? 3 : 4;
+        }
+
+        // Every level up to GL_TEXTURE_MAX_LEVEL is allocated so the texture is mipmap-complete
+        // before anything is copied into it; strict drivers reject glCopyImageSubData otherwise
+        GLuint CreateAtlasStorage(GLuint width, GLuint height) const {
+            GLuint id;
+            glGenTextures(1, &id);
+            glBindTexture(GL_TEXTURE_2D, id);
+
+            const int levels = generateMipmaps ? mipLevels : 1;
+            for (int level = 0; level < levels; ++level) {
+                glTexImage2D(GL_TEXTURE_2D, level, internalFormat, std::max(1u, width >> level), std::max(1u, height >> level), 0,
+                    dataFormat, GL_UNSIGNED_BYTE, nullptr);
+            }
+            ApplySampling();
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return id;
+        }
+
+        // Sub-image upload of a view into the bound texture; the view may still point into a file mapping
+        static void UploadView(const ImageLoader::ImageView& image, int x, int y) {
+            GLenum format = (image.channels == 4)
+                ? (image.order == ImageLoader::PixelOrder::BGRA ? GL_BGRA : GL_RGBA)
+                : GL_RGB;
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(image.rowStride / image.channels));
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, image.width, image.height, format, GL_UNSIGNED_BYTE, image.pixels);
+            metrics::Engine().uploadBytes.Add(static_cast<std::uint64_t>(image.width) * image.height * image.channels);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+
+        // Copies the view into a padded buffer whose gutter repeats the view's edge texels, then
+        // uploads the whole allocation in one call
+        static void UploadExtruded(const ImageLoader::ImageView& image, int x, int y, int width, int height, int gutter) {
+            const size_t texelBytes = static_cast<size_t>(image.channels);
+            std::vector<uint8_t> padded(static_cast<size_t>(width) * height * texelBytes);
+
+            for (int row = 0; row < height; ++row) {
+                const int sourceRow = std::clamp(row - gutter, 0, image.height - 1);
+                const uint8_t* src = image.pixels + static_cast<size_t>(sourceRow) * image.rowStride;
+                uint8_t* dst = &padded[static_cast<size_t>(row) * width * texelBytes];
+
+                for (int column = 0; column < gutter; ++column) {
+                    std::memcpy(dst + column * texelBytes, src, texelBytes);
+                }
+                std::memcpy(dst + gutter * texelBytes, src, image.width * texelBytes);
+                const uint8_t* lastTexel = src + (image.width - 1) * texelBytes;
+                for (int column = gutter + image.width; column < width; ++column) {
+                    std::memcpy(dst + column * texelBytes, lastTexel, texelBytes);
+                }
+            }
+
+            GLenum format = (image.channels == 4)
+                ? (image.order == ImageLoader::PixelOrder::BGRA ? GL_BGRA : GL_RGBA)
+                : GL_RGB;
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, padded.data());
+            metrics::Engine().uploadBytes.Add(padded.size());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         }
 
         void LoadAtlasTexture(const std::filesystem::path& filepath) {
-            image = ImageLoader::LoadAlmondImage(filepath.string().c_str());
+            auto image = ImageLoader::MapAlmondImage(filepath);
+            ImageLoader::SetRowOrder(image, false);
 
-            if (image.pixels.empty()) {
+            if (!image.pixels) {
                 throw std::runtime_error("Failed to load image: " + filepath.string());
             }
 
@@ -291,16 +466,13 @@ namespace almond
             glGenTextures(1, &atlasID);
             glBindTexture(GL_TEXTURE_2D, atlasID);
 
-            GLenum internalFormat = (image.channels == 4) ? GL_RGBA : GL_RGB;
-            GLenum dataFormat = (image.channels == 4) ? GL_RGBA : GL_RGB;
+            internalFormat = (image.channels == 4) ? GL_RGBA : GL_RGB;
+            dataFormat = (image.channels == 4) ? GL_RGBA : GL_RGB;
             GLenum dataType = GL_UNSIGNED_BYTE;
 
-            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, atlasWidth, atlasHeight, 0, dataFormat, dataType, image.pixels.data());
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, atlasWidth, atlasHeight, 0, dataFormat, dataType, nullptr);
+            UploadView(image, 0, 0);
+            ApplySampling();
 
             if (generateMipmaps) {
                 glGenerateMipmap(GL_TEXTURE_2D);
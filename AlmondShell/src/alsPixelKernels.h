@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Instruction sets are picked at compile time: AVX2 when the compiler targets it, SSSE3 for the
+// byte shuffles, SSE2 (always present on x64) otherwise, with scalar loops for everything else.
+#if defined(__AVX2__)
+#define ALMOND_PIXEL_AVX2 1
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define ALMOND_PIXEL_SSSE3 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ALMOND_PIXEL_SSE2 1
+#endif
+
+#if defined(ALMOND_PIXEL_AVX2)
+#include <immintrin.h>
+#elif defined(ALMOND_PIXEL_SSSE3)
+#include <tmmintrin.h>
+#elif defined(ALMOND_PIXEL_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace almond {
+namespace pixel {
+
+    // 3-byte pixels to 4-byte pixels with opaque alpha. swapRedBlue turns BGR input into RGBA.
+    inline void ExpandRGBToRGBA(const std::uint8_t* src, std::uint8_t* dst, size_t pixelCount, bool swapRedBlue = false) {
+        size_t i = 0;
+#if defined(ALMOND_PIXEL_SSSE3)
+        const __m128i shuffle = swapRedBlue
+            ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+            : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+        // 16 pixels per iteration: three 16-byte loads in, four 16-byte stores out
+        for (; i + 16 <= pixelCount; i += 16) {
+            const std::uint8_t* s = src + i * 3;
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+
+            __m128i p0 = _mm_shuffle_epi8(a, shuffle);
+            __m128i p1 = _mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle);
+            __m128i p2 = _mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle);
+            __m128i p3 = _mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle);
+
+            std::uint8_t* d = dst + i * 4;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_or_si128(p0, alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16), _mm_or_si128(p1, alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 32), _mm_or_si128(p2, alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 48), _mm_or_si128(p3, alpha));
+        }
+#endif
+        const int r = swapRedBlue ? 2 : 0;
+        const int b = swapRedBlue ? 0 : 2;
+        for (; i < pixelCount; ++i) {
+            dst[i * 4 + 0] = src[i * 3 + r];
+            dst[i * 4 + 1] = src[i * 3 + 1];
+            dst[i * 4 + 2] = src[i * 3 + b];
+            dst[i * 4 + 3] = 255;
+        }
+    }
+
+    // RGBA <-> BGRA in place
+    inline void SwapRedBlue32(std::uint8_t* pixels, size_t pixelCount) {
+        size_t i = 0;
+#if defined(ALMOND_PIXEL_AVX2)
+        const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for (; i + 8 <= pixelCount; i += 8) {
+            auto* p = reinterpret_cast<__m256i*>(pixels + i * 4);
+            _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), shuffle));
+        }
+#elif defined(ALMOND_PIXEL_SSE2)
+        // No byte shuffle in SSE2: swap the outer bytes of each 32-bit lane with shifts and masks
+        const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+        const __m128i low = _mm_set1_epi32(0x000000FF);
+        for (; i + 4 <= pixelCount; i += 4) {
+            auto* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+            __m128i v = _mm_loadu_si128(p);
+            __m128i red = _mm_and_si128(v, low);
+            __m128i blue = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+            v = _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(_mm_slli_epi32(red, 16), blue));
+            _mm_storeu_si128(p, v);
+        }
+#endif
+        for (; i < pixelCount; ++i) {
+            std::uint8_t* p = pixels + i * 4;
+            std::uint8_t t = p[0];
+            p[0] = p[2];
+            p[2] = t;
+        }
+    }
+
+    // BGR <-> RGB in place
+    inline void SwapRedBlue24(std::uint8_t* pixels, size_t pixelCount) {
+        size_t i = 0;
+#if defined(ALMOND_PIXEL_SSSE3)
+        // 16 bytes hold five whole pixels; the 16th byte is rewritten unchanged
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+        for (; i + 6 <= pixelCount; i += 5) {
+            auto* p = reinterpret_cast<__m128i*>(pixels + i * 3);
+            _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle));
+        }
+#endif
+        for (; i < pixelCount; ++i) {
+            std::uint8_t* p = pixels + i * 3;
+            std::uint8_t t = p[0];
+            p[0] = p[2];
+            p[2] = t;
+        }
+    }
+
+    // Swaps rows top to bottom in place without a scratch row
+    inline void FlipVertically(std::uint8_t* data, int width, int height, int channels) {
+        const size_t rowSize = static_cast<size_t>(width) * channels;
+        for (int y = 0; y < height / 2; ++y) {
+            std::uint8_t* top = data + y * rowSize;
+            std::uint8_t* bottom = data + (height - 1 - y) * rowSize;
+            size_t x = 0;
+#if defined(ALMOND_PIXEL_AVX2)
+            for (; x + 32 <= rowSize; x += 32) {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + x));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + x));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(top + x), b);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(bottom + x), a);
+            }
+#elif defined(ALMOND_PIXEL_SSE2)
+            for (; x + 16 <= rowSize; x += 16) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(top + x), b);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(bottom + x), a);
+            }
+#endif
+            for (; x < rowSize; ++x) {
+                std::uint8_t t = top[x];
+                top[x] = bottom[x];
+                bottom[x] = t;
+            }
+        }
+    }
+
+    // color = color * alpha / 255, rounded; alpha is left as is
+    inline void PremultiplyAlpha(std::uint8_t* pixels, size_t pixelCount) {
+        size_t i = 0;
+#if defined(ALMOND_PIXEL_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(128);
+        const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+        // Multiplies two pixels widened to 16 bits; x/255 computed exactly as (t + (t >> 8)) >> 8
+        auto multiply = [&](__m128i px) {
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_or_si128(_mm_andnot_si128(alphaLanes, alpha), alphaOne);
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, alpha), bias);
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        };
+
+        for (; i + 4 <= pixelCount; i += 4) {
+            auto* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+            __m128i v = _mm_loadu_si128(p);
+            __m128i lo = multiply(_mm_unpacklo_epi8(v, zero));
+            __m128i hi = multiply(_mm_unpackhi_epi8(v, zero));
+            _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; i < pixelCount; ++i) {
+            std::uint8_t* p = pixels + i * 4;
+            const unsigned a = p[3];
+            for (int c = 0; c < 3; ++c) {
+                unsigned t = p[c] * a + 128;
+                p[c] = static_cast<std::uint8_t>((t + (t >> 8)) >> 8);
+            }
+        }
+    }
+
+    // dst[i] += src[i], bytewise; used for PNG "Up" rows
+    inline void AddBytes(std::uint8_t* dst, const std::uint8_t* src, size_t count) {
+        size_t i = 0;
+#if defined(ALMOND_PIXEL_AVX2)
+        for (; i + 32 <= count; i += 32) {
+            auto* d = reinterpret_cast<__m256i*>(dst + i);
+            _mm256_storeu_si256(d, _mm256_add_epi8(_mm256_loadu_si256(d), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+        }
+#endif
+#if defined(ALMOND_PIXEL_SSE2)
+        for (; i + 16 <= count; i += 16) {
+            auto* d = reinterpret_cast<__m128i*>(dst + i);
+            _mm_storeu_si128(d, _mm_add_epi8(_mm_loadu_si128(d), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+        }
+#endif
+        for (; i < count; ++i) {
+            dst[i] = static_cast<std::uint8_t>(dst[i] + src[i]);
+        }
+    }
+
+} // namespace pixel
+} // namespace almond
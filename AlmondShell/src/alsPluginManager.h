@@ -1,16 +1,30 @@
 #pragma once
 
+#include "alsEventSystem.h"
 #include "alsIPlugin.h"
 #include "alsLogger.h"
+#include "alsMappedFile.h"
+#include "alsMemoryTracker.h"
 #include "alsPluginConcept.h"
+#include "alsProfiler.h"
 #include "alsRobustTime.h"
+#include "alsThreadPool.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <ranges>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #ifdef _WIN32
@@ -32,6 +46,16 @@ namespace almond::plugin {
     class PluginManager {
     public:
         using PluginFactoryFunc = IPlugin * (*)();
+        using PluginInfoFunc = const PluginInfo * (*)();
+        using PluginHooksFunc = bool (*)(std::uint32_t abiVersion, IPlugin* plugin, PluginHooks* hooks);
+
+#if defined(_WIN32)
+        static constexpr const char* kLibraryExtension = ".dll";
+#elif defined(__APPLE__)
+        static constexpr const char* kLibraryExtension = ".dylib";
+#else
+        static constexpr const char* kLibraryExtension = ".so";
+#endif
 
         // Constructor with a robust time system
         explicit PluginManager(const std::string& logFileName, almond::RobustTime& timeSystem)
@@ -42,47 +66,83 @@ namespace almond::plugin {
             UnloadAllPlugins();
         }
 
-        // Load a plugin
+        // Load a plugin. Its dependencies must already be loaded. Safe to call from several threads.
         bool LoadPlugin(const std::filesystem::path& path) {
             logger.log("Attempting to load plugin: " + path.string());
 
-            // Load the shared library
-            PluginHandle handle = LoadSharedLibrary(path);
-            if (!handle) {
-                logger.log("ERROR: Failed to load plugin: " + path.string());
-                return false;
+            Candidate candidate(path);
+            OpenLibrary(candidate);
+            return Instantiate(candidate);
+        }
+
+        // Loads every plugin library in a directory. The libraries are read, opened and their
+        // metadata resolved concurrently on the job system (serially without one); plugins are then
+        // created and initialized on this thread so that each one's dependencies are initialized
+        // before it. Plugins with a missing or failed dependency, or in a dependency cycle, are
+        // skipped and logged. Returns the number loaded.
+        size_t LoadPluginsFromDirectory(const std::filesystem::path& directory, ThreadPool* jobSystem = nullptr) {
+            ALMOND_PROFILE_SCOPE("Load plugins");
+            logger.log("Loading plugins from: " + directory.string());
+
+            std::vector<Candidate> candidates;
+            std::error_code error;
+            for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+                if (entry.is_regular_file() && entry.path().extension() == kLibraryExtension) {
+                    candidates.emplace_back(entry.path());
+                }
+            }
+            if (error) {
+                logger.log("ERROR: Failed to read plugin directory: " + directory.string() + " (" + error.message() + ")");
+                return 0;
             }
+            std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.path < b.path; });
 
-            // Get the plugin factory function
-            auto factory = reinterpret_cast<PluginFactoryFunc>(GetSymbol(handle, "CreatePlugin"));
-            if (!factory) {
-                logger.log("ERROR: Missing entry point in plugin: " + path.string());
-                CloseLibrary(handle);
-                return false;
+            if (jobSystem) {
+                jobSystem->parallelFor(candidates.size(), [&candidates](size_t i) { OpenLibrary(candidates[i]); });
+            }
+            else {
+                for (Candidate& candidate : candidates) OpenLibrary(candidate);
             }
 
-            // Create the plugin instance
-            std::unique_ptr<IPlugin> plugin(factory());
-            if (plugin) {
-                plugin->Initialize();
-                plugins.emplace_back(std::move(plugin), handle);
-                logger.log("Successfully loaded plugin: " + path.string());
-                return true;
+            size_t loaded = 0;
+            for (size_t index : InitializationOrder(candidates)) {
+                loaded += Instantiate(candidates[index]) ? 1 : 0;
             }
+            logger.log("Loaded " + std::to_string(loaded) + " of " + std::to_string(candidates.size()) + " plugins from: " + directory.string());
+            return loaded;
+        }
+
+        // Per-frame hooks. Thread-safe plugins run first, split into one batch per worker (plus the
+        // caller) when a job system is given; the rest then run on this thread in initialization
+        // order. Plugins must not be unloaded while a dispatch is running on another thread.
+        void Update(float deltaTime, ThreadPool* jobSystem = nullptr) {
+            Dispatch(&HookTables::update, jobSystem, deltaTime);
+        }
 
-            CloseLibrary(handle);
-            logger.log("ERROR: Failed to create plugin instance: " + path.string());
-            return false;
+        void FixedUpdate(float fixedDeltaTime, ThreadPool* jobSystem = nullptr) {
+            Dispatch(&HookTables::fixedUpdate, jobSystem, fixedDeltaTime);
         }
 
-        // Unload all plugins
+        void DispatchEvent(const Event& event, ThreadPool* jobSystem = nullptr) {
+            const PluginEvent flat{ static_cast<std::uint32_t>(event.type), event.x, event.y, event.key, { event.text[0], event.text[1] } };
+            Dispatch(&HookTables::onEvent, jobSystem, &flat);
+        }
+
+        // Unload all plugins, dependents before their dependencies
         void UnloadAllPlugins() {
             logger.log("Unloading all plugins...");
 
+            std::vector<LoadedPlugin> unloading;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                unloading.swap(plugins);
+                RebuildHookTables();
+            }
+
             // Reverse iteration using std::ranges
-            for (auto& [plugin, handle] : plugins | std::views::reverse) {
+            for (auto& [name, plugin, handle, hooks] : unloading | std::views::reverse) {
                 if (plugin) {
-                    logger.log("Shutting down plugin...");
+                    logger.log("Shutting down plugin: " + name);
                     plugin->Shutdown();
                 }
 
@@ -93,14 +153,276 @@ namespace almond::plugin {
                 }
             }
 
-            plugins.clear();
             logger.log("All plugins unloaded.");
         }
 
+        IPlugin* GetPlugin(std::string_view name) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const LoadedPlugin& plugin : plugins) {
+                if (plugin.name == name) return plugin.instance.get();
+            }
+            return nullptr;
+        }
+
+        size_t GetPluginCount() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return plugins.size();
+        }
+
     private:
-        std::vector<std::pair<std::unique_ptr<IPlugin>, PluginHandle>> plugins;
+        struct LoadedPlugin {
+            std::string name;
+            std::unique_ptr<IPlugin> instance;
+            PluginHandle handle;
+            PluginHooks hooks;
+        };
+
+        // Flat copies of every loaded plugin's hooks, split by whether they may run in parallel
+        template <typename... Args>
+        struct HookTable {
+            struct Call {
+                void (*function)(void* context, Args...);
+                void* context;
+            };
+            std::vector<Call> parallel;
+            std::vector<Call> serial;
+        };
+
+        struct HookTables {
+            HookTable<float> update;
+            HookTable<float> fixedUpdate;
+            HookTable<const PluginEvent*> onEvent;
+        };
+
+        // A library that has been opened but whose plugin has not been created yet
+        struct Candidate {
+            explicit Candidate(std::filesystem::path path) : path(std::move(path)) {}
+
+            std::filesystem::path path;
+            PluginHandle handle = nullptr;
+            PluginFactoryFunc factory = nullptr;
+            PluginHooksFunc getHooks = nullptr;
+            std::string name;
+            std::string version;
+            std::vector<std::string> dependencies;
+            std::string error;  // Set, with handle null, when the library could not be used
+        };
+
+        std::vector<LoadedPlugin> plugins;  // In initialization order
+        std::shared_ptr<const HookTables> hookTables = std::make_shared<HookTables>();  // Rebuilt whenever plugins changes
+        std::unordered_set<std::string> loadingNames;  // Plugins being created and initialized
+        mutable std::mutex mutex;           // Guards plugins, hookTables and loadingNames
         almond::Logger& logger;            // Shared Logger instance
         almond::RobustTime& timeSystem;    // Reference to RobustTime
+
+        // Runs on workers: touches nothing but the candidate
+        static void OpenLibrary(Candidate& candidate) {
+            ALMOND_PROFILE_SCOPE("Open plugin");
+            ALMOND_MEMORY_TAG(Plugins);
+
+            // The loader holds a process-wide lock while it maps and relocates a library, so pull the
+            // file into the page cache first; these reads overlap across workers instead of queueing
+            // behind the lock. Failures are left for the loader to report.
+            try {
+                MappedFile file(candidate.path);
+                file.Prefetch(0, file.size());
+            }
+            catch (const std::exception&) {}
+
+            candidate.handle = LoadSharedLibrary(candidate.path);
+            if (!candidate.handle) {
+                candidate.error = "Failed to load plugin";
+                return;
+            }
+
+            candidate.factory = reinterpret_cast<PluginFactoryFunc>(GetSymbol(candidate.handle, "CreatePlugin"));
+            if (!candidate.factory) {
+                candidate.error = "Missing entry point in plugin";
+                CloseLibrary(candidate.handle);
+                candidate.handle = nullptr;
+                return;
+            }
+
+            candidate.getHooks = reinterpret_cast<PluginHooksFunc>(GetSymbol(candidate.handle, "GetPluginHooks"));
+            auto getInfo = reinterpret_cast<PluginInfoFunc>(GetSymbol(candidate.handle, "GetPluginInfo"));
+            const PluginInfo* info = getInfo ? getInfo() : nullptr;
+            candidate.name = (info && info->name) ? info->name : candidate.path.stem().string();
+            candidate.version = (info && info->version) ? info->version : "";
+            if (info && info->dependencies) {
+                for (size_t i = 0; i < info->dependencyCount; ++i) {
+                    if (info->dependencies[i]) candidate.dependencies.emplace_back(info->dependencies[i]);
+                }
+            }
+        }
+
+        // Kahn's algorithm over the dependencies between candidates, taking ready candidates in path
+        // order so startup is deterministic. Dependencies outside the set are checked when each
+        // plugin is created. Candidates left in a cycle are marked failed and left out.
+        std::vector<size_t> InitializationOrder(std::vector<Candidate>& candidates) {
+            std::unordered_map<std::string_view, size_t> byName;
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (!candidates[i].handle) continue;
+                if (!byName.emplace(candidates[i].name, i).second) {
+                    candidates[i].error = "Duplicate plugin name '" + candidates[i].name + "'";
+                    CloseLibrary(candidates[i].handle);
+                    candidates[i].handle = nullptr;
+                }
+            }
+
+            std::vector<size_t> pendingDependencies(candidates.size(), 0);
+            std::vector<std::vector<size_t>> dependents(candidates.size());
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (!candidates[i].handle) continue;
+                for (const std::string& dependency : candidates[i].dependencies) {
+                    auto it = byName.find(dependency);
+                    if (it != byName.end() && candidates[it->second].handle) {
+                        ++pendingDependencies[i];
+                        dependents[it->second].push_back(i);
+                    }
+                }
+            }
+
+            std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (pendingDependencies[i] == 0) ready.push(i); // Failed candidates too, so their errors get logged
+            }
+
+            std::vector<size_t> order;
+            order.reserve(candidates.size());
+            while (!ready.empty()) {
+                const size_t next = ready.top();
+                ready.pop();
+                order.push_back(next);
+                for (size_t dependent : dependents[next]) {
+                    if (--pendingDependencies[dependent] == 0) ready.push(dependent);
+                }
+            }
+
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (pendingDependencies[i] == 0) continue;
+                candidates[i].error = "Dependency cycle involving '" + candidates[i].name + "'";
+                CloseLibrary(candidates[i].handle);
+                candidates[i].handle = nullptr;
+                order.push_back(i);
+            }
+            return order;
+        }
+
+        // Creates and initializes an opened candidate, or logs why it cannot be and closes it
+        bool Instantiate(Candidate& candidate) {
+            ALMOND_MEMORY_TAG(Plugins); // Covers the plugin's own allocations in CreatePlugin and Initialize
+            if (!candidate.handle) {
+                logger.log("ERROR: " + candidate.error + ": " + candidate.path.string());
+                return false;
+            }
+
+            // The name is claimed until the plugin is registered, so concurrent loads of the same
+            // plugin cannot both pass this check while the first one is still initializing
+            bool claimed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                const bool loaded = std::ranges::any_of(plugins, [&](const LoadedPlugin& plugin) { return plugin.name == candidate.name; });
+                claimed = !loaded && loadingNames.insert(candidate.name).second;
+            }
+            if (!claimed) {
+                logger.log("ERROR: A plugin named '" + candidate.name + "' is already loaded: " + candidate.path.string());
+                CloseLibrary(candidate.handle);
+                candidate.handle = nullptr;
+                return false;
+            }
+            struct NameClaim {
+                PluginManager& manager;
+                const std::string& name;
+                ~NameClaim() {
+                    std::lock_guard<std::mutex> lock(manager.mutex);
+                    manager.loadingNames.erase(name);
+                }
+            } claim{ *this, candidate.name };
+
+            for (const std::string& dependency : candidate.dependencies) {
+                if (!GetPlugin(dependency)) {
+                    logger.log("ERROR: Plugin '" + candidate.name + "' depends on '" + dependency + "', which is not loaded: " + candidate.path.string());
+                    CloseLibrary(candidate.handle);
+                    candidate.handle = nullptr;
+                    return false;
+                }
+            }
+
+            // Create the plugin instance
+            std::unique_ptr<IPlugin> plugin(candidate.factory());
+            if (!plugin) {
+                CloseLibrary(candidate.handle);
+                candidate.handle = nullptr;
+                logger.log("ERROR: Failed to create plugin instance: " + candidate.path.string());
+                return false;
+            }
+
+            PluginHooks hooks{};
+            if (candidate.getHooks && !candidate.getHooks(kPluginAbiVersion, plugin.get(), &hooks)) {
+                plugin.reset();
+                CloseLibrary(candidate.handle);
+                candidate.handle = nullptr;
+                logger.log("ERROR: Plugin '" + candidate.name + "' was built for a different plugin ABI (engine is version "
+                    + std::to_string(kPluginAbiVersion) + "): " + candidate.path.string());
+                return false;
+            }
+
+            plugin->Initialize();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                plugins.push_back(LoadedPlugin{ candidate.name, std::move(plugin), candidate.handle, hooks });
+                RebuildHookTables();
+            }
+            candidate.handle = nullptr;
+
+            logger.log("Successfully loaded plugin: " + candidate.name
+                + (candidate.version.empty() ? "" : " " + candidate.version) + " (" + candidate.path.string() + ")");
+            return true;
+        }
+
+        // Caller holds mutex. Dispatches already running keep the tables they started with.
+        void RebuildHookTables() {
+            auto tables = std::make_shared<HookTables>();
+            for (const LoadedPlugin& plugin : plugins) {
+                const PluginHooks& hooks = plugin.hooks;
+                const bool threadSafe = (hooks.flags & kPluginThreadSafe) != 0;
+                if (hooks.update) (threadSafe ? tables->update.parallel : tables->update.serial).push_back({ hooks.update, hooks.context });
+                if (hooks.fixedUpdate) (threadSafe ? tables->fixedUpdate.parallel : tables->fixedUpdate.serial).push_back({ hooks.fixedUpdate, hooks.context });
+                if (hooks.onEvent) (threadSafe ? tables->onEvent.parallel : tables->onEvent.serial).push_back({ hooks.onEvent, hooks.context });
+            }
+            hookTables = std::move(tables);
+        }
+
+        // Allocation-free: the tables are shared, not copied, and parallelFor's body captures one
+        // reference so std::function keeps it inline
+        template <typename... Args>
+        void Dispatch(HookTable<Args...> HookTables::* table, ThreadPool* jobSystem, std::type_identity_t<Args>... args) {
+            ALMOND_PROFILE_SCOPE("Plugin hooks");
+            std::shared_ptr<const HookTables> tables;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tables = hookTables;
+            }
+            const HookTable<Args...>& calls = (*tables).*table;
+
+            const size_t count = calls.parallel.size();
+            const size_t batches = jobSystem ? (std::min)(count, jobSystem->size() + 1) : (count > 0 ? 1 : 0);
+            auto runBatch = [&](size_t batch) {
+                for (size_t i = batch * count / batches; i < (batch + 1) * count / batches; ++i) {
+                    calls.parallel[i].function(calls.parallel[i].context, args...);
+                }
+            };
+            if (batches > 1) {
+                jobSystem->parallelFor(batches, [&runBatch](size_t batch) { runBatch(batch); });
+            }
+            else if (batches == 1) {
+                runBatch(0);
+            }
+
+            for (const auto& call : calls.serial) {
+                call.function(call.context, args...);
+            }
+        }
     };
 
 } // namespace almond::plugin
@@ -118,10 +440,14 @@ int main() {
     // Load a plugin
     pluginManager.LoadPlugin("path/to/plugin.so");
 
+    // Or every plugin in a directory, opened in parallel and initialized in dependency order
+    almond::ThreadPool jobSystem(4);
+    pluginManager.LoadPluginsFromDirectory("mods", &jobSystem);
+
     // Unload all plugins
     pluginManager.UnloadAllPlugins();
 
     return 0;
 }
 
-*/
\ No newline at end of file
+*/
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "alsMemoryTracker.h"
+#include "alsMetrics.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// With ALMOND_MEMORY_TRACKING, slabs are charged to the Allocators tag and each block is lent to the
+// allocating thread's current tag while it is in use, so pooled objects show up under the subsystem
+// that made them. A trailer after each block remembers the tag so a free on another thread credits
+// the right one.
+//
+// Debug builds guard and poison every pooled block: a guard after each block catches overruns when
+// it is freed, freed blocks are filled with 0xDD and checked when handed out again to catch writes
+// through dangling pointers, and fresh blocks are filled with 0xCD. Define ALMOND_POOL_DEBUG to get
+// the checks in other builds too.
+#if defined(_DEBUG) && !defined(ALMOND_POOL_DEBUG)
+#define ALMOND_POOL_DEBUG
+#endif
+
+namespace almond {
+
+    // Fixed-size blocks carved from slabs and recycled through free lists, one pool per size class for
+    // the whole process. Each thread keeps a cache of free blocks and only takes the shared list's lock
+    // once per kBatch allocations or frees. Slabs are kept until exit, so objects churned through a
+    // pool (components, entities, map nodes) never fragment the general heap.
+    template <size_t BlockSize, size_t Alignment>
+    class SizeClassPool {
+    public:
+        static_assert(BlockSize >= sizeof(void*) && BlockSize % Alignment == 0, "Use PoolFor<T> to pick a size class");
+
+        static constexpr size_t kBatch = 32;
+
+        static void* Allocate() {
+            // Static destructors can still allocate after this thread's cache is gone
+            FreeNode* node = retired ? TakeShared() : Take(cache);
+
+#ifdef ALMOND_POOL_DEBUG
+            CheckPoison(node);
+            std::memset(node, 0xCD, BlockSize);
+            std::memset(reinterpret_cast<std::byte*>(node) + BlockSize, kGuardByte, kGuardSize);
+#endif
+#if defined(ALMOND_MEMORY_TRACKING)
+            const memory::Tag tag = memory::Tracker::CurrentTag();
+            TagOf(node) = tag;
+            memory::Tracker::Get().Lent(memory::Tag::Allocators, tag, BlockSize);
+#endif
+            return node;
+        }
+
+        static void Deallocate(void* block) noexcept {
+            if (!block) return;
+#if defined(ALMOND_MEMORY_TRACKING)
+            memory::Tracker::Get().Returned(memory::Tag::Allocators, TagOf(block), BlockSize);
+#endif
+#ifdef ALMOND_POOL_DEBUG
+            CheckGuard(block);
+            std::memset(block, kPoisonByte, BlockSize);
+#endif
+            auto* node = static_cast<FreeNode*>(block);
+            if (retired) {
+                std::lock_guard<std::mutex> lock(Shared().mutex);
+                node->next = Shared().freeList;
+                Shared().freeList = node;
+                return;
+            }
+
+            Cache& local = cache;
+            node->next = local.head;
+            local.head = node;
+            if (++local.count > 2 * kBatch) Spill(local, kBatch);
+        }
+
+    private:
+        struct FreeNode {
+            FreeNode* next;
+        };
+
+        struct SharedState {
+            std::mutex mutex;
+            FreeNode* freeList = nullptr;
+        };
+
+        struct Cache {
+            FreeNode* head = nullptr;
+            size_t count = 0;
+
+            ~Cache() {
+                Spill(*this, count);
+                retired = true;
+            }
+        };
+
+#ifdef ALMOND_POOL_DEBUG
+        static constexpr size_t kGuardSize = Alignment > 8 ? Alignment : 8;
+#else
+        static constexpr size_t kGuardSize = 0;
+#endif
+#if defined(ALMOND_MEMORY_TRACKING)
+        static constexpr size_t kTagSize = Alignment;  // Only the first byte is used; the rest keeps blocks aligned
+#else
+        static constexpr size_t kTagSize = 0;
+#endif
+        static constexpr size_t kStride = BlockSize + kGuardSize + kTagSize;
+        static constexpr size_t kSlabBytes = (std::max)(size_t(64 * 1024), kStride * kBatch);
+        static constexpr unsigned char kGuardByte = 0xFD;
+        static constexpr unsigned char kPoisonByte = 0xDD;
+
+        static inline thread_local Cache cache;
+        static inline thread_local bool retired = false;
+
+#if defined(ALMOND_MEMORY_TRACKING)
+        static memory::Tag& TagOf(void* block) {
+            return *reinterpret_cast<memory::Tag*>(static_cast<std::byte*>(block) + BlockSize + kGuardSize);
+        }
+#endif
+
+        // Never destroyed, so blocks freed by static destructors at exit still have somewhere to go
+        static SharedState& Shared() {
+            static SharedState* state = new SharedState();
+            return *state;
+        }
+
+        static void Refill(Cache& local) {
+            // Slabs outlive whichever allocation carved them, so they are charged to the allocators;
+            // Allocate lends each block on to its user's tag
+            ALMOND_MEMORY_TAG(Allocators);
+            SharedState& shared = Shared();
+            {
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                while (shared.freeList && local.count < kBatch) {
+                    FreeNode* node = shared.freeList;
+                    shared.freeList = node->next;
+                    node->next = local.head;
+                    local.head = node;
+                    ++local.count;
+                }
+            }
+            if (local.head) return;
+
+            // Carve a new slab straight into this thread's cache
+            auto* slab = static_cast<std::byte*>(::operator new(kSlabBytes, std::align_val_t(Alignment)));
+            metrics::Registry::Get().GetCounter("memory.pool_slabs").Add();
+            for (size_t offset = 0; offset + kStride <= kSlabBytes; offset += kStride) {
+                auto* node = reinterpret_cast<FreeNode*>(slab + offset);
+#ifdef ALMOND_POOL_DEBUG
+                std::memset(node, kPoisonByte, BlockSize);
+#endif
+                node->next = local.head;
+                local.head = node;
+                ++local.count;
+            }
+        }
+
+        static FreeNode* Take(Cache& local) {
+            if (!local.head) Refill(local);
+            FreeNode* node = local.head;
+            local.head = node->next;
+            --local.count;
+            return node;
+        }
+
+        // Never touches the thread's cache, which may already be destroyed
+        static FreeNode* TakeShared() {
+            Cache scratch;
+            return Take(scratch); // scratch hands the rest back as it goes out of scope
+        }
+
+        static void Spill(Cache& local, size_t blocks) {
+            if (blocks == 0) return;
+            SharedState& shared = Shared();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            for (size_t i = 0; i < blocks && local.head; ++i) {
+                FreeNode* node = local.head;
+                local.head = node->next;
+                --local.count;
+                node->next = shared.freeList;
+                shared.freeList = node;
+            }
+        }
+
+#ifdef ALMOND_POOL_DEBUG
+        static void Fail(const char* what, const void* block) {
+            std::cerr << "Pool allocator: " << what << " (block " << block << ", size " << BlockSize << ")" << std::endl;
+            assert(false && "Pooled block corrupted");
+        }
+
+        static void CheckGuard(const void* block) {
+            const auto* guard = static_cast<const unsigned char*>(block) + BlockSize;
+            for (size_t i = 0; i < kGuardSize; ++i) {
+                if (guard[i] != kGuardByte) return Fail("write past the end of a block", block);
+            }
+        }
+
+        // The first pointer's worth holds the free-list link
+        static void CheckPoison(const void* block) {
+            const auto* bytes = static_cast<const unsigned char*>(block);
+            for (size_t i = sizeof(FreeNode); i < BlockSize; ++i) {
+                if (bytes[i] != kPoisonByte) return Fail("write to a block after it was freed", block);
+            }
+        }
+#endif
+    };
+
+    namespace detail {
+        template <typename T>
+        constexpr size_t PoolAlignment = (std::max)(alignof(T), alignof(void*));
+
+        template <typename T>
+        constexpr size_t PoolBlockSize = ((std::max)(sizeof(T), sizeof(void*)) + PoolAlignment<T> - 1) / PoolAlignment<T> * PoolAlignment<T>;
+    }
+
+    // The pool a T is allocated from; types of the same rounded size share one
+    template <typename T>
+    using PoolFor = SizeClassPool<detail::PoolBlockSize<T>, detail::PoolAlignment<T>>;
+
+    template <typename T>
+    struct PoolDeleter {
+        void operator()(T* object) const noexcept {
+            object->~T();
+            PoolFor<T>::Deallocate(object);
+        }
+    };
+
+    // Owning pointer to a pooled object; the same size as a raw pointer
+    template <typename T>
+    using PoolPtr = std::unique_ptr<T, PoolDeleter<T>>;
+
+    template <typename T, typename... Args>
+    PoolPtr<T> MakePooled(Args&&... args) {
+        void* memory = PoolFor<T>::Allocate();
+        try {
+            return PoolPtr<T>(new (memory) T(std::forward<Args>(args)...));
+        }
+        catch (...) {
+            PoolFor<T>::Deallocate(memory);
+            throw;
+        }
+    }
+
+    // Allocator for node-based containers (std::map, std::set, std::list and unordered_map nodes).
+    // Single-object allocations come from the node type's pool; arrays such as hash buckets go to the
+    // heap as usual.
+    template <typename T>
+    class PoolAllocator {
+    public:
+        using value_type = T;
+
+        PoolAllocator() noexcept = default;
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+        T* allocate(size_t count) {
+            if (count == 1) return static_cast<T*>(PoolFor<T>::Allocate());
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+        }
+
+        void deallocate(T* pointer, size_t count) noexcept {
+            if (count == 1) PoolFor<T>::Deallocate(pointer);
+            else ::operator delete(pointer, std::align_val_t(alignof(T)));
+        }
+
+        template <typename U>
+        bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    };
+
+} // namespace almond
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frame profiler. Scopes are timed into per-thread buffers that only their own thread writes, so
+// recording takes no locks; a capture is exported as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev), where nested scopes show as a hierarchy per thread and GPU timings from
+// alsOpenGLGpuProfiler.h appear on their own track.
+//
+// The macros below compile to nothing unless ALMOND_PROFILING is defined (CMake option
+// ALMOND_PROFILING). When compiled in, a scope outside a capture costs one relaxed atomic load.
+//
+//   ALMOND_PROFILE_SCOPE("Physics");   // Times the enclosing block; names must be string literals
+//   ALMOND_PROFILE_FUNCTION();         // Same, named after the function
+//   ALMOND_PROFILE_FRAME();            // Marks the end of a frame on this thread
+//   ALMOND_PROFILE_THREAD("Worker");   // Names this thread's track
+
+namespace almond::profiler {
+
+    struct Event {
+        const char* name;
+        std::uint64_t startNs;     // Since the capture began
+        std::uint64_t durationNs;
+    };
+
+    // One per thread that has recorded anything. Events are appended by the owner only and published
+    // through `count` and `generation`; the exporter reads them once the capture has ended.
+    struct ThreadBuffer {
+        static constexpr size_t kCapacity = 1 << 16;
+
+        std::unique_ptr<Event[]> events;   // Allocated on the first capture this thread records in
+        std::atomic<size_t> count{ 0 };
+        std::atomic<size_t> dropped{ 0 };  // Events lost to a full buffer
+        std::atomic<std::uint32_t> generation{ 0 };  // Capture the contents belong to; stored last when a capture starts
+        std::uint32_t threadId = 0;
+        std::string threadName;
+        std::uint64_t lastFrameNs = 0;
+    };
+
+    class Profiler {
+    public:
+        static constexpr std::uint32_t kGpuThreadId = 0;
+
+        static Profiler& Get() {
+            static Profiler instance;
+            return instance;
+        }
+
+        // Starts a new capture, discarding the previous one
+        void BeginCapture() {
+            epoch.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            capturing.store(true, std::memory_order_release);
+        }
+
+        // Returns once every thread still appending to the capture has finished, so its buffers can
+        // be exported
+        void EndCapture() {
+            capturing.store(false, std::memory_order_seq_cst);
+            while (writers.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        bool IsCapturing() const {
+            return capturing.load(std::memory_order_relaxed);
+        }
+
+        // Nanoseconds since the capture began
+        std::uint64_t Now() const {
+            const auto now = Clock::now().time_since_epoch().count() - epoch.load(std::memory_order_relaxed);
+            return now > 0 ? static_cast<std::uint64_t>(now) : 0;
+        }
+
+        void SetThreadName(const std::string& name) {
+            ThreadBuffer& buffer = LocalBuffer();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer.threadName = name;
+        }
+
+        void Record(const char* name, std::uint64_t startNs, std::uint64_t endNs) {
+            if (!IsCapturing()) return;
+            ThreadBuffer& buffer = LocalBuffer();
+            Writer writer(*this);
+            if (writer) Append(buffer, { name, startNs, endNs > startNs ? endNs - startNs : 0 });
+        }
+
+        // GPU timings, already converted to the capture's clock; only the render thread calls this
+        void RecordGpu(const char* name, std::uint64_t startNs, std::uint64_t durationNs) {
+            if (!IsCapturing()) return;
+            Writer writer(*this);
+            if (writer) Append(gpuBuffer, { name, startNs, durationNs });
+        }
+
+        // Records the time since this thread's previous mark as a "Frame" scope, so a frame's scopes
+        // nest under it in the trace
+        void MarkFrame() {
+            if (!IsCapturing()) return;
+            ThreadBuffer& buffer = LocalBuffer();
+            Writer writer(*this);
+            if (!writer) return;
+            const std::uint64_t now = Now();
+            const std::uint32_t current = generation.load(std::memory_order_acquire);
+            if (buffer.generation.load(std::memory_order_relaxed) == current && buffer.lastFrameNs != 0) {
+                Append(buffer, { "Frame", buffer.lastFrameNs, now - buffer.lastFrameNs });
+            }
+            else {
+                Append(buffer, { "Frame", 0, now }); // First frame of the capture starts with it
+            }
+            buffer.lastFrameNs = now;
+        }
+
+        // Call between EndCapture() and the next BeginCapture()
+        bool WriteChromeTrace(const std::string& path) const {
+            std::ofstream out(path);
+            if (!out) {
+                std::cerr << "Failed to write profile: " << path << std::endl;
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(registryMutex);
+            const std::uint32_t current = generation.load(std::memory_order_acquire);
+            bool first = true;
+            auto separator = [&]() -> std::ostream& {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                return out;
+            };
+
+            out << "{\"traceEvents\":[";
+            auto writeBuffer = [&](const ThreadBuffer& buffer, const std::string& trackName) {
+                separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.threadId
+                    << ",\"args\":{\"name\":\"" << Escape(trackName) << "\"}}";
+                if (buffer.generation.load(std::memory_order_acquire) != current || !buffer.events) return;
+
+                const size_t count = std::min(buffer.count.load(std::memory_order_acquire), ThreadBuffer::kCapacity);
+                for (size_t i = 0; i < count; ++i) {
+                    const Event& event = buffer.events[i];
+                    separator() << "{\"name\":\"" << Escape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.threadId
+                        << ",\"ts\":" << event.startNs / 1000 << "." << Fraction(event.startNs)
+                        << ",\"dur\":" << event.durationNs / 1000 << "." << Fraction(event.durationNs) << "}";
+                }
+                if (size_t dropped = buffer.dropped.load(std::memory_order_relaxed)) {
+                    std::cerr << "Profiler: " << trackName << " dropped " << dropped << " events (buffer full)" << std::endl;
+                }
+            };
+
+            for (const auto& buffer : buffers) {
+                writeBuffer(*buffer, buffer->threadName.empty() ? "Thread " + std::to_string(buffer->threadId) : buffer->threadName);
+            }
+            writeBuffer(gpuBuffer, "GPU");
+            out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            return static_cast<bool>(out);
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::atomic<bool> capturing{ false };
+        std::atomic<std::uint32_t> generation{ 0 };
+        std::atomic<std::uint32_t> writers{ 0 };  // Threads inside Append for the current capture
+        std::atomic<Clock::rep> epoch{ 0 };
+
+        mutable std::mutex registryMutex;  // Guards the buffer list and thread names, not events
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        ThreadBuffer gpuBuffer;
+
+        Profiler() {
+            gpuBuffer.threadId = kGpuThreadId;
+        }
+
+        // Buffers live as long as the profiler, so exiting threads never invalidate a capture
+        ThreadBuffer& LocalBuffer() {
+            thread_local ThreadBuffer* local = nullptr;
+            if (!local) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                buffers.push_back(std::make_unique<ThreadBuffer>());
+                local = buffers.back().get();
+                local->threadId = static_cast<std::uint32_t>(buffers.size());
+            }
+            return *local;
+        }
+
+        // Registers an append in progress. Re-checks the capture after registering (both sides are
+        // sequentially consistent), so either EndCapture waits for this writer or the writer sees the
+        // capture has ended and backs off.
+        class Writer {
+        public:
+            explicit Writer(Profiler& profiler) : profiler(profiler) {
+                profiler.writers.fetch_add(1, std::memory_order_seq_cst);
+                active = profiler.capturing.load(std::memory_order_seq_cst);
+            }
+            ~Writer() { profiler.writers.fetch_sub(1, std::memory_order_release); }
+            explicit operator bool() const { return active; }
+
+            Writer(const Writer&) = delete;
+            Writer& operator=(const Writer&) = delete;
+
+        private:
+            Profiler& profiler;
+            bool active;
+        };
+
+        void Append(ThreadBuffer& buffer, const Event& event) {
+            const std::uint32_t current = generation.load(std::memory_order_acquire);
+            if (buffer.generation.load(std::memory_order_relaxed) != current) {
+                if (!buffer.events) buffer.events = std::make_unique<Event[]>(ThreadBuffer::kCapacity);
+                buffer.lastFrameNs = 0;
+                buffer.count.store(0, std::memory_order_relaxed);
+                buffer.dropped.store(0, std::memory_order_relaxed);
+                buffer.generation.store(current, std::memory_order_release);
+            }
+
+            const size_t index = buffer.count.load(std::memory_order_relaxed);
+            if (index >= ThreadBuffer::kCapacity) {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            buffer.events[index] = event;
+            buffer.count.store(index + 1, std::memory_order_release);
+        }
+
+        // Three-digit fraction of a microsecond, zero padded
+        static std::string Fraction(std::uint64_t ns) {
+            const auto rest = static_cast<unsigned>(ns % 1000);
+            return std::string(rest < 100 ? (rest < 10 ? "00" : "0") : "") + std::to_string(rest);
+        }
+
+        static std::string Escape(const std::string& text) {
+            std::string escaped;
+            for (char c : text) {
+                if (c == '"' || c == '\\') escaped += '\\';
+                escaped += c;
+            }
+            return escaped;
+        }
+    };
+
+    // Times its own lifetime
+    class Scope {
+    public:
+        explicit Scope(const char* name)
+            : name(name), active(Profiler::Get().IsCapturing()) {
+            if (active) startNs = Profiler::Get().Now();
+        }
+
+        ~Scope() {
+            if (active) Profiler::Get().Record(name, startNs, Profiler::Get().Now());
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+        bool active;
+        std::uint64_t startNs = 0;
+    };
+
+} // namespace almond::profiler
+
+#if defined(ALMOND_PROFILING)
+#define ALMOND_PROFILE_CONCAT_INNER(a, b) a##b
+#define ALMOND_PROFILE_CONCAT(a, b) ALMOND_PROFILE_CONCAT_INNER(a, b)
+#define ALMOND_PROFILE_SCOPE(name) ::almond::profiler::Scope ALMOND_PROFILE_CONCAT(almondProfileScope, __LINE__)(name)
+#define ALMOND_PROFILE_FUNCTION() ALMOND_PROFILE_SCOPE(__func__)
+#define ALMOND_PROFILE_FRAME() ::almond::profiler::Profiler::Get().MarkFrame()
+#define ALMOND_PROFILE_THREAD(name) ::almond::profiler::Profiler::Get().SetThreadName(name)
+#else
+#define ALMOND_PROFILE_SCOPE(name) ((void)0)
+#define ALMOND_PROFILE_FUNCTION() ((void)0)
+#define ALMOND_PROFILE_FRAME() ((void)0)
+#define ALMOND_PROFILE_THREAD(name) ((void)0)
+#endif
@@ -1,8 +1,9 @@
 #pragma once
 
+#include "alsPoolAllocator.h"
+
 #include <chrono>
 #include <concepts>
-#include <format>
 #include <functional>
 #include <map>
 #include <ranges>
@@ -10,6 +11,7 @@
 #include <vector>
 #include <ctime>
 #include <iomanip>  // For std::put_time
+#include <sstream>
 
 namespace almond {
 
@@ -71,10 +73,7 @@ namespace almond {
 #if defined(_WIN32) || defined(_WIN64)
             localtime_s(&tm_time, &timeT);  // Windows-specific thread-safe localtime
 #else
-            // For non-Windows, ensure thread safety
-            static std::mutex mtx;
-            std::lock_guard<std::mutex> lock(mtx);
-            tm_time = *std::localtime(&timeT); // For other platforms, using standard localtime
+            localtime_r(&timeT, &tm_time);  // POSIX thread-safe localtime
 #endif
 
             // Use std::ostringstream to format the time string
@@ -139,7 +138,9 @@ namespace almond {
         SystemTimePoint currentSystemTime;
         SteadyTimePoint currentSteadyTime;
         double gameTimeScale;
-        std::map<SystemTimePoint, AlarmCallback> alarms;
+        // Alarms come and go all session; their nodes are pooled so they do not fragment the heap
+        std::map<SystemTimePoint, AlarmCallback, std::less<SystemTimePoint>,
+            PoolAllocator<std::pair<const SystemTimePoint, AlarmCallback>>> alarms;
     };
 }
 // namespace almond
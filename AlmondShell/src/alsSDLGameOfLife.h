@@ -1,70 +1,133 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsLifeGrid.h"
+#include "alsSparseLifeGrid.h"
+#include "alsSDLGridTexture.h"
 
 #ifdef ALMOND_USING_SDL
 
-// Define a basic Cellular Automaton class
-class CellularAutomaton {
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Game of Life minigame: the simulation is an almond::LifeGrid (dense, bit-packed) or an
+// almond::SparseLifeGrid (active 64x64 tiles, for big mostly-empty worlds); this only seeds and
+// draws it
+template <typename Grid>
+class BasicCellularAutomaton {
 public:
-    CellularAutomaton(int width, int height)
-        : width(width), height(height), grid(width* height, false) {
+    BasicCellularAutomaton(int width, int height)
+        : grid(width, height) {
     }
 
     void randomize() {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                grid[y * width + x] = (rand() % 2 == 0);
-            }
-        }
+        grid.randomize((static_cast<std::uint64_t>(rand()) << 32) | static_cast<std::uint64_t>(rand()));
+        texture.MarkAllDirty();
     }
 
-    void update() {
-        std::vector<bool> newGrid(width * height, false);
+    // Pass the engine's job system to spread large grids across its workers
+    void update(almond::ThreadPool* pool = nullptr) {
+        if constexpr (std::is_same_v<Grid, almond::LifeGrid>) {
+            grid.step(pool);
+            texture.MarkAllDirty();
+        }
+        else {
+            // Edits made through getGrid() since the last frame are forgotten by step, so they are
+            // collected first
+            MarkChangedTiles();
+            grid.step(pool);
+            MarkChangedTiles();
+        }
+    }
 
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                int liveNeighbors = countLiveNeighbors(x, y);
-                if (grid[y * width + x]) {
-                    newGrid[y * width + x] = (liveNeighbors == 2 || liveNeighbors == 3);
+    // The grid is expanded into a texture (white live cells, transparent dead ones) and drawn in
+    // one call
+    void render(SDL_Renderer* renderer, int cellSize) {
+        constexpr std::uint32_t kAlive = 0xFFFFFFFFu;
+        const int width = grid.getWidth();
+        if constexpr (std::is_same_v<Grid, almond::LifeGrid>) {
+            texture.Update(renderer, width, grid.getHeight(), [&](int y, std::uint32_t* pixels) {
+                const std::uint64_t* words = grid.row(y);
+                for (int x = 0; x < width; ++x) {
+                    pixels[x] = ((words[x >> 6] >> (x & 63)) & 1) ? kAlive : 0;
                 }
-                else {
-                    newGrid[y * width + x] = (liveNeighbors == 3);
+            });
+        }
+        else {
+            // Full repaints (first frame, resize, randomize) go row by row over every tile
+            const int tilesX = (width + kTile - 1) / kTile;
+            int cachedTileRow = -1;
+            texture.Update(renderer, width, grid.getHeight(), [&](int y, std::uint32_t* pixels) {
+                if (y / kTile != cachedTileRow) {
+                    cachedTileRow = y / kTile;
+                    GatherTiles(0, tilesX - 1, cachedTileRow);
                 }
+                ExpandTiles(0, y, pixels);
+            });
+
+            // Otherwise only the changed tiles are redrawn: one rectangle per tile row, spanning
+            // its changed tiles
+            for (int ty = 0; ty < static_cast<int>(changedSpans.size()); ++ty) {
+                auto& [firstTile, lastTile] = changedSpans[ty];
+                if (firstTile > lastTile) continue;
+
+                const int x = firstTile * kTile, y = ty * kTile;
+                const SDL_Rect rect = { x, y, std::min(width, (lastTile + 1) * kTile) - x, std::min(grid.getHeight(), y + kTile) - y };
+                GatherTiles(firstTile, lastTile, ty);
+                texture.UpdateRect(rect, [&](int row, std::uint32_t* pixels) { ExpandTiles(firstTile, row, pixels); });
+
+                firstTile = INT_MAX;
+                lastTile = INT_MIN;
             }
         }
+        texture.Draw(renderer, cellSize);
+    }
 
-        grid = newGrid;
+    const Grid& getGrid() const { return grid; }
+    Grid& getGrid() { return grid; }
+
+private:
+    static constexpr int kTile = almond::SparseLifeGrid::kTileSize;
+
+    Grid grid;
+    almond::SDLGridTexture texture;
+
+    // Sparse grids only: per tile row, the first and last changed tile not yet redrawn, and the
+    // tiles of the row being expanded (null where the tile is empty)
+    std::vector<std::pair<int, int>> changedSpans;
+    std::vector<const std::uint64_t*> rowTiles;
+
+    void MarkChangedTiles() {
+        changedSpans.resize((grid.getHeight() + kTile - 1) / kTile, { INT_MAX, INT_MIN });
+        grid.forEachChangedTile([&](int tx, int ty) {
+            auto& [firstTile, lastTile] = changedSpans[ty];
+            firstTile = std::min(firstTile, tx);
+            lastTile = std::max(lastTile, tx);
+        });
     }
 
-    void render(SDL_Renderer* renderer, int cellSize) const {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                if (grid[y * width + x]) {
-                    SDL_FRect rect = { x * cellSize, y * cellSize, cellSize, cellSize };
-                    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White for live cells
-                    SDL_RenderFillRect(renderer, &rect);
-                }
-            }
+    void GatherTiles(int firstTile, int lastTile, int ty) {
+        rowTiles.clear();
+        for (int tx = firstTile; tx <= lastTile; ++tx) {
+            rowTiles.push_back(grid.tileCells(tx, ty));
         }
     }
 
-private:
-    int width, height;
-    std::vector<bool> grid;
-
-    int countLiveNeighbors(int x, int y) const {
-        int count = 0;
-        for (int dy = -1; dy <= 1; ++dy) {
-            for (int dx = -1; dx <= 1; ++dx) {
-                if (dx == 0 && dy == 0) continue; // Skip the cell itself
-                int nx = x + dx, ny = y + dy;
-                if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-                    count += grid[ny * width + nx] ? 1 : 0;
-                }
-            }
+    // Writes row y of the gathered tiles, which start at tile column firstTile
+    void ExpandTiles(int firstTile, int y, std::uint32_t* pixels) const {
+        constexpr std::uint32_t kAlive = 0xFFFFFFFFu;
+        const int columns = std::min(grid.getWidth() - firstTile * kTile, static_cast<int>(rowTiles.size()) * kTile);
+        for (int x = 0; x < columns; ++x) {
+            const std::uint64_t* cells = rowTiles[x / kTile];
+            pixels[x] = (cells && ((cells[y % kTile] >> (x % kTile)) & 1)) ? kAlive : 0;
         }
-        return count;
     }
 };
-#endif
\ No newline at end of file
+
+using CellularAutomaton = BasicCellularAutomaton<almond::LifeGrid>;
+using SparseCellularAutomaton = BasicCellularAutomaton<almond::SparseLifeGrid>;
+#endif
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "alsEngineConfig.h"
+
+#ifdef ALMOND_USING_SDL
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+namespace almond {
+
+    // SDL counterpart of OpenGLGridTexture: a simulation grid kept in a streaming texture, one texel
+    // per cell, drawn with a single SDL_RenderTexture. Only rows marked dirty are rewritten, through
+    // one lock of that band, so drawing no longer issues a fill per live cell. Grids that know their
+    // changes more precisely than a band of rows rewrite just those rectangles with UpdateRect.
+    class SDLGridTexture {
+    public:
+        SDLGridTexture() = default;
+
+        ~SDLGridTexture() {
+            if (texture) SDL_DestroyTexture(texture);
+        }
+
+        SDLGridTexture(const SDLGridTexture&) = delete;
+        SDLGridTexture& operator=(const SDLGridTexture&) = delete;
+
+        void MarkDirtyRows(int first, int last) {
+            dirtyFirst = std::min(dirtyFirst, first);
+            dirtyLast = std::max(dirtyLast, last);
+        }
+
+        void MarkAllDirty() {
+            MarkDirtyRows(0, INT_MAX);
+        }
+
+        // Creates the texture on first use or when the grid size changes, marking every row dirty.
+        // Returns false if there is no texture to draw into.
+        bool Resize(SDL_Renderer* renderer, int width, int height) {
+            if (texture && width == textureWidth && height == textureHeight) return true;
+
+            if (texture) SDL_DestroyTexture(texture);
+            texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+            if (!texture) {
+                SDL_Log("Failed to create grid texture: %s", SDL_GetError());
+                return false;
+            }
+            SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            textureWidth = width;
+            textureHeight = height;
+            MarkAllDirty();
+            return true;
+        }
+
+        // Rewrites the dirty rows: fillRow(y, pixels) writes `width` colours (0xAABBGGRR) for row y.
+        template <typename FillRow>
+        void Update(SDL_Renderer* renderer, int width, int height, FillRow&& fillRow) {
+            if (!Resize(renderer, width, height)) return;
+
+            const int first = std::max(dirtyFirst, 0), last = std::min(dirtyLast, height - 1);
+            dirtyFirst = INT_MAX;
+            dirtyLast = INT_MIN;
+            if (first > last) return;
+
+            Fill({ 0, first, width, last - first + 1 }, fillRow);
+        }
+
+        // Rewrites one rectangle now, independently of the dirty rows: fillRow(y, pixels) writes
+        // rect.w colours for row y, starting at column rect.x. Call Resize first.
+        template <typename FillRow>
+        void UpdateRect(const SDL_Rect& rect, FillRow&& fillRow) {
+            if (!texture || rect.w <= 0 || rect.h <= 0) return;
+            Fill(rect, fillRow);
+        }
+
+        void Draw(SDL_Renderer* renderer, int cellSize) const {
+            if (!texture) return;
+            const SDL_FRect destination = { 0.0f, 0.0f, static_cast<float>(textureWidth * cellSize), static_cast<float>(textureHeight * cellSize) };
+            SDL_RenderTexture(renderer, texture, nullptr, &destination);
+        }
+
+    private:
+        SDL_Texture* texture = nullptr;
+        int textureWidth = 0;
+        int textureHeight = 0;
+        int dirtyFirst = INT_MAX;
+        int dirtyLast = INT_MIN;
+
+        // Locked pixels are write-only, so every row of the rectangle is filled
+        template <typename FillRow>
+        void Fill(const SDL_Rect& rect, FillRow& fillRow) {
+            void* pixels = nullptr;
+            int pitch = 0;
+            if (!SDL_LockTexture(texture, &rect, &pixels, &pitch)) {
+                SDL_Log("Failed to lock grid texture: %s", SDL_GetError());
+                return;
+            }
+            for (int y = rect.y; y < rect.y + rect.h; ++y) {
+                fillRow(y, reinterpret_cast<std::uint32_t*>(static_cast<std::uint8_t*>(pixels) + static_cast<size_t>(y - rect.y) * pitch));
+            }
+            SDL_UnlockTexture(texture);
+        }
+    };
+
+} // namespace almond
+
+#endif
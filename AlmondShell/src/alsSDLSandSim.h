@@ -1,78 +1,55 @@
 #pragma once
 
 #include "alsEngineConfig.h"
+#include "alsSandGrid.h"
+#include "alsSDLGridTexture.h"
 
 #ifdef ALMOND_USING_SDL
 
-// Define a sand simulation class
+#include <cstdlib>
+
+// Sand minigame: the simulation is an almond::SandGrid (sand, water, gas, fire and solid
+// cells), this only seeds, feeds and draws it
 class SandSimulation {
 public:
     SandSimulation(int width, int height)
-        : width(width), height(height), grid(width* height, false) {
+        : grid(width, height) {
     }
 
     void randomize() {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                // Add sand particles at random positions
-                grid[y * width + x] = (rand() % 5 == 0); // Adjust density as needed
-            }
-        }
+        grid.randomize((static_cast<std::uint64_t>(rand()) << 32) | static_cast<std::uint64_t>(rand()));
+        texture.MarkAllDirty();
     }
 
-    void update() {
-        std::vector<bool> newGrid(width * height, false);
-
-        for (int y = height - 2; y >= 0; --y) { // Start from the second-to-last row up to the first row
-            for (int x = 0; x < width; ++x) {
-                if (grid[y * width + x]) {
-                    // Check if the cell below is empty
-                    if (y + 1 < height && !grid[(y + 1) * width + x]) {
-                        newGrid[(y + 1) * width + x] = true; // Drop sand down
-                    }
-                    else if (x > 0 && y + 1 < height && !grid[(y + 1) * width + (x - 1)]) {
-                        newGrid[(y + 1) * width + (x - 1)] = true; // Diagonal left
-                    }
-                    else if (x + 1 < width && y + 1 < height && !grid[(y + 1) * width + (x + 1)]) {
-                        newGrid[(y + 1) * width + (x + 1)] = true; // Diagonal right
-                    }
-                    else {
-                        newGrid[y * width + x] = true; // Stay in place if no space to fall
-                    }
-                }
-            }
-        }
-
-        // Ensure particles at the bottom row remain in place
-        for (int x = 0; x < width; ++x) {
-            if (grid[(height - 1) * width + x]) {
-                newGrid[(height - 1) * width + x] = true;
-            }
-        }
-
-        grid = newGrid;
+    // Pass the engine's job system to spread awake chunks across its workers
+    void update(almond::ThreadPool* pool = nullptr) {
+        grid.step(pool);
+        grid.forEachDirtyRect([this](int, int y, int, int h) { texture.MarkDirtyRows(y, y + h - 1); });
     }
 
-    void addSandAt(int x, int y) {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            grid[y * width + x] = true; // Add a sand particle
-        }
+    void addSandAt(int x, int y, almond::Material material = almond::Material::Sand) {
+        grid.set(x, y, material);
+        texture.MarkDirtyRows(y, y);
     }
 
-    void render(SDL_Renderer* renderer, int cellSize) const {
-        for (int y = 0; y < height; ++y) {
+    // Rows changed since the last render are recoloured from the material table into the grid
+    // texture, which is then drawn in one call
+    void render(SDL_Renderer* renderer, int cellSize) {
+        const auto& cells = grid.getCells();
+        const int width = grid.getWidth();
+        texture.Update(renderer, width, grid.getHeight(), [&](int y, std::uint32_t* pixels) {
+            const std::uint8_t* row = &cells[static_cast<size_t>(y) * width];
             for (int x = 0; x < width; ++x) {
-                if (grid[y * width + x]) {
-                    SDL_FRect rect = { x * cellSize, y * cellSize, cellSize, cellSize };
-                    SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255); // Yellow for sand
-                    SDL_RenderFillRect(renderer, &rect);
-                }
+                pixels[x] = almond::kMaterials[row[x]].color;
             }
-        }
+        });
+        texture.Draw(renderer, cellSize);
     }
 
+    const almond::SandGrid& getGrid() const { return grid; }
+
 private:
-    int width, height;
-    std::vector<bool> grid;
+    almond::SandGrid grid;
+    almond::SDLGridTexture texture;
 };
-#endif
\ No newline at end of file
+#endif
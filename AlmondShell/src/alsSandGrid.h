@@ -0,0 +1,424 @@
+#pragma once
+
+#include "alsSandMaterials.h"
+#include "alsProfiler.h"
+#include "alsThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace almond {
+
+    // Falling-sand world of mixed materials (see alsSandMaterials.h), split into 64x64 chunks.
+    // Particles are updated in place, bottom row first. Each one follows its material's row in the
+    // table: move along gravity (accelerating up to maxSpeed), else diagonally, else spread
+    // sideways, swapping with whatever the displacement table lets it push aside; fire burns down
+    // its lifetime, ignites flammable neighbours and goes out next to water.
+    //
+    // Only the dirty rectangle of each chunk is visited, and a chunk whose rectangle is empty is
+    // asleep and costs nothing; a move wakes the cells around both its ends for the next tick.
+    // Chunks are stepped in four checkerboard passes. Nothing moves further than
+    // kMaxMaterialReach, so chunks of the same parity never touch each other's cells and each pass
+    // runs across the ThreadPool. A per-cell tick stamp stops a particle that crossed into a later
+    // pass's chunk moving twice.
+    //
+    // Per-cell state besides the material is kept in separate arrays (velocity, lifetime), so the
+    // common case of settled or plain falling cells only touches the material bytes.
+    class SandGrid {
+    public:
+        static constexpr int kChunkSize = 64;
+
+        SandGrid(int width, int height) {
+            resize(width, height);
+        }
+
+        // Rebuilds an empty world of the new size
+        void resize(int newWidth, int newHeight) {
+            width = std::max(1, newWidth);
+            height = std::max(1, newHeight);
+            chunksX = (width + kChunkSize - 1) / kChunkSize;
+            chunksY = (height + kChunkSize - 1) / kChunkSize;
+            cells.assign(static_cast<size_t>(width) * height, 0);
+            stamps.assign(cells.size(), 0);
+            velocityX.assign(cells.size(), 0);
+            velocityY.assign(cells.size(), 0);
+            lifetime.assign(cells.size(), 0);
+            chunks = std::vector<Chunk>(static_cast<size_t>(chunksX) * chunksY);
+            tick = 0;
+        }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+
+        // One Material per cell, row-major; 0 is empty
+        const std::vector<std::uint8_t>& getCells() const { return cells; }
+
+        std::uint8_t get(int x, int y) const {
+            if (x < 0 || x >= width || y < 0 || y >= height) return 0;
+            return cells[Index(x, y)];
+        }
+
+        // Unknown material values are ignored
+        void set(int x, int y, std::uint8_t type) {
+            if (x < 0 || x >= width || y < 0 || y >= height || type >= kMaterialCount) return;
+            const size_t index = Index(x, y);
+            cells[index] = type;
+            velocityX[index] = 0;
+            velocityY[index] = 0;
+            lifetime[index] = kMaterials[type].lifetime;
+            WakeAround(x, y);
+        }
+
+        void set(int x, int y, Material material) {
+            set(x, y, static_cast<std::uint8_t>(material));
+        }
+
+        void clear() {
+            std::fill(cells.begin(), cells.end(), 0);
+            for (auto& chunk : chunks) chunk.next.Reset();
+        }
+
+        // Roughly one cell in `density` gets a particle of the given type
+        void randomize(std::uint64_t seed, int density = 5, std::uint8_t type = 1) {
+            if (type >= kMaterialCount) return;
+            std::uint64_t state = seed ? seed : 0x9E3779B97F4A7C15ull;
+            for (size_t i = 0; i < cells.size(); ++i) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                cells[i] = (state % static_cast<std::uint64_t>(std::max(1, density)) == 0) ? type : 0;
+                velocityX[i] = 0;
+                velocityY[i] = 0;
+                lifetime[i] = cells[i] ? kMaterials[type].lifetime : 0;
+            }
+            WakeRect(0, 0, width - 1, height - 1);
+        }
+
+        size_t countParticles() const {
+            return static_cast<size_t>(std::count_if(cells.begin(), cells.end(), [](std::uint8_t cell) { return cell != 0; }));
+        }
+
+        // Chunks that will be visited by the next step
+        size_t getAwakeChunkCount() const {
+            return static_cast<size_t>(std::count_if(chunks.begin(), chunks.end(), [](const Chunk& chunk) { return !chunk.next.Empty(); }));
+        }
+
+        // Calls fn(x, y, w, h) for each chunk's dirty rectangle: every cell changed by the last step
+        // or by set() since lies inside one
+        template <typename Fn>
+        void forEachDirtyRect(Fn&& fn) const {
+            for (const auto& chunk : chunks) {
+                if (chunk.next.Empty()) continue;
+                const int minX = chunk.next.minX.load(std::memory_order_relaxed);
+                const int minY = chunk.next.minY.load(std::memory_order_relaxed);
+                fn(minX, minY, chunk.next.maxX.load(std::memory_order_relaxed) - minX + 1,
+                    chunk.next.maxY.load(std::memory_order_relaxed) - minY + 1);
+            }
+        }
+
+        void step(ThreadPool* pool = nullptr) {
+            ALMOND_PROFILE_SCOPE("SandGrid::step");
+            NextTick();
+            ++frame;
+
+            for (auto& chunk : chunks) {
+                chunk.current = chunk.next.Take();
+            }
+
+            for (int phase = 0; phase < 4; ++phase) {
+                awake.clear();
+                for (int cy = phase >> 1; cy < chunksY; cy += 2) {
+                    for (int cx = phase & 1; cx < chunksX; cx += 2) {
+                        const size_t index = static_cast<size_t>(cy) * chunksX + cx;
+                        if (!chunks[index].current.Empty()) awake.push_back(index);
+                    }
+                }
+
+                if (pool && awake.size() > 1) {
+                    pool->parallelFor(awake.size(), [this](size_t i) { StepChunk(chunks[awake[i]]); });
+                }
+                else {
+                    for (size_t index : awake) StepChunk(chunks[index]);
+                }
+            }
+        }
+
+    private:
+        static_assert(kMaxMaterialReach * 2 + 2 < kChunkSize, "Parallel chunk passes assume short moves");
+
+        struct Rect {
+            int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+            bool Empty() const { return minX > maxX; }
+        };
+
+        // Grown from several workers at once (neighbouring chunks wake this one), hence atomics
+        struct AtomicRect {
+            std::atomic<int> minX{ INT_MAX }, minY{ INT_MAX }, maxX{ INT_MIN }, maxY{ INT_MIN };
+
+            bool Empty() const { return minX.load(std::memory_order_relaxed) > maxX.load(std::memory_order_relaxed); }
+
+            void Include(int x0, int y0, int x1, int y1) {
+                AtomicMin(minX, x0);
+                AtomicMin(minY, y0);
+                AtomicMax(maxX, x1);
+                AtomicMax(maxY, y1);
+            }
+
+            void Reset() {
+                minX.store(INT_MAX, std::memory_order_relaxed);
+                minY.store(INT_MAX, std::memory_order_relaxed);
+                maxX.store(INT_MIN, std::memory_order_relaxed);
+                maxY.store(INT_MIN, std::memory_order_relaxed);
+            }
+
+            Rect Take() {
+                Rect rect{ minX.load(std::memory_order_relaxed), minY.load(std::memory_order_relaxed),
+                    maxX.load(std::memory_order_relaxed), maxY.load(std::memory_order_relaxed) };
+                Reset();
+                return rect;
+            }
+
+            static void AtomicMin(std::atomic<int>& target, int value) {
+                int current = target.load(std::memory_order_relaxed);
+                while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+            }
+
+            static void AtomicMax(std::atomic<int>& target, int value) {
+                int current = target.load(std::memory_order_relaxed);
+                while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+            }
+        };
+
+        struct Chunk {
+            Rect current;     // Cells to visit this step
+            AtomicRect next;  // Cells woken for the next step
+        };
+
+        int width = 0;
+        int height = 0;
+        int chunksX = 0;
+        int chunksY = 0;
+        std::uint8_t tick = 0;
+        std::uint32_t frame = 0; // Seeds the per-cell random choices
+
+        std::vector<std::uint8_t> cells;
+        std::vector<std::uint8_t> stamps; // Tick a cell's particle last moved on
+        std::vector<std::int8_t> velocityX; // Sideways flow direction (-1 / +1) while spreading
+        std::vector<std::int8_t> velocityY; // Cells per tick along gravity, signed
+        std::vector<std::uint8_t> lifetime; // Ticks left for decaying materials
+        std::vector<Chunk> chunks;
+        std::vector<size_t> awake;
+
+        size_t Index(int x, int y) const {
+            return static_cast<size_t>(y) * width + x;
+        }
+
+        // Stamps are a byte, so they are cleared whenever the tick counter wraps
+        void NextTick() {
+            if (++tick == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                tick = 1;
+            }
+        }
+
+        void WakeRect(int x0, int y0, int x1, int y1) {
+            x0 = std::max(x0, 0);
+            y0 = std::max(y0, 0);
+            x1 = std::min(x1, width - 1);
+            y1 = std::min(y1, height - 1);
+            if (x0 > x1 || y0 > y1) return;
+
+            for (int cy = y0 / kChunkSize; cy <= y1 / kChunkSize; ++cy) {
+                for (int cx = x0 / kChunkSize; cx <= x1 / kChunkSize; ++cx) {
+                    chunks[static_cast<size_t>(cy) * chunksX + cx].next.Include(
+                        std::max(x0, cx * kChunkSize), std::max(y0, cy * kChunkSize),
+                        std::min(x1, cx * kChunkSize + kChunkSize - 1), std::min(y1, cy * kChunkSize + kChunkSize - 1));
+                }
+            }
+        }
+
+        void WakeAround(int x, int y) {
+            WakeRect(x - 1, y - 1, x + 1, y + 1);
+        }
+
+        // Cheap per-cell hash for random choices; deterministic for a given frame, so results do not
+        // depend on which worker stepped a chunk
+        static std::uint32_t Hash(int x, int y, std::uint32_t frame) {
+            std::uint32_t h = static_cast<std::uint32_t>(x) * 0x8DA6B343u ^ static_cast<std::uint32_t>(y) * 0xD8163841u ^ frame * 0xCB1AB31Fu;
+            h ^= h >> 15;
+            h *= 0x2C1B3C6Du;
+            h ^= h >> 12;
+            return h;
+        }
+
+        // Moves the particle at `from` to `to`. Into an empty cell only the state its material uses
+        // is carried (the rest of an empty cell's side arrays is never read); otherwise the two
+        // cells are exchanged wholesale and both stamped so the displaced one stays put this tick.
+        void Move(size_t from, size_t to, const MaterialInfo& material) {
+            if (cells[to] == 0) {
+                cells[to] = cells[from];
+                cells[from] = 0;
+                velocityY[to] = velocityY[from];
+                if (material.dispersion != 0) velocityX[to] = velocityX[from];
+                if (material.lifetime != 0) lifetime[to] = lifetime[from];
+            }
+            else {
+                std::swap(cells[from], cells[to]);
+                std::swap(velocityX[from], velocityX[to]);
+                std::swap(velocityY[from], velocityY[to]);
+                std::swap(lifetime[from], lifetime[to]);
+                stamps[from] = tick;
+            }
+            stamps[to] = tick;
+        }
+
+        void StepChunk(Chunk& chunk) {
+            const Rect rect = chunk.current;
+            const int chunkMinX = rect.minX / kChunkSize * kChunkSize, chunkMinY = rect.minY / kChunkSize * kChunkSize;
+            const int chunkMaxX = std::min(chunkMinX + kChunkSize, width) - 1, chunkMaxY = std::min(chunkMinY + kChunkSize, height) - 1;
+
+            // Wakes inside this chunk are gathered locally and published once; only those that
+            // spill into a neighbour go through the shared atomics
+            Rect woken;
+            auto wake = [&](int x0, int y0, int x1, int y1) {
+                if (x0 > chunkMinX && x1 < chunkMaxX && y0 > chunkMinY && y1 < chunkMaxY) {
+                    woken.minX = std::min(woken.minX, x0 - 1);
+                    woken.minY = std::min(woken.minY, y0 - 1);
+                    woken.maxX = std::max(woken.maxX, x1 + 1);
+                    woken.maxY = std::max(woken.maxY, y1 + 1);
+                }
+                else {
+                    WakeRect(x0 - 1, y0 - 1, x1 + 1, y1 + 1);
+                }
+            };
+
+            // Alternate the scan direction so sideways flow has no built-in bias
+            const bool leftToRight = (frame & 1) != 0;
+            for (int y = rect.maxY; y >= rect.minY; --y) {
+                for (int i = 0; i <= rect.maxX - rect.minX; ++i) {
+                    const int x = leftToRight ? rect.minX + i : rect.maxX - i;
+                    const size_t from = Index(x, y);
+                    if (cells[from] != 0 && stamps[from] != tick) {
+                        StepCell(x, y, from, wake);
+                    }
+                }
+            }
+
+            if (!woken.Empty()) {
+                chunk.next.Include(woken.minX, woken.minY, woken.maxX, woken.maxY);
+            }
+        }
+
+        template <typename Wake>
+        void StepCell(int x, int y, size_t from, Wake& wake) {
+            const std::uint8_t type = cells[from];
+            const MaterialInfo& material = kMaterials[type];
+            const std::uint32_t random = Hash(x, y, frame);
+
+            if (material.lifetime != 0) {
+                // Decaying materials stay awake until they are gone
+                if (--lifetime[from] == 0) {
+                    const std::uint8_t decayed = static_cast<std::uint8_t>(material.decaysTo);
+                    cells[from] = decayed;
+                    lifetime[from] = kMaterials[decayed].lifetime;
+                    wake(x, y, x, y);
+                    return;
+                }
+                wake(x, y, x, y);
+
+                // Fire: ignite flammable neighbours, go out next to anything that quenches it
+                static constexpr int kNeighbourX[4] = { 0, -1, 1, 0 };
+                static constexpr int kNeighbourY[4] = { -1, 0, 0, 1 };
+                for (int n = 0; n < 4; ++n) {
+                    const int nx = x + kNeighbourX[n], ny = y + kNeighbourY[n];
+                    if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+                    const size_t neighbour = Index(nx, ny);
+                    const MaterialInfo& other = kMaterials[cells[neighbour]];
+                    if (other.quenchesFire) {
+                        cells[from] = 0;
+                        return;
+                    }
+                    if (other.flammability > ((random >> (n * 8)) & 0xFF)) {
+                        cells[neighbour] = type;
+                        lifetime[neighbour] = material.lifetime;
+                        stamps[neighbour] = tick;
+                        wake(nx, ny, nx, ny);
+                    }
+                }
+            }
+
+            const int dir = material.gravity;
+            if (dir == 0) return;
+
+            // Along gravity: accelerate, then travel through empty cells; only the first step may
+            // push a lighter particle aside
+            const int ty = y + dir;
+            if (ty >= 0 && ty < height) {
+                const int speed = std::min<int>(std::abs(velocityY[from]) + 1, material.maxSpeed);
+                int travelled = 0;
+                for (int k = 1; k <= speed; ++k) {
+                    const int cy = y + dir * k;
+                    if (cy < 0 || cy >= height) break;
+                    const std::uint8_t target = cells[Index(x, cy)];
+                    if (k == 1 ? !kMaterialDisplaces[type][target] : target != 0) break;
+                    travelled = k;
+                    if (target != 0) break;
+                }
+
+                if (travelled > 0) {
+                    const size_t to = Index(x, y + dir * travelled);
+                    velocityY[from] = static_cast<std::int8_t>(dir * travelled);
+                    Move(from, to, material);
+                    wake(x, std::min(y, y + dir * travelled), x, std::max(y, y + dir * travelled));
+                    return;
+                }
+
+                // Diagonals, in a random order
+                const int first = (random & 1) ? 1 : -1;
+                for (int side : { first, -first }) {
+                    const int tx = x + side;
+                    if (tx < 0 || tx >= width) continue;
+                    const size_t to = Index(tx, ty);
+                    if (kMaterialDisplaces[type][cells[to]]) {
+                        velocityY[from] = static_cast<std::int8_t>(dir);
+                        Move(from, to, material);
+                        wake(std::min(x, tx), std::min(y, ty), std::max(x, tx), std::max(y, ty));
+                        return;
+                    }
+                }
+            }
+            velocityY[from] = 0;
+
+            // Sideways for liquids and gases, keeping the current flow direction until blocked
+            if (material.dispersion == 0) return;
+            int side = velocityX[from] != 0 ? velocityX[from] : ((random & 2) ? 1 : -1);
+            for (int attempt = 0; attempt < 2; ++attempt, side = -side) {
+                int travelled = 0;
+                for (int k = 1; k <= material.dispersion; ++k) {
+                    const int tx = x + side * k;
+                    if (tx < 0 || tx >= width) break;
+                    const std::uint8_t target = cells[Index(tx, y)];
+                    if (!kMaterialSpreads[type][target]) break;
+                    travelled = k;
+                    if (target != 0) break;
+                }
+
+                if (travelled > 0) {
+                    const int tx = x + side * travelled;
+                    velocityX[from] = static_cast<std::int8_t>(side);
+                    Move(from, Index(tx, y), material);
+                    wake(std::min(x, tx), y, std::max(x, tx), y);
+                    return;
+                }
+            }
+            velocityX[from] = 0;
+        }
+    };
+
+} // namespace almond
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace almond {
+
+    // Cell values of a SandGrid. Sand stays 1 so existing "add sand" callers keep working.
+    enum class Material : std::uint8_t {
+        Empty = 0,
+        Sand,
+        Water,
+        Gas,
+        Fire,
+        Solid,
+        Count
+    };
+
+    constexpr size_t kMaterialCount = static_cast<size_t>(Material::Count);
+
+    // Everything the update kernel knows about a material. Behaviour comes from these numbers
+    // rather than per-material code paths, so adding a material is adding a row.
+    struct MaterialInfo {
+        const char* name;
+        std::uint32_t color;        // 0xAABBGGRR, for renderers
+        std::uint8_t density;       // Heavier materials sink through lighter ones
+        std::int8_t gravity;        // +1 falls, -1 rises, 0 never moves
+        std::uint8_t maxSpeed;      // Cells per tick along gravity once accelerated
+        std::uint8_t dispersion;    // Cells per tick it can spread sideways when blocked (liquids, gases)
+        std::uint8_t flammability;  // Chance out of 256 per tick that neighbouring fire ignites it
+        std::uint8_t lifetime;      // Ticks until it turns into decaysTo; 0 lives forever
+        Material decaysTo;
+        bool quenchesFire;          // Fire touching it goes out
+    };
+
+    inline constexpr std::array<MaterialInfo, kMaterialCount> kMaterials = { {
+        //  name     color        density gravity speed disp  flame life decaysTo         quench
+        { "Empty", 0x00000000u,   0,      0,      0,    0,    0,    0,   Material::Empty, false },
+        { "Sand",  0xFF50C8E6u,   160,    1,      4,    0,    0,    0,   Material::Empty, false },
+        { "Water", 0xFFE08228u,   100,    1,      4,    4,    0,    0,   Material::Empty, true  },
+        { "Gas",   0xFF90B4A0u,   10,     -1,     1,    2,    96,   0,   Material::Empty, false },
+        { "Fire",  0xFF1E64FFu,   5,      -1,     1,    1,    0,    30,  Material::Empty, false },
+        { "Solid", 0xFF707070u,   255,    0,      0,    0,    0,    0,   Material::Empty, false },
+    } };
+
+    // Farthest any material moves in one tick. SandGrid relies on this staying well under half a
+    // chunk so chunks stepped in parallel never reach each other's cells.
+    constexpr int kMaxMaterialReach = 4;
+
+    namespace material_detail {
+
+        constexpr bool Displaces(const MaterialInfo& mover, const MaterialInfo& target, bool targetEmpty) {
+            if (targetEmpty) return true;
+            if (target.gravity == 0) return false;
+            return mover.gravity > 0
+                ? target.density < mover.density
+                : (target.gravity > 0 && target.density > mover.density);
+        }
+
+        using Table = std::array<std::array<bool, kMaterialCount>, kMaterialCount>;
+
+        constexpr Table BuildDisplaces() {
+            Table table{};
+            for (size_t a = 0; a < kMaterialCount; ++a) {
+                for (size_t t = 0; t < kMaterialCount; ++t) {
+                    table[a][t] = Displaces(kMaterials[a], kMaterials[t], t == 0);
+                }
+            }
+            return table;
+        }
+
+        // Sideways only into empty cells, or lighter ones for falling materials (water pushes gas)
+        constexpr Table BuildSpreads() {
+            Table table{};
+            for (size_t a = 0; a < kMaterialCount; ++a) {
+                for (size_t t = 0; t < kMaterialCount; ++t) {
+                    table[a][t] = t == 0 || (kMaterials[a].gravity > 0 && kMaterials[t].gravity < 0
+                        && kMaterials[t].density < kMaterials[a].density);
+                }
+            }
+            return table;
+        }
+
+        constexpr bool CheckReach() {
+            for (const auto& m : kMaterials) {
+                if (m.maxSpeed > kMaxMaterialReach || m.dispersion > kMaxMaterialReach) return false;
+            }
+            return true;
+        }
+    }
+
+    // kMaterialDisplaces[a][b]: a may move into b's cell along its gravity (swapping with it)
+    inline constexpr material_detail::Table kMaterialDisplaces = material_detail::BuildDisplaces();
+    // kMaterialSpreads[a][b]: a may move sideways into b's cell
+    inline constexpr material_detail::Table kMaterialSpreads = material_detail::BuildSpreads();
+
+    static_assert(material_detail::CheckReach(), "Material speeds must stay within kMaxMaterialReach");
+
+} // namespace almond
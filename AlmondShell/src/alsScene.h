@@ -1,11 +1,14 @@
 #pragma once
 
 #include "alsEntity.h"
+#include "alsMemoryTracker.h"
 #include "alsMovementEvent.h" // Ensure you include this for MovementEvent
+#include "alsPoolAllocator.h"
 
 #include <iostream>
 #include <vector>
 #include <memory> // Include for std::unique_ptr
+#include <utility>
 
 namespace almond
 {
@@ -45,10 +48,19 @@ namespace almond
             }
         }
 
-        void addEntity(std::unique_ptr<Entity> entity) { // Accept unique_ptr
+        void addEntity(PoolPtr<Entity> entity) { // Accept pooled pointer
+            ALMOND_MEMORY_TAG(ECS);
             entities.push_back(std::move(entity)); // Use std::move to transfer ownership
         }
 
+        // Constructs the entity in the entity pool; snapshots clone whole scenes, so this churns
+        template <typename... Args>
+        Entity& createEntity(Args&&... args) {
+            ALMOND_MEMORY_TAG(ECS);
+            entities.push_back(MakePooled<Entity>(std::forward<Args>(args)...));
+            return *entities.back();
+        }
+
         void clearEntities() {
             entities.clear(); // Clears the vector of entities
         }
@@ -64,11 +76,12 @@ namespace almond
 
         // Clone method to create a copy of the scene
         std::unique_ptr<Scene> clone() const {
+            ALMOND_MEMORY_TAG(Snapshots); // Clones are only ever kept as snapshots
             auto newScene = std::make_unique<Scene>();
 
             for (const auto& entity : entities) {
                 if (entity) { // Check if the entity is not null
-                    newScene->addEntity(entity->clone()); // Assuming `clone()` returns a `std::unique_ptr<Entity>`
+                    newScene->addEntity(entity->clone()); // clone() returns a pooled pointer
                 }
             }
             return newScene;
@@ -77,7 +90,7 @@ namespace almond
         bool isLoaded() const { return loaded; } // Check if the scene is loaded
 
     private:
-        std::vector<std::unique_ptr<Entity>> entities; // Store entities as pointers
+        std::vector<PoolPtr<Entity>> entities; // Store entities as pooled pointers
         bool loaded = false; // Flag to indicate if the scene is loaded
     };
 
@@ -0,0 +1,340 @@
+#pragma once
+
+#include "alsFrameArena.h"
+#include "alsLifeGrid.h"
+#include "alsProfiler.h"
+#include "alsThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace almond {
+
+    // Game of Life for huge, mostly empty worlds. The world is cut into 64x64 tiles (one 64-bit
+    // word per tile row) and only tiles that exist are stored: empty space costs nothing. Each step
+    // only visits tiles that changed last step plus their neighbours, so still lifes, empty regions
+    // and settled debris are never rescanned.
+    //
+    // Same interface and rules as LifeGrid, including dead cells outside width x height, so the two
+    // are interchangeable.
+    class SparseLifeGrid {
+    public:
+        static constexpr int kTileSize = 64;
+
+        SparseLifeGrid(int width, int height)
+            : width(std::max(1, width)), height(std::max(1, height)),
+            tilesX((this->width + kTileSize - 1) / kTileSize), tilesY((this->height + kTileSize - 1) / kTileSize) {
+        }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        size_t getTileCount() const { return tiles.size(); }
+        size_t getActiveTileCount() const { return dirtyTiles.size(); }
+
+        // The 64 row words of tile (tx, ty), or null where the tile is empty and not stored
+        const std::uint64_t* tileCells(int tx, int ty) const {
+            const Tile* tile = Find(tx, ty);
+            return tile ? tile->cells.data() : nullptr;
+        }
+
+        // Calls fn(tx, ty) for every tile whose cells changed in the last step or through set() or
+        // randomize() since. Renderers use it to redraw only those tiles.
+        template <typename Fn>
+        void forEachChangedTile(Fn&& fn) const {
+            for (std::uint64_t key : dirtyTiles) {
+                fn(static_cast<int>(static_cast<std::uint32_t>(key)), static_cast<int>(key >> 32));
+            }
+        }
+
+        template <typename Fn>
+        void forEachLiveCell(Fn&& fn) const {
+            for (const auto& tile : tiles) {
+                for (int row = 0; row < kTileSize; ++row) {
+                    for (std::uint64_t bits = tile.cells[row]; bits != 0; bits &= bits - 1) {
+                        fn(tile.tx * kTileSize + std::countr_zero(bits), tile.ty * kTileSize + row);
+                    }
+                }
+            }
+        }
+
+        bool get(int x, int y) const {
+            if (x < 0 || x >= width || y < 0 || y >= height) return false;
+            auto it = index.find(Key(x / kTileSize, y / kTileSize));
+            if (it == index.end()) return false;
+            return (tiles[it->second].cells[y % kTileSize] >> (x % kTileSize)) & 1;
+        }
+
+        void set(int x, int y, bool alive) {
+            if (x < 0 || x >= width || y < 0 || y >= height) return;
+            const int tx = x / kTileSize, ty = y / kTileSize;
+            auto it = index.find(Key(tx, ty));
+            if (it == index.end() && !alive) return;
+
+            Tile& tile = it == index.end() ? tiles[CreateTile(tx, ty)] : tiles[it->second];
+            std::uint64_t& word = tile.cells[y % kTileSize];
+            const std::uint64_t bit = 1ull << (x % kTileSize);
+            word = alive ? (word | bit) : (word & ~bit);
+            MarkDirty(tile, kAllEdges);
+        }
+
+        void clear() {
+            tiles.clear();
+            index.clear();
+            dirtyTiles.clear();
+        }
+
+        // Same fill as LifeGrid::randomize (row by row, a word at a time), so this materialises every
+        // tile of the world
+        void randomize(std::uint64_t seed) {
+            clear();
+            for (int ty = 0; ty < tilesY; ++ty) {
+                for (int tx = 0; tx < tilesX; ++tx) {
+                    MarkDirty(tiles[CreateTile(tx, ty)], kAllEdges);
+                }
+            }
+
+            std::uint64_t state = seed ? seed : 0x9E3779B97F4A7C15ull;
+            for (int y = 0; y < height; ++y) {
+                for (int tx = 0; tx < tilesX; ++tx) {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    tiles[static_cast<size_t>(y / kTileSize) * tilesX + tx].cells[y % kTileSize] = state;
+                }
+            }
+
+            for (auto& tile : tiles) {
+                ClipToWorld(tile, tile.cells);
+            }
+        }
+
+        size_t population() const {
+            size_t count = 0;
+            for (const auto& tile : tiles) {
+                for (std::uint64_t word : tile.cells) {
+                    count += static_cast<size_t>(std::popcount(word));
+                }
+            }
+            return count;
+        }
+
+        void step(ThreadPool* pool = nullptr) {
+            ALMOND_PROFILE_SCOPE("SparseLifeGrid::step");
+            CollectActiveTiles();
+
+            // Tiles are computed independently into their own next buffers, so they run in parallel
+            // in batches; the map is only read here
+            constexpr size_t kBatch = 16;
+            auto computeBatch = [this](size_t batch) {
+                const size_t end = std::min(active.size(), (batch + 1) * kBatch);
+                for (size_t i = batch * kBatch; i < end; ++i) {
+                    ComputeTile(tiles[active[i]]);
+                }
+            };
+            const size_t batches = (active.size() + kBatch - 1) / kBatch;
+            if (pool && batches > 1) {
+                pool->parallelFor(batches, computeBatch);
+            }
+            else {
+                for (size_t batch = 0; batch < batches; ++batch) computeBatch(batch);
+            }
+
+            CommitActiveTiles();
+        }
+
+    private:
+        // Edges whose cells changed (in either generation), i.e. which neighbours may now change
+        enum Edge : std::uint8_t {
+            kNorth = 1 << 0, kSouth = 1 << 1, kWest = 1 << 2, kEast = 1 << 3,
+            kNorthWest = 1 << 4, kNorthEast = 1 << 5, kSouthWest = 1 << 6, kSouthEast = 1 << 7,
+            kAllEdges = 0xFF
+        };
+
+        struct Neighbour { int dx, dy; std::uint8_t edge; };
+        static constexpr std::array<Neighbour, 8> kNeighbours = { {
+            { 0, -1, kNorth }, { 0, 1, kSouth }, { -1, 0, kWest }, { 1, 0, kEast },
+            { -1, -1, kNorthWest }, { 1, -1, kNorthEast }, { -1, 1, kSouthWest }, { 1, 1, kSouthEast },
+        } };
+
+        struct Tile {
+            int tx = 0;
+            int ty = 0;
+            std::array<std::uint64_t, kTileSize> cells{};
+            std::array<std::uint64_t, kTileSize> next{};
+            std::uint32_t activeStamp = 0;
+            std::uint8_t dirtyEdges = 0;  // Edges touched since the last step
+            bool dirty = false;           // Listed in dirtyTiles
+            std::uint8_t changedEdges = 0;
+            bool changed = false;
+        };
+
+        int width;
+        int height;
+        int tilesX;
+        int tilesY;
+        std::uint32_t generation = 0;
+
+        std::vector<Tile> tiles;
+        std::unordered_map<std::uint64_t, size_t> index;
+        std::vector<std::uint64_t> dirtyTiles; // Keys of tiles touched since the last step; reused, so steps do not allocate
+        std::vector<size_t> active;
+
+        static std::uint64_t Key(int tx, int ty) {
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(ty)) << 32) | static_cast<std::uint32_t>(tx);
+        }
+
+        size_t CreateTile(int tx, int ty) {
+            const size_t slot = tiles.size();
+            tiles.emplace_back();
+            tiles.back().tx = tx;
+            tiles.back().ty = ty;
+            index.emplace(Key(tx, ty), slot);
+            return slot;
+        }
+
+        // Swap-removes a tile; only called once nothing holds tile indices
+        void RemoveTile(size_t slot) {
+            index.erase(Key(tiles[slot].tx, tiles[slot].ty));
+            if (slot != tiles.size() - 1) {
+                tiles[slot] = tiles.back();
+                index[Key(tiles[slot].tx, tiles[slot].ty)] = slot;
+            }
+            tiles.pop_back();
+        }
+
+        void MarkDirty(Tile& tile, std::uint8_t edges) {
+            if (!tile.dirty) {
+                tile.dirty = true;
+                dirtyTiles.push_back(Key(tile.tx, tile.ty));
+            }
+            tile.dirtyEdges |= edges;
+        }
+
+        // Cells past the world's right and bottom edges stay dead
+        void ClipToWorld(const Tile& tile, std::array<std::uint64_t, kTileSize>& cells) const {
+            const int columns = std::min(kTileSize, width - tile.tx * kTileSize);
+            const int rows = std::min(kTileSize, height - tile.ty * kTileSize);
+            const std::uint64_t mask = columns == kTileSize ? ~0ull : (1ull << columns) - 1;
+            for (int row = 0; row < kTileSize; ++row) {
+                cells[row] = row < rows ? (cells[row] & mask) : 0;
+            }
+        }
+
+        // Dirty tiles and their neighbours. A missing neighbour is only created when an edge facing
+        // it changed; otherwise nothing it could see is different and it stays empty.
+        void CollectActiveTiles() {
+            ++generation;
+            active.clear();
+            auto activate = [this](size_t slot) {
+                if (tiles[slot].activeStamp != generation) {
+                    tiles[slot].activeStamp = generation;
+                    active.push_back(slot);
+                }
+            };
+
+            for (std::uint64_t key : dirtyTiles) {
+                const int tx = static_cast<int>(static_cast<std::uint32_t>(key));
+                const int ty = static_cast<int>(key >> 32);
+                std::uint8_t edges = 0;
+                if (auto it = index.find(key); it != index.end()) {
+                    Tile& tile = tiles[it->second];
+                    edges = tile.dirtyEdges;
+                    tile.dirtyEdges = 0;
+                    tile.dirty = false;
+                    activate(it->second);
+                }
+
+                for (const auto& n : kNeighbours) {
+                    const int nx = tx + n.dx, ny = ty + n.dy;
+                    if (nx < 0 || nx >= tilesX || ny < 0 || ny >= tilesY) continue;
+                    if (auto it = index.find(Key(nx, ny)); it != index.end()) {
+                        activate(it->second);
+                    }
+                    else if (edges & n.edge) {
+                        activate(CreateTile(nx, ny));
+                    }
+                }
+            }
+            dirtyTiles.clear();
+        }
+
+        const Tile* Find(int tx, int ty) const {
+            auto it = index.find(Key(tx, ty));
+            return it == index.end() ? nullptr : &tiles[it->second];
+        }
+
+        void ComputeTile(Tile& tile) const {
+            // Three columns of 66 rows: this tile and its west/east neighbours, each with one row of
+            // the tiles above and below. Only bit 63 / bit 0 of the side columns are ever read.
+            std::uint64_t west[kTileSize + 2]{}, centre[kTileSize + 2]{}, east[kTileSize + 2]{};
+            for (int dx = -1; dx <= 1; ++dx) {
+                std::uint64_t* column = dx < 0 ? west : (dx > 0 ? east : centre);
+                if (const Tile* t = dx == 0 ? &tile : Find(tile.tx + dx, tile.ty)) {
+                    std::copy(t->cells.begin(), t->cells.end(), column + 1);
+                }
+                if (const Tile* above = Find(tile.tx + dx, tile.ty - 1)) column[0] = above->cells[kTileSize - 1];
+                if (const Tile* below = Find(tile.tx + dx, tile.ty + 1)) column[kTileSize + 1] = below->cells[0];
+            }
+
+            for (int row = 0; row < kTileSize; ++row) {
+                tile.next[row] = life::StepWord(west[row], centre[row], east[row],
+                    west[row + 1], centre[row + 1], east[row + 1],
+                    west[row + 2], centre[row + 2], east[row + 2]);
+            }
+            ClipToWorld(tile, tile.next);
+
+            std::uint64_t changedBits = 0, westBits = 0, eastBits = 0;
+            for (int row = 0; row < kTileSize; ++row) {
+                const std::uint64_t touched = tile.next[row] ^ tile.cells[row];
+                const std::uint64_t either = tile.next[row] | tile.cells[row];
+                changedBits |= touched;
+                westBits |= either & 1;
+                eastBits |= either >> 63;
+            }
+
+            tile.changed = changedBits != 0;
+            tile.changedEdges = 0;
+            if (tile.changed) {
+                const std::uint64_t top = tile.next[0] | tile.cells[0];
+                const std::uint64_t bottom = tile.next[kTileSize - 1] | tile.cells[kTileSize - 1];
+                if (top) tile.changedEdges |= kNorth;
+                if (bottom) tile.changedEdges |= kSouth;
+                if (westBits) tile.changedEdges |= kWest;
+                if (eastBits) tile.changedEdges |= kEast;
+                if (top & 1) tile.changedEdges |= kNorthWest;
+                if (top >> 63) tile.changedEdges |= kNorthEast;
+                if (bottom & 1) tile.changedEdges |= kSouthWest;
+                if (bottom >> 63) tile.changedEdges |= kSouthEast;
+            }
+        }
+
+        // Publishes next generations and drops tiles that are empty and settled
+        void CommitActiveTiles() {
+            std::pmr::vector<size_t> emptied(FrameArena::Get().Resource());
+            for (size_t slot : active) {
+                Tile& tile = tiles[slot];
+                if (tile.changed) {
+                    tile.cells = tile.next;
+                    MarkDirty(tile, tile.changedEdges);
+                }
+                else if (std::all_of(tile.cells.begin(), tile.cells.end(), [](std::uint64_t word) { return word == 0; })) {
+                    emptied.push_back(slot);
+                }
+            }
+
+            // Highest slots first so swap-removal never moves a tile that is still to be removed
+            std::sort(emptied.begin(), emptied.end(), std::greater<size_t>());
+            for (size_t slot : emptied) {
+                RemoveTile(slot);
+            }
+        }
+    };
+
+} // namespace almond
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "alsTexturePool.h"
+#include "alsBakedAtlas.h"
+#include <cstdint>
+#include <fstream>
+#include <sstream>
 #include <tuple>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <stdexcept>
 #include <iostream>
 
@@ -11,47 +16,235 @@ namespace almond {
 namespace SpriteBank {
     using Sprite = std::tuple<almond::texturepool::Texture, float, float, float, float, int, int>; // (Texture, uMin, vMin, uMax, vMax, width, height)
 
-    // Lazy-loaded sprite bank (sprite name -> sprite data)
+    // Names are interned to IDs when sprites are added; everything after that is an array index
+    using SpriteID = std::uint32_t;
+    inline constexpr SpriteID InvalidSprite = 0xFFFFFFFFu;
+
+    // Sprite records as parallel arrays indexed by SpriteID, so a render loop touching only UVs
+    // streams through the UV columns. Sprites from a baked atlas uploaded as one array texture
+    // (OpenGLBakedAtlas) have no per-page texture; they carry the array's texture name and their
+    // layer in it instead, so every sprite of the atlas can go in one draw.
+    struct SpriteTable {
+        std::vector<float> uMin, vMin, uMax, vMax;
+        std::vector<int> width, height;
+        std::vector<std::uint16_t> layer;              // Baked atlas page; 0 for plain textures
+        std::vector<almond::texturepool::Texture> texture;
+        std::vector<std::uint32_t> arrayTexture;       // GL_TEXTURE_2D_ARRAY name, or 0 when texture is used
+        std::vector<std::string> name;                 // Empty for freed slots
+        std::unordered_map<std::string, SpriteID> ids; // Only consulted when resolving names
+        std::vector<SpriteID> freeIDs;
+
+        size_t size() const { return name.size(); }
+    };
+
+    // Lazy-loaded sprite bank
     inline auto& getBank() {
-        static std::unordered_map<std::string, Sprite> bank;
+        static SpriteTable bank;
         return bank;
     }
 
-    // Add a sprite to the bank
-    inline void addSprite(const std::string& name, const std::filesystem::path& filepath,
-        float uMin, float vMin, float uMax, float vMax, int width, int height) {
-        auto texture = TexturePool::loadTexture(filepath);
+    // Add a sprite to the bank and return its ID
+    inline SpriteID addSprite(const std::string& name, const almond::texturepool::Texture& texture,
+        float uMin, float vMin, float uMax, float vMax, int width, int height,
+        std::uint16_t layer = 0, std::uint32_t arrayTexture = 0) {
         auto& bank = getBank();
-
-        if (!bank.emplace(name, Sprite{ texture, uMin, vMin, uMax, vMax, width, height }).second) {
+        if (bank.ids.count(name)) {
             throw std::runtime_error("Sprite with name '" + name + "' already exists.");
         }
 
+        SpriteID id;
+        if (!bank.freeIDs.empty()) {
+            id = bank.freeIDs.back();
+            bank.freeIDs.pop_back();
+        }
+        else {
+            id = static_cast<SpriteID>(bank.size());
+            if (id == InvalidSprite) {
+                throw std::runtime_error("Sprite bank is full.");
+            }
+            bank.uMin.emplace_back(); bank.vMin.emplace_back(); bank.uMax.emplace_back(); bank.vMax.emplace_back();
+            bank.width.emplace_back(); bank.height.emplace_back();
+            bank.layer.emplace_back();
+            bank.texture.emplace_back();
+            bank.arrayTexture.emplace_back();
+            bank.name.emplace_back();
+        }
+
+        bank.uMin[id] = uMin;
+        bank.vMin[id] = vMin;
+        bank.uMax[id] = uMax;
+        bank.vMax[id] = vMax;
+        bank.width[id] = width;
+        bank.height[id] = height;
+        bank.layer[id] = layer;
+        bank.texture[id] = texture;
+        bank.arrayTexture[id] = arrayTexture;
+        bank.name[id] = name;
+        bank.ids.emplace(name, id);
+        return id;
+    }
+
+    inline SpriteID addSprite(const std::string& name, const std::filesystem::path& filepath,
+        float uMin, float vMin, float uMax, float vMax, int width, int height) {
+        auto texture = texturepool::loadTexture(filepath);
+        auto id = addSprite(name, texture, uMin, vMin, uMax, vMax, width, height);
+
+#ifdef _DEBUG
         std::cout << "Added sprite: " << name << " from texture: " << filepath << "\n";
+#endif
+        return id;
     }
 
-    // Get a sprite from the bank
-    inline auto getSprite(const std::string& name) -> const Sprite& {
+    // Add every sprite from a baked atlas manifest; pageTextures[i] is the texture for page i
+    inline void addBakedAtlas(const BakedAtlas& atlas, const std::vector<almond::texturepool::Texture>& pageTextures) {
         auto& bank = getBank();
-        if (auto it = bank.find(name); it != bank.end()) {
-            return it->second;
+        const auto& names = atlas.GetSpriteNames();
+        const auto& sprites = atlas.GetSprites();
+        bank.ids.reserve(bank.ids.size() + sprites.size());
+
+        for (size_t i = 0; i < sprites.size(); ++i) {
+            const auto& sprite = sprites[i];
+            if (sprite.page >= pageTextures.size()) {
+                throw std::runtime_error("No texture supplied for baked atlas page " + std::to_string(sprite.page) + ".");
+            }
+            addSprite(names[i], pageTextures[sprite.page], sprite.uMin, sprite.vMin, sprite.uMax, sprite.vMax, sprite.width, sprite.height, sprite.page);
         }
-        throw std::runtime_error("Sprite with name '" + name + "' not found.");
     }
 
-    // Remove a sprite from the bank
-    inline void removeSprite(const std::string& name) {
+    // Add every sprite from a baked atlas whose pages were uploaded as the layers of one array
+    // texture, e.g. addBakedAtlas(glAtlas.GetAtlas(), glAtlas.GetTexture()). The bank does not own
+    // the texture; remove the sprites before destroying it.
+    inline void addBakedAtlas(const BakedAtlas& atlas, std::uint32_t arrayTexture) {
         auto& bank = getBank();
-        if (bank.erase(name)) {
-            std::cout << "Removed sprite: " << name << "\n";
+        const auto& names = atlas.GetSpriteNames();
+        const auto& sprites = atlas.GetSprites();
+        bank.ids.reserve(bank.ids.size() + sprites.size());
+
+        for (size_t i = 0; i < sprites.size(); ++i) {
+            const auto& sprite = sprites[i];
+            addSprite(names[i], nullptr, sprite.uMin, sprite.vMin, sprite.uMax, sprite.vMax, sprite.width, sprite.height, sprite.page, arrayTexture);
+        }
+    }
+
+    // Batch-load sprites from a text manifest, one per line:
+    //   name texturePath uMin vMin uMax vMax width height
+    // Blank lines and lines starting with '#' are skipped; relative texture paths are resolved
+    // against the manifest's directory. Returns the number of sprites added.
+    inline size_t loadManifest(const std::filesystem::path& manifestPath) {
+        std::ifstream file(manifestPath);
+        if (!file) {
+            throw std::runtime_error("Failed to open sprite manifest: " + manifestPath.string());
+        }
+
+        const auto baseDir = manifestPath.parent_path();
+        std::unordered_map<std::string, almond::texturepool::Texture> textures; // One pool lookup per texture, not per sprite
+        size_t added = 0;
+        size_t lineNumber = 0;
+        std::string line;
+
+        while (std::getline(file, line)) {
+            ++lineNumber;
+            if (line.empty() || line[0] == '#') continue;
+
+            std::istringstream fields(line);
+            std::string name, texturePath;
+            float uMin, vMin, uMax, vMax;
+            int width, height;
+            if (!(fields >> name >> texturePath >> uMin >> vMin >> uMax >> vMax >> width >> height)) {
+                throw std::runtime_error("Malformed sprite manifest line " + std::to_string(lineNumber) + ": " + manifestPath.string());
+            }
+
+            auto& texture = textures[texturePath];
+            if (!texture) {
+                std::filesystem::path resolved = texturePath;
+                texture = texturepool::loadTexture(resolved.is_relative() ? baseDir / resolved : resolved);
+            }
+
+            addSprite(name, texture, uMin, vMin, uMax, vMax, width, height);
+            ++added;
         }
+
+        return added;
+    }
+
+    // Resolve a name once (at load time) and keep the ID; InvalidSprite if unknown
+    inline SpriteID findSprite(const std::string& name) {
+        auto& bank = getBank();
+        auto it = bank.ids.find(name);
+        return it != bank.ids.end() ? it->second : InvalidSprite;
+    }
+
+    inline SpriteID getSpriteID(const std::string& name) {
+        SpriteID id = findSprite(name);
+        if (id == InvalidSprite) {
+            throw std::runtime_error("Sprite with name '" + name + "' not found.");
+        }
+        return id;
+    }
+
+    // Hot-path accessors: plain array reads, no hashing. IDs must come from the bank.
+    inline void getUVs(SpriteID id, float& uMin, float& vMin, float& uMax, float& vMax) {
+        const auto& bank = getBank();
+        uMin = bank.uMin[id];
+        vMin = bank.vMin[id];
+        uMax = bank.uMax[id];
+        vMax = bank.vMax[id];
+    }
+
+    inline const almond::texturepool::Texture& getTexture(SpriteID id) {
+        return getBank().texture[id];
+    }
+
+    // Sprites sharing an array texture batch together, sampled at vec3(uv, layer)
+    inline std::uint32_t getArrayTexture(SpriteID id) {
+        return getBank().arrayTexture[id];
+    }
+
+    inline std::uint16_t getLayer(SpriteID id) {
+        return getBank().layer[id];
+    }
+
+    inline std::tuple<int, int> getSize(SpriteID id) {
+        const auto& bank = getBank();
+        return { bank.width[id], bank.height[id] };
+    }
+
+    // Get a sprite from the bank
+    inline auto getSprite(SpriteID id) -> Sprite {
+        const auto& bank = getBank();
+        if (id >= bank.size() || bank.name[id].empty()) {
+            throw std::runtime_error("Sprite ID " + std::to_string(id) + " not found.");
+        }
+        return Sprite{ bank.texture[id], bank.uMin[id], bank.vMin[id], bank.uMax[id], bank.vMax[id], bank.width[id], bank.height[id] };
+    }
+
+    inline auto getSprite(const std::string& name) -> Sprite {
+        return getSprite(getSpriteID(name));
+    }
+
+    // Remove a sprite from the bank; its ID may be reused by a later addSprite
+    inline void removeSprite(const std::string& name) {
+        auto& bank = getBank();
+        auto it = bank.ids.find(name);
+        if (it == bank.ids.end()) return;
+
+        SpriteID id = it->second;
+        bank.ids.erase(it);
+        bank.texture[id].reset();
+        bank.arrayTexture[id] = 0;
+        bank.name[id].clear();
+        bank.freeIDs.push_back(id);
+#ifdef _DEBUG
+        std::cout << "Removed sprite: " << name << "\n";
+#endif
     }
 
     // Clear all sprites from the bank
     inline void clear() {
-        auto& bank = getBank();
-        bank.clear();
+        getBank() = SpriteTable{};
+#ifdef _DEBUG
         std::cout << "Cleared all sprites.\n";
+#endif
     }
 }
-}
\ No newline at end of file
+}
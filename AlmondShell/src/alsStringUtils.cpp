@@ -19,3 +19,34 @@ std::string ConvertToUtf8(const std::wstring& wide) {
     }
     return utf8;
 }
+
+char32_t DecodeUtf8(const std::string& text, size_t& index) {
+    const auto lead = static_cast<unsigned char>(text[index++]);
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    int extra = 0;
+    char32_t codepoint = 0;
+    if ((lead & 0xE0) == 0xC0) { extra = 1; codepoint = lead & 0x1F; }
+    else if ((lead & 0xF0) == 0xE0) { extra = 2; codepoint = lead & 0x0F; }
+    else if ((lead & 0xF8) == 0xF0) { extra = 3; codepoint = lead & 0x07; }
+    else {
+        return U'\uFFFD'; // Stray continuation byte or invalid lead byte
+    }
+
+    if (index + extra > text.size()) {
+        return U'\uFFFD';
+    }
+
+    for (int i = 0; i < extra; ++i) {
+        const auto next = static_cast<unsigned char>(text[index + i]);
+        if ((next & 0xC0) != 0x80) {
+            return U'\uFFFD';
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    index += extra;
+    return codepoint;
+}
@@ -2,3 +2,7 @@
 #include <string>
 
 std::string ConvertToUtf8(const std::wstring& wide);
+
+// Decodes the UTF-8 sequence starting at text[index] and advances index past it.
+// Malformed or truncated sequences yield U+FFFD and consume a single byte.
+char32_t DecodeUtf8(const std::string& text, size_t& index);
@@ -18,7 +18,9 @@ namespace almond {
             GREY8,   // 8 bits per channel grayscale
             DXT1,
             ASTC,
-            ETC2
+            ETC2,
+            DXT5,
+            BC7
         };
 
         virtual ~Texture() = default;
@@ -35,6 +37,7 @@ namespace almond {
         virtual int GetHeight() const = 0;
         virtual unsigned int GetID() const = 0;
         virtual std::filesystem::path GetPath() const = 0;
+        virtual Format GetFormat() const { return Format::RGBA8; }
 
 
         // Retrieve raw texture data (to be implemented by the derived class)
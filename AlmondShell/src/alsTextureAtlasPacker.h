@@ -1,67 +1,376 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <tuple>
+#include <utility>
 #include <sstream>
+#include <vector>
 
 namespace almond {
-    struct Node {
-        int x, y, width, height;
-        bool used = false;
-        std::unique_ptr<Node> right, down;
+    struct AtlasRect {
+        int x = -1, y = -1, width = 0, height = 0;
 
-        Node(int x, int y, int width, int height)
-            : x(x), y(y), width(width), height(height) {
-        }
+        bool IsValid() const { return x >= 0 && y >= 0; }
+        bool operator==(const AtlasRect&) const = default;
     };
 
-    class TexturePacker {
-        std::unique_ptr<Node> root;
+    // MaxRects allocator using the best-short-side-fit heuristic. Free space is tracked as a list of
+    // maximal (possibly overlapping) rectangles, so memory scales with the number of packed
+    // rectangles rather than the atlas area. Supports removal, growth and full defragmentation.
+    class AtlasAllocator {
+        int width;
+        int height;
+        std::vector<AtlasRect> freeRects;
+        std::vector<AtlasRect> usedRects;
+        std::vector<AtlasRect> newFreeRects; // Scratch list reused by SplitFreeRects
 
     public:
-        TexturePacker(int width, int height)
-            : root(std::make_unique<Node>(0, 0, width, height)) {
+        AtlasAllocator(int width, int height)
+            : width(width), height(height) {
+            freeRects.push_back({ 0, 0, width, height });
+        }
+
+        // Returns the placed rectangle, or an invalid rect if there is no room
+        AtlasRect Insert(int rectWidth, int rectHeight) {
+            if (rectWidth <= 0 || rectHeight <= 0) {
+                return {};
+            }
+
+            AtlasRect best;
+            int bestShortSide = std::numeric_limits<int>::max();
+            int bestLongSide = std::numeric_limits<int>::max();
+
+            for (const AtlasRect& free : freeRects) {
+                if (rectWidth > free.width || rectHeight > free.height) continue;
+
+                int leftoverX = free.width - rectWidth;
+                int leftoverY = free.height - rectHeight;
+                int shortSide = std::min(leftoverX, leftoverY);
+                int longSide = std::max(leftoverX, leftoverY);
+
+                if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
+                    best = { free.x, free.y, rectWidth, rectHeight };
+                    bestShortSide = shortSide;
+                    bestLongSide = longSide;
+                }
+            }
+
+            if (!best.IsValid()) {
+                return {};
+            }
+
+            Place(best);
+            return best;
+        }
+
+        // Returns a previously inserted rectangle to the free list
+        bool Remove(const AtlasRect& rect) {
+            auto it = std::find(usedRects.begin(), usedRects.end(), rect);
+            if (it == usedRects.end()) {
+                return false;
+            }
+
+            *it = usedRects.back();
+            usedRects.pop_back();
+
+            freeRects.push_back(rect);
+            MergeFreeRects();
+            return true;
         }
 
-        std::tuple<int, int> Insert(int width, int height) {
-            auto node = Insert(root.get(), width, height);
-            if (!node) {
-                std::ostringstream oss;
-                oss << "Failed to insert texture ("
-                    << width << "x" << height << ") into atlas ("
-                    << root->width << "x" << root->height << ").";
-                throw std::runtime_error(oss.str());
+        // Extends the allocatable area; existing placements are unchanged
+        void Grow(int newWidth, int newHeight) {
+            if (newWidth < width || newHeight < height) {
+                throw std::runtime_error("AtlasAllocator cannot shrink.");
             }
-            return { node->x, node->y };
+            if (newWidth == width && newHeight == height) return;
+
+            // Free rects touching the old border now continue into the new area
+            for (AtlasRect& free : freeRects) {
+                if (free.x + free.width == width) free.width = newWidth - free.x;
+                if (free.y + free.height == height) free.height = newHeight - free.y;
+            }
+            if (newWidth > width) freeRects.push_back({ width, 0, newWidth - width, newHeight });
+            if (newHeight > height) freeRects.push_back({ 0, height, newWidth, newHeight - height });
+
+            width = newWidth;
+            height = newHeight;
+            PruneFreeRects();
+        }
+
+        // Repacks every live rectangle from scratch, largest first. Returns (old, new) pairs for the
+        // rectangles that moved so the caller can relocate texels; returns nothing and leaves the
+        // layout untouched if the repack would not fit.
+        std::vector<std::pair<AtlasRect, AtlasRect>> Defragment() {
+            std::vector<AtlasRect> order = usedRects;
+            std::sort(order.begin(), order.end(), [](const AtlasRect& a, const AtlasRect& b) {
+                return std::max(a.width, a.height) > std::max(b.width, b.height);
+            });
+
+            AtlasAllocator repacked(width, height);
+            std::vector<std::pair<AtlasRect, AtlasRect>> moves;
+            moves.reserve(order.size());
+
+            for (const AtlasRect& rect : order) {
+                AtlasRect placed = repacked.Insert(rect.width, rect.height);
+                if (!placed.IsValid()) {
+                    return {};
+                }
+                if (placed != rect) {
+                    moves.emplace_back(rect, placed);
+                }
+            }
+
+            *this = std::move(repacked);
+            return moves;
+        }
+
+        void Reset() {
+            freeRects.clear();
+            usedRects.clear();
+            freeRects.push_back({ 0, 0, width, height });
+        }
+
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+        size_t GetUsedCount() const { return usedRects.size(); }
+
+        // Fraction of the atlas area covered by live rectangles
+        float GetOccupancy() const {
+            long long used = 0;
+            for (const AtlasRect& rect : usedRects) used += static_cast<long long>(rect.width) * rect.height;
+            return static_cast<float>(used) / (static_cast<float>(width) * height);
         }
 
     private:
-        Node* Insert(Node* node, int width, int height) {
-            if (!node) return nullptr;
+        static bool Intersects(const AtlasRect& a, const AtlasRect& b) {
+            return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+        }
+
+        static bool Contains(const AtlasRect& outer, const AtlasRect& inner) {
+            return inner.x >= outer.x && inner.y >= outer.y &&
+                inner.x + inner.width <= outer.x + outer.width &&
+                inner.y + inner.height <= outer.y + outer.height;
+        }
+
+        void Place(const AtlasRect& placed) {
+            newFreeRects.clear();
+
+            for (size_t i = 0; i < freeRects.size();) {
+                if (Intersects(freeRects[i], placed)) {
+                    SplitFreeRect(freeRects[i], placed);
+                    freeRects[i] = freeRects.back();
+                    freeRects.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+
+            // A split-off piece is a subset of a rect that was maximal, so no surviving free rect can be
+            // contained in it; only the new pieces themselves need filtering.
+            const size_t oldCount = freeRects.size();
+            for (size_t i = 0; i < newFreeRects.size(); ++i) {
+                const AtlasRect& candidate = newFreeRects[i];
+                bool redundant = false;
+                for (size_t j = 0; j < oldCount && !redundant; ++j) {
+                    redundant = Contains(freeRects[j], candidate);
+                }
+                for (size_t j = 0; j < newFreeRects.size() && !redundant; ++j) {
+                    if (i == j) continue;
+                    // Keep the first of two identical pieces
+                    redundant = Contains(newFreeRects[j], candidate) && (newFreeRects[j] != candidate || j < i);
+                }
+                if (!redundant) {
+                    freeRects.push_back(candidate);
+                }
+            }
 
-            if (node->used) {
-                Node* result = Insert(node->right.get(), width, height);
-                return result ? result : Insert(node->down.get(), width, height);
+            usedRects.push_back(placed);
+        }
+
+        // Carves the placed rect out of a free rect, emitting up to four maximal leftovers
+        void SplitFreeRect(const AtlasRect& free, const AtlasRect& used) {
+            if (used.x > free.x) {
+                newFreeRects.push_back({ free.x, free.y, used.x - free.x, free.height });
+            }
+            if (used.x + used.width < free.x + free.width) {
+                int x = used.x + used.width;
+                newFreeRects.push_back({ x, free.y, free.x + free.width - x, free.height });
+            }
+            if (used.y > free.y) {
+                newFreeRects.push_back({ free.x, free.y, free.width, used.y - free.y });
+            }
+            if (used.y + used.height < free.y + free.height) {
+                int y = used.y + used.height;
+                newFreeRects.push_back({ free.x, y, free.width, free.y + free.height - y });
             }
+        }
+
+        // Drops free rects fully contained in another one
+        void PruneFreeRects() {
+            for (size_t i = 0; i < freeRects.size(); ++i) {
+                for (size_t j = i + 1; j < freeRects.size(); ++j) {
+                    if (Contains(freeRects[j], freeRects[i])) {
+                        freeRects.erase(freeRects.begin() + i);
+                        --i;
+                        break;
+                    }
+                    if (Contains(freeRects[i], freeRects[j])) {
+                        freeRects.erase(freeRects.begin() + j);
+                        --j;
+                    }
+                }
+            }
+        }
+
+        // Grows the freed rect across neighbours that share a full edge with it, then drops whatever
+        // it now covers
+        void MergeFreeRects() {
+            AtlasRect merged = freeRects.back();
+            freeRects.pop_back();
 
-            if (width > node->width || height > node->height) return nullptr;
+            bool grew = true;
+            while (grew) {
+                grew = false;
+                for (size_t i = 0; i < freeRects.size(); ++i) {
+                    const AtlasRect& other = freeRects[i];
 
-            if (width == node->width && height == node->height) {
-                node->used = true;
-                return node;
+                    if (merged.x == other.x && merged.width == other.width &&
+                        (merged.y + merged.height == other.y || other.y + other.height == merged.y)) {
+                        merged.y = std::min(merged.y, other.y);
+                        merged.height += other.height;
+                    }
+                    else if (merged.y == other.y && merged.height == other.height &&
+                        (merged.x + merged.width == other.x || other.x + other.width == merged.x)) {
+                        merged.x = std::min(merged.x, other.x);
+                        merged.width += other.width;
+                    }
+                    else {
+                        continue;
+                    }
+
+                    freeRects.erase(freeRects.begin() + i);
+                    grew = true;
+                    break;
+                }
+            }
+
+            for (size_t i = 0; i < freeRects.size();) {
+                if (Contains(freeRects[i], merged)) return;
+                if (Contains(merged, freeRects[i])) {
+                    freeRects[i] = freeRects.back();
+                    freeRects.pop_back();
+                }
+                else {
+                    ++i;
+                }
             }
+            freeRects.push_back(merged);
+        }
+    };
 
-            // Split the node into right and down children
-            node->right = std::make_unique<Node>(node->x + width, node->y, node->width - width, height);
-            node->down = std::make_unique<Node>(node->x, node->y + height, node->width, node->height - height);
+    // Skyline bottom-left packer. Tracks only the top edge of the packed area, so its memory is
+    // proportional to the number of distinct heights rather than the page size. Space is reclaimed
+    // by resetting the whole page, which suits caches that evict at page granularity.
+    class SkylinePacker {
+        struct Segment {
+            int x, y, width;
+        };
 
-            node->width = width;
-            node->height = height;
-            node->used = true;
+        int width;
+        int height;
+        std::vector<Segment> skyline;
 
-            return node;
+    public:
+        SkylinePacker(int width, int height)
+            : width(width), height(height) {
+            Reset();
         }
 
+        // Returns the top-left corner of the placed rectangle, or (-1, -1) if it does not fit
+        std::tuple<int, int> Insert(int rectWidth, int rectHeight) {
+            int bestIndex = -1;
+            int bestY = std::numeric_limits<int>::max();
+            int bestWidth = std::numeric_limits<int>::max();
+
+            for (int i = 0; i < static_cast<int>(skyline.size()); ++i) {
+                int y = Fit(i, rectWidth, rectHeight);
+                if (y < 0) continue;
+
+                // Lowest top edge wins; ties go to the narrowest segment to limit wasted space
+                if (y < bestY || (y == bestY && skyline[i].width < bestWidth)) {
+                    bestIndex = i;
+                    bestY = y;
+                    bestWidth = skyline[i].width;
+                }
+            }
+
+            if (bestIndex == -1) {
+                return { -1, -1 };
+            }
+
+            int x = skyline[bestIndex].x;
+            AddLevel(bestIndex, x, bestY, rectWidth, rectHeight);
+            return { x, bestY };
+        }
+
+        void Reset() {
+            skyline.clear();
+            skyline.push_back({ 0, 0, width });
+        }
+
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+
+    private:
+        // Returns the y at which a rect starting at segment index fits, or -1
+        int Fit(int index, int rectWidth, int rectHeight) const {
+            int x = skyline[index].x;
+            if (x + rectWidth > width) return -1;
+
+            int widthLeft = rectWidth;
+            int y = skyline[index].y;
+            while (widthLeft > 0) {
+                y = std::max(y, skyline[index].y);
+                if (y + rectHeight > height) return -1;
+                widthLeft -= skyline[index].width;
+                ++index;
+                if (widthLeft > 0 && index >= static_cast<int>(skyline.size())) return -1;
+            }
+            return y;
+        }
+
+        void AddLevel(int index, int x, int y, int rectWidth, int rectHeight) {
+            skyline.insert(skyline.begin() + index, Segment{ x, y + rectHeight, rectWidth });
+
+            // Trim or remove the segments now covered by the new level
+            for (size_t i = index + 1; i < skyline.size();) {
+                const Segment& previous = skyline[i - 1];
+                Segment& current = skyline[i];
+                if (current.x >= previous.x + previous.width) break;
+
+                int shrink = previous.x + previous.width - current.x;
+                current.x += shrink;
+                current.width -= shrink;
+                if (current.width > 0) break;
+
+                skyline.erase(skyline.begin() + i);
+            }
+
+            // Merge neighbours that ended up at the same height
+            for (size_t i = 0; i + 1 < skyline.size();) {
+                if (skyline[i].y == skyline[i + 1].y) {
+                    skyline[i].width += skyline[i + 1].width;
+                    skyline.erase(skyline.begin() + i + 1);
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
     };
 }
@@ -1,8 +1,18 @@
 #pragma once
 
+#include "alsEngineConfig.h"
+#include "alsTexture.h"
 
+#ifdef ALMOND_USING_OPENGLTEXTURE
+#include "alsOpenGLTexture.h"
+#endif
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <memory>
@@ -11,45 +21,251 @@
 
 namespace almond {
     namespace texturepool {
-        using Texture = std::shared_ptr<std::string>;
+        // Callers hold strong references; the pool holds one more so an entry stays resident (and
+        // cached) after its last user lets go, until the memory budget forces it out.
+        //
+        // Dropping the pool's reference can destroy a GPU texture, which needs the GL context. So
+        // only the calls that remove entries (setBudget, trim, releaseTexture, clear) ever do it, and
+        // they belong on the render thread; loadTexture may run anywhere and never evicts, so the
+        // pool can overshoot its budget until the next trim().
+        using Texture = std::shared_ptr<almond::Texture>;
+        using AssetID = std::uint64_t;
+        using Loader = std::function<Texture(const std::filesystem::path&)>;
 
-        // Lazy-loaded texture map (file path -> texture)
+        // 64-bit FNV-1a of the normalized path, so "a/b.bmp" and "a\\b.bmp" share an entry
+        inline AssetID makeAssetID(const std::filesystem::path& filepath) {
+            const std::string key = filepath.lexically_normal().generic_string();
+            AssetID hash = 14695981039346656037ull;
+            for (unsigned char c : key) {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        namespace detail {
+            struct Entry {
+                std::string path;
+                std::shared_future<Texture> texture; // Shared while loading so other threads can wait on it
+                size_t bytes = 0;
+                std::list<AssetID>::iterator lruPosition;
+            };
+
+            struct Pool {
+                std::mutex mutex;
+                std::unordered_map<AssetID, Entry> entries;
+                std::list<AssetID> lru; // Front = most recently used
+                size_t residentBytes = 0;
+                size_t budgetBytes = 512ull * 1024 * 1024;
+                Loader loader;
+            };
+
+            inline size_t estimateBytes(const Texture& texture) {
+                if (!texture) return 0;
+
+                // Bits per texel, plus a third for the mip chain
+                size_t bits = 32;
+                switch (texture->GetFormat()) {
+                case almond::Texture::Format::RGB8: bits = 24; break;
+                case almond::Texture::Format::GREY8: bits = 8; break;
+                case almond::Texture::Format::DXT1: bits = 4; break;
+                case almond::Texture::Format::ETC2: // Assume the RGBA variant
+                case almond::Texture::Format::DXT5:
+                case almond::Texture::Format::BC7:
+                case almond::Texture::Format::ASTC: bits = 8; break;
+                default: break;
+                }
+                return static_cast<size_t>(texture->GetWidth()) * texture->GetHeight() * bits / 8 * 4 / 3;
+            }
+
+            inline Texture defaultLoad(const std::filesystem::path& filepath) {
+#ifdef ALMOND_USING_OPENGLTEXTURE
+                return std::make_shared<OpenGLTexture>(filepath, almond::Texture::Format::RGBA8, true);
+#else
+                throw std::runtime_error("No texture loader registered for: " + filepath.string());
+#endif
+            }
+
+            inline bool isReady(const Entry& entry) {
+                return entry.texture.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            }
+
+            // Evicts least recently used textures nobody else references until under budget.
+            // Caller holds the pool mutex.
+            inline void enforceBudget(Pool& pool) {
+                auto it = pool.lru.end();
+                while (pool.residentBytes > pool.budgetBytes && it != pool.lru.begin()) {
+                    --it;
+                    auto entryIt = pool.entries.find(*it);
+                    Entry& entry = entryIt->second;
+                    if (!isReady(entry)) continue;
+
+                    // use_count 1 means only the pool's copy is left
+                    const Texture* texture = nullptr;
+                    try { texture = &entry.texture.get(); }
+                    catch (...) {}
+                    if (texture && texture->use_count() > 1) continue;
+
+                    pool.residentBytes -= entry.bytes;
+                    it = pool.lru.erase(it);
+                    pool.entries.erase(entryIt);
+                }
+            }
+        }
+
+        // Lazy-loaded texture pool (asset ID -> texture)
         inline auto& getPool() {
-            static std::unordered_map<std::string, Texture> pool;
+            static detail::Pool pool;
             return pool;
         }
 
-        // Load a texture or fetch it from the pool
+        // Replaces how textures are created, e.g. to stream them. Must be callable from any thread
+        // that calls loadTexture.
+        inline void setLoader(Loader loader) {
+            auto& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.loader = std::move(loader);
+        }
+
+        // Load a texture or fetch it from the pool. Concurrent requests for the same asset load it
+        // once; the other callers wait for that load. Callable from any thread; the budget is only
+        // enforced by trim() and setBudget().
         inline auto loadTexture(const std::filesystem::path& filepath) -> Texture {
             auto& pool = getPool();
-            const std::string path = filepath.string();
+            const AssetID id = makeAssetID(filepath);
+
+            std::promise<Texture> promise;
+            Loader loader;
+            {
+                std::unique_lock<std::mutex> lock(pool.mutex);
+                if (auto it = pool.entries.find(id); it != pool.entries.end()) {
+                    detail::Entry& entry = it->second;
+                    if (entry.path != filepath.lexically_normal().generic_string()) {
+                        throw std::runtime_error("Texture asset ID collision between '" + entry.path + "' and '" + filepath.string() + "'.");
+                    }
+                    pool.lru.splice(pool.lru.begin(), pool.lru, entry.lruPosition); // Mark as most recently used
+                    auto texture = entry.texture;
+                    lock.unlock();
+                    return texture.get(); // Blocks only if another thread is still loading it
+                }
 
-            if (auto it = pool.find(path); it != pool.end()) {
-                return it->second; // Texture already loaded
+                detail::Entry entry;
+                entry.path = filepath.lexically_normal().generic_string();
+                entry.texture = promise.get_future().share();
+                pool.lru.push_front(id);
+                entry.lruPosition = pool.lru.begin();
+                pool.entries.emplace(id, std::move(entry));
+                loader = pool.loader ? pool.loader : detail::defaultLoad;
             }
 
-            // Simulate loading a texture
-            auto texture = std::make_shared<std::string>("Texture: " + path);
-            pool[path] = texture;
-            std::cout << "Loaded texture: " << path << "\n";
+            Texture texture;
+            try {
+                texture = loader(filepath);
+            }
+            catch (...) {
+                // Let waiters see the failure, then forget the entry so a later call can retry
+                promise.set_exception(std::current_exception());
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                if (auto it = pool.entries.find(id); it != pool.entries.end()) {
+                    pool.lru.erase(it->second.lruPosition);
+                    pool.entries.erase(it);
+                }
+                throw;
+            }
+            promise.set_value(texture);
+
+            {
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                if (auto it = pool.entries.find(id); it != pool.entries.end()) {
+                    it->second.bytes = detail::estimateBytes(texture);
+                    pool.residentBytes += it->second.bytes;
+                }
+            }
+
+#ifdef _DEBUG
+            std::cout << "Loaded texture: " << filepath.string() << "\n";
+#endif
             return texture;
         }
 
-        // Remove a texture from the pool
+        // Returns the texture if it is resident and finished loading, without loading it
+        inline auto findTexture(AssetID id) -> Texture {
+            auto& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            auto it = pool.entries.find(id);
+            if (it == pool.entries.end() || !detail::isReady(it->second)) {
+                return nullptr;
+            }
+            pool.lru.splice(pool.lru.begin(), pool.lru, it->second.lruPosition);
+            try { return it->second.texture.get(); }
+            catch (...) { return nullptr; }
+        }
+
+        // Remove a texture from the pool; outstanding references keep the GPU texture alive. Render
+        // thread only.
         inline void releaseTexture(const std::filesystem::path& filepath) {
             auto& pool = getPool();
-            const std::string path = filepath.string();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+
+            auto it = pool.entries.find(makeAssetID(filepath));
+            if (it != pool.entries.end() && detail::isReady(it->second)) {
+                pool.residentBytes -= it->second.bytes;
+                pool.lru.erase(it->second.lruPosition);
+                pool.entries.erase(it);
+#ifdef _DEBUG
+                std::cout << "Released texture: " << filepath.string() << "\n";
+#endif
+            }
+        }
+
+        // Resident memory budget in bytes; shrinking it evicts unused textures right away. Render
+        // thread only.
+        inline void setBudget(size_t bytes) {
+            auto& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.budgetBytes = bytes;
+            detail::enforceBudget(pool);
+        }
 
-            if (pool.erase(path)) {
-                std::cout << "Released texture: " << path << "\n";
+        // Re-measures textures whose size was unknown at load time (e.g. still streaming) and
+        // evicts down to the budget. Cheap enough to call once per frame; render thread only.
+        inline void trim() {
+            auto& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            for (auto& [id, entry] : pool.entries) {
+                if (entry.bytes != 0 || !detail::isReady(entry)) continue;
+                try {
+                    entry.bytes = detail::estimateBytes(entry.texture.get());
+                    pool.residentBytes += entry.bytes;
+                }
+                catch (...) {}
             }
+            detail::enforceBudget(pool);
         }
 
-        // Clear all textures from the pool
+        inline size_t getResidentBytes() {
+            auto& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            return pool.residentBytes;
+        }
+
+        // Clear all textures from the pool. Render thread only.
         inline void clear() {
             auto& pool = getPool();
-            pool.clear();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            for (auto it = pool.entries.begin(); it != pool.entries.end();) {
+                if (detail::isReady(it->second)) {
+                    pool.residentBytes -= it->second.bytes;
+                    pool.lru.erase(it->second.lruPosition);
+                    it = pool.entries.erase(it);
+                }
+                else {
+                    ++it; // Still loading; its loader will finish filling it in
+                }
+            }
+#ifdef _DEBUG
             std::cout << "Cleared all textures.\n";
+#endif
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,391 @@
+#pragma once
+
+#include "alsEngineConfig.h"
+#include "alsImageLoader.h"
+#include "alsMemoryTracker.h"
+#include "alsMetrics.h"
+#include "alsOpenGLTexture.h"
+#include "alsPixelKernels.h"
+#include "alsTexture.h"
+#include "alsThreadPool.h"
+
+#ifdef ALMOND_USING_OPENGLTEXTURE
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace almond {
+
+    // A texture whose pixels arrive asynchronously. Until the upload finishes it binds the
+    // streamer's placeholder, so callers can draw with it immediately.
+    class StreamedTexture : public almond::Texture {
+    public:
+        StreamedTexture(const std::filesystem::path& filepath, GLuint placeholder, bool generateMipmaps)
+            : filepath(filepath), placeholder(placeholder), generateMipmaps(generateMipmaps) {}
+
+        ~StreamedTexture() override {
+            if (id != 0) {
+                glDeleteTextures(1, &id);
+            }
+        }
+
+        StreamedTexture(const StreamedTexture&) = delete;
+        StreamedTexture& operator=(const StreamedTexture&) = delete;
+
+        void Bind(unsigned int slot = 0) const override {
+            glActiveTexture(GL_TEXTURE0 + slot);
+            glBindTexture(GL_TEXTURE_2D, GetID());
+        }
+
+        void Unbind() const override {
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        void SetFiltering(GLenum minFilter, GLenum magFilter) const override {
+            if (!IsReady()) return; // Placeholder filtering is shared; leave it alone
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        int GetWidth() const override { return width; }
+        int GetHeight() const override { return height; }
+        unsigned int GetID() const override { return IsReady() ? id : placeholder; }
+        std::filesystem::path GetPath() const override { return filepath; }
+        Format GetFormat() const override { return format; }
+
+        std::vector<unsigned char> GetData() const override {
+            std::vector<unsigned char> data(static_cast<size_t>(width) * height * 4);
+            if (!IsReady()) return data;
+
+            glBindTexture(GL_TEXTURE_2D, id);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return data;
+        }
+
+        bool IsReady() const { return ready.load(std::memory_order_acquire); }
+        bool HasFailed() const { return failed.load(std::memory_order_acquire); }
+
+    private:
+        friend class TextureStreamer;
+
+        const std::filesystem::path filepath;
+        GLuint placeholder = 0;
+        bool generateMipmaps = true;
+        GLuint id = 0;
+        int width = 0;
+        int height = 0;
+        Format format = Format::RGBA8;
+        std::atomic<bool> ready{ false };
+        std::atomic<bool> failed{ false };
+        memory::TrackedBytes gpuBytes{ memory::Tag::Gpu };
+    };
+
+    // Asynchronous texture loader. File I/O and decoding run on the job system; the GL thread calls
+    // Update() once per frame to move decoded pixels through a small pool of pixel-unpack buffers
+    // into textures, never uploading more than the per-frame byte budget.
+    class TextureStreamer {
+    public:
+        using Handle = std::shared_ptr<StreamedTexture>;
+
+        TextureStreamer(ThreadPool& jobSystem, size_t uploadBudgetBytes = 8 * 1024 * 1024, size_t pixelBufferCount = 4)
+            : jobSystem(jobSystem), uploadBudget(uploadBudgetBytes), state(std::make_shared<SharedState>()) {
+            CreatePlaceholder();
+            pixelBuffers.resize(std::max<size_t>(pixelBufferCount, 1));
+            for (auto& buffer : pixelBuffers) {
+                glGenBuffers(1, &buffer.pbo);
+            }
+        }
+
+        ~TextureStreamer() {
+            // Jobs still in flight only touch the shared state, which outlives this object
+            for (auto& buffer : pixelBuffers) {
+                if (buffer.fence) glDeleteSync(buffer.fence);
+                glDeleteBuffers(1, &buffer.pbo);
+            }
+            glDeleteTextures(1, &placeholderID);
+        }
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // Returns immediately. Repeated requests for the same path share one handle while it is alive.
+        Handle Request(const std::filesystem::path& filepath, bool generateMipmaps = true) {
+            ALMOND_MEMORY_TAG(Renderer);
+            const std::string key = filepath.string();
+            if (auto it = requested.find(key); it != requested.end()) {
+                if (auto existing = it->second.lock()) {
+                    return existing;
+                }
+            }
+
+            auto texture = std::make_shared<StreamedTexture>(filepath, placeholderID, generateMipmaps);
+            requested[key] = texture;
+
+            std::weak_ptr<StreamedTexture> target = texture;
+            std::shared_ptr<SharedState> shared = state;
+            ++inFlight;
+            jobSystem.enqueue([shared, target, filepath]() {
+                ALMOND_MEMORY_TAG(Renderer); // Workers keep their own current tag
+                Decoded decoded{ target, {}, std::nullopt, false };
+                try {
+                    if (CompressedImage::IsCompressedFile(filepath)) {
+                        // Block data is uploaded as stored; only the pages need warming
+                        decoded.compressed = CompressedImage::Load(filepath);
+                        decoded.ok = true;
+                        if (const MappedFile* file = decoded.compressed->GetMapping()) {
+                            file->Prefetch(0, file->size());
+                        }
+                    }
+                    else {
+                        decoded.image = ImageLoader::MapAlmondImage(filepath);
+                        ImageLoader::SetRowOrder(decoded.image, true);
+                        decoded.ok = decoded.image.pixels != nullptr;
+                        if (decoded.ok && decoded.image.IsMapped()) {
+                            // Fault the pages in here so the GL thread's copy never waits on disk
+                            const auto& file = *decoded.image.mapping;
+                            file.Prefetch(static_cast<size_t>(decoded.image.pixels - file.data()), decoded.image.SizeBytes());
+                        }
+                    }
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Failed to stream texture " << filepath << ": " << e.what() << "\n";
+                }
+
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->decoded.push_back(std::move(decoded));
+            });
+
+            return texture;
+        }
+
+        // GL thread, once per frame. Always makes progress on at least one texture, even if it alone
+        // exceeds the budget, so oversized images cannot stall the queue.
+        void Update() {
+            ALMOND_MEMORY_TAG(Renderer);
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                while (!state->decoded.empty()) {
+                    pending.push_back(std::move(state->decoded.front()));
+                    state->decoded.pop_front();
+                }
+            }
+
+            size_t uploaded = 0;
+            while (!pending.empty()) {
+                Decoded& next = pending.front();
+                auto texture = next.target.lock();
+                if (!texture || !next.ok) {
+                    if (texture) texture->failed.store(true, std::memory_order_release);
+                    pending.pop_front();
+                    --inFlight;
+                    continue;
+                }
+
+                const size_t bytes = next.compressed ? next.compressed->SizeBytes() : next.image.SizeBytes();
+                if (uploaded > 0 && uploaded + bytes > uploadBudget) {
+                    break; // Finish next frame
+                }
+
+                PixelBuffer* buffer = AcquirePixelBuffer();
+                if (!buffer) {
+                    break; // Every buffer is still being read by the GPU
+                }
+
+                if (next.compressed) {
+                    UploadCompressed(*texture, *next.compressed, *buffer);
+                }
+                else {
+                    Upload(*texture, next.image, *buffer);
+                }
+                uploaded += bytes;
+                metrics::Engine().uploadBytes.Add(bytes);
+                pending.pop_front();
+                --inFlight;
+            }
+
+            // Forget handles nobody holds anymore
+            if (requested.size() > 64 && requested.size() > 2 * lastPrunedSize) {
+                std::erase_if(requested, [](const auto& entry) { return entry.second.expired(); });
+                lastPrunedSize = requested.size();
+            }
+        }
+
+        // Number of requests that have not been uploaded (or failed) yet
+        size_t GetPendingCount() const { return inFlight; }
+        GLuint GetPlaceholder() const { return placeholderID; }
+        void SetUploadBudget(size_t bytes) { uploadBudget = bytes; }
+
+    private:
+        struct Decoded {
+            std::weak_ptr<StreamedTexture> target;
+            ImageLoader::ImageView image;
+            std::optional<CompressedImage> compressed; // Set instead of image for .dds / .ktx2
+            bool ok = false;
+        };
+
+        // Filled by jobs, drained by Update; shared so late jobs never touch a destroyed streamer
+        struct SharedState {
+            std::mutex mutex;
+            std::deque<Decoded> decoded;
+        };
+
+        struct PixelBuffer {
+            GLuint pbo = 0;
+            size_t capacity = 0;
+            GLsync fence = nullptr; // Signalled once the GPU has consumed the last upload
+        };
+
+        ThreadPool& jobSystem;
+        size_t uploadBudget;
+        std::shared_ptr<SharedState> state;
+        std::deque<Decoded> pending;
+        std::vector<PixelBuffer> pixelBuffers;
+        std::unordered_map<std::string, std::weak_ptr<StreamedTexture>> requested;
+        size_t lastPrunedSize = 0;
+        size_t inFlight = 0;
+        GLuint placeholderID = 0;
+
+        PixelBuffer* AcquirePixelBuffer() {
+            for (auto& buffer : pixelBuffers) {
+                if (!buffer.fence) return &buffer;
+
+                if (glClientWaitSync(buffer.fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+                    glDeleteSync(buffer.fence);
+                    buffer.fence = nullptr;
+                    return &buffer;
+                }
+            }
+            return nullptr;
+        }
+
+        void Upload(StreamedTexture& texture, const ImageLoader::ImageView& image, PixelBuffer& buffer) {
+            const size_t bytes = image.SizeBytes();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+            if (bytes > buffer.capacity) {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+                buffer.capacity = bytes;
+            }
+
+            void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (!mapped) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                std::cerr << "Failed to map pixel buffer for " << texture.filepath << "\n";
+                texture.failed.store(true, std::memory_order_release);
+                return;
+            }
+            std::memcpy(mapped, image.pixels, bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+            GLenum internalFormat = (image.channels == 4) ? GL_RGBA8 : GL_RGB8;
+            GLenum dataFormat = (image.channels == 4)
+                ? (image.order == ImageLoader::PixelOrder::BGRA ? GL_BGRA : GL_RGBA)
+                : GL_RGB;
+
+            glGenTextures(1, &texture.id);
+            glBindTexture(GL_TEXTURE_2D, texture.id);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(image.rowStride / image.channels));
+            // Sourced from the bound PBO, so this returns without waiting for the transfer
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, dataFormat, GL_UNSIGNED_BYTE, nullptr);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.generateMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            if (texture.generateMipmaps) {
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            texture.width = image.width;
+            texture.height = image.height;
+            texture.gpuBytes.Set(memory::TextureBytes(image.width, image.height, image.channels == 4 ? 4 : 3, texture.generateMipmaps));
+            texture.ready.store(true, std::memory_order_release);
+        }
+
+        // Levels are packed back to back in the PBO and uploaded from their buffer offsets
+        void UploadCompressed(StreamedTexture& texture, const CompressedImage& image, PixelBuffer& buffer) {
+            if (!IsCompressedFormatSupported(image.GetFormat())) {
+                std::cerr << "Compressed texture format is not supported by this GPU: " << texture.filepath << "\n";
+                texture.failed.store(true, std::memory_order_release);
+                return;
+            }
+
+            const size_t bytes = image.SizeBytes();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+            if (bytes > buffer.capacity) {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+                buffer.capacity = bytes;
+            }
+
+            auto* mapped = static_cast<std::uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+            if (!mapped) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                std::cerr << "Failed to map pixel buffer for " << texture.filepath << "\n";
+                texture.failed.store(true, std::memory_order_release);
+                return;
+            }
+            for (const auto& level : image.GetLevels()) {
+                std::memcpy(mapped, image.Data() + level.offset, level.size);
+                mapped += level.size;
+            }
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+            glGenTextures(1, &texture.id);
+            glBindTexture(GL_TEXTURE_2D, texture.id);
+            UploadCompressedLevels(image, true);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, image.GetLevels().size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            texture.width = image.GetWidth();
+            texture.height = image.GetHeight();
+            texture.format = GetTextureFormat(image.GetFormat());
+            texture.gpuBytes.Set(image.SizeBytes());
+            texture.ready.store(true, std::memory_order_release);
+        }
+
+        // 2x2 magenta/black checker so missing art is obvious but not blinding
+        void CreatePlaceholder() {
+            const uint8_t pixels[16] = {
+                255, 0, 255, 255,   0, 0, 0, 255,
+                0, 0, 0, 255,       255, 0, 255, 255,
+            };
+
+            glGenTextures(1, &placeholderID);
+            glBindTexture(GL_TEXTURE_2D, placeholderID);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    };
+
+} // namespace almond
+
+#endif
@@ -2,7 +2,10 @@
 
 #include "alsWaitFreeQueue.h"
 #include "alsExports_DLL.h"
+#include "alsMetrics.h"
+#include "alsProfiler.h"
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 #include <memory>     // Include for unique_ptr
@@ -13,22 +16,44 @@ namespace almond
 {
     class ThreadPool {
     public:
-        explicit ThreadPool(size_t threadCount);
+        explicit ThreadPool(size_t threadCount, size_t queueCapacity = 1024);
         ~ThreadPool();
 
         void enqueue(std::function<void()> job);
+        size_t size() const { return workers.size(); }
+
+        // Runs body(0) .. body(count - 1) across the workers and the calling thread, returning once
+        // every index has run. Indices are claimed from a shared counter, so the caller finishes the
+        // work itself if the workers are busy and this never deadlocks when called from a worker.
+        void parallelFor(size_t count, const std::function<void(size_t)>& body);
 
     private:
+        // One parallelFor in flight. Helper jobs hold it by pointer and the caller's body by reference:
+        // a helper only calls body for an index it claimed, and the caller waits for every claimed
+        // index, so only the counters are touched after parallelFor returns. Slots are recycled once
+        // the last helper has let go, so a steady stream of parallelFor calls allocates nothing.
+        struct Batch {
+            const std::function<void(size_t)>* body = nullptr;
+            size_t count = 0;
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> done{ 0 };
+            std::atomic<size_t> users{ 0 };  // Caller plus helper jobs that have not finished; 0 when free
+        };
+        static constexpr size_t kMaxBatches = 64; // Nested or concurrent parallelFor calls beyond this run serially
+
         int workerThread(); // Worker function for threads
+        Batch* acquireBatch(size_t users);
+        static size_t runBatch(Batch& batch);
 
+        std::unique_ptr<Batch[]> batches = std::make_unique<Batch[]>(kMaxBatches);
         std::vector<std::thread> workers; // Worker threads
         std::unique_ptr<WaitFreeQueue<std::function<void()>>> jobQueue; // Job queue
         std::unique_ptr<std::atomic<bool>> isRunning; // Running status
     };
 
     // ThreadPool constructor, destructor, and methods are defined inline in this header file.
-    inline ThreadPool::ThreadPool(size_t threadCount)
-        : jobQueue(std::make_unique<WaitFreeQueue<std::function<void()>>>(threadCount)),
+    inline ThreadPool::ThreadPool(size_t threadCount, size_t queueCapacity)
+        : jobQueue(std::make_unique<WaitFreeQueue<std::function<void()>>>(queueCapacity)),
         isRunning(std::make_unique<std::atomic<bool>>(true)) {
         for (size_t i = 0; i < threadCount; ++i) {
             workers.emplace_back(&ThreadPool::workerThread, this);
@@ -43,15 +68,74 @@ namespace almond
     }
 
     inline void ThreadPool::enqueue(std::function<void()> job) {
-        jobQueue->enqueue(std::move(job)); // Enqueue the job
+        // If the queue is full, run the job on the caller rather than dropping it. Waiting instead
+        // could deadlock when every worker is itself blocked enqueueing follow-up jobs.
+        if (!jobQueue->enqueue(std::move(job))) {
+            metrics::Engine().jobsRunInline.Add();
+            if (job) job();
+        }
+    }
+
+    inline void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+        if (count == 0) return;
+        ALMOND_PROFILE_SCOPE("parallelFor");
+        const size_t helpers = (std::min)(count - 1, workers.size());
+        Batch* batch = (count == 1 || workers.empty()) ? nullptr : acquireBatch(helpers + 1);
+        if (!batch) {
+            for (size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+        batch->body = &body;
+        batch->count = count;
+        batch->next.store(0, std::memory_order_relaxed);
+        batch->done.store(0, std::memory_order_relaxed);
+
+        // The job captures only the batch pointer, so std::function stores it inline rather than on the heap
+        for (size_t i = 0; i < helpers; ++i) {
+            enqueue([batch] {
+                runBatch(*batch);
+                batch->users.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        metrics::Engine().jobsCallerClaimed.Add(runBatch(*batch));
+
+        while (batch->done.load(std::memory_order_acquire) < count) {
+            std::this_thread::yield();
+        }
+        batch->users.fetch_sub(1, std::memory_order_release);
+    }
+
+    inline ThreadPool::Batch* ThreadPool::acquireBatch(size_t users) {
+        for (size_t i = 0; i < kMaxBatches; ++i) {
+            size_t expected = 0;
+            if (batches[i].users.compare_exchange_strong(expected, users, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return &batches[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Claims and runs indices until none are left; returns how many this thread ran
+    inline size_t ThreadPool::runBatch(Batch& batch) {
+        size_t i;
+        size_t claimed = 0;
+        while ((i = batch.next.fetch_add(1, std::memory_order_relaxed)) < batch.count) {
+            (*batch.body)(i);
+            batch.done.fetch_add(1, std::memory_order_release);
+            ++claimed;
+        }
+        return claimed;
     }
 
     inline int ThreadPool::workerThread() {
+        ALMOND_PROFILE_THREAD("Worker");
         while (*isRunning) {
             std::function<void()> job;
             if (jobQueue->dequeue(job)) {  // Non-blocking dequeue
                 if (job) {
+                    ALMOND_PROFILE_SCOPE("Job");
                     job();  // Execute the job
+                    metrics::Engine().jobsExecuted.Add();
                 }
             }
             else {
@@ -1,76 +1,113 @@
 #pragma once
 
 #include <atomic>
-#include <vector>
+#include <memory>
 #include <optional>
-#include <iostream>
+#include <stdexcept>
 
 namespace almond {
 
+// Bounded multi-producer / multi-consumer queue. Each slot carries a sequence number that tells
+// producers and consumers whether it is free for the current lap, so no locks are taken and a
+// full or empty queue is reported immediately instead of blocking.
 template<typename T>
 class WaitFreeQueue {
 public:
     explicit WaitFreeQueue(size_t capacity);
 
-    bool enqueue(const T& item); // Add an item to the queue
-    bool dequeue(T& item);       // Remove an item from the queue
+    bool enqueue(const T& item); // Add an item to the queue; false if full
+    bool enqueue(T&& item);
+    bool dequeue(T& item);       // Remove an item from the queue; false if empty
     bool isEmpty() const;        // Check if the queue is empty
+    size_t capacity() const { return slotCount; }
 
 private:
-    std::vector<std::optional<T>> buffer;  // Buffer for queue items
-    alignas(64) std::atomic<size_t> tail;  // Tail index
-    alignas(64) std::atomic<size_t> head;  // Head index
+    struct Slot {
+        std::atomic<size_t> sequence;
+        std::optional<T> value;
+    };
+
+    template<typename U>
+    bool emplace(U&& item);
+
+    size_t slotCount;
+    std::unique_ptr<Slot[]> buffer;        // Buffer for queue items
+    alignas(64) std::atomic<size_t> tail;  // Next position to write
+    alignas(64) std::atomic<size_t> head;  // Next position to read
 };
 
 template<typename T>
 WaitFreeQueue<T>::WaitFreeQueue(size_t capacity)
-    : buffer(capacity), head(0), tail(0) {
+    : slotCount(capacity), tail(0), head(0) {
     if (capacity == 0) {
         throw std::invalid_argument("Capacity must be greater than zero.");
     }
+
+    buffer = std::make_unique<Slot[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        buffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
 }
 
 template<typename T>
 bool WaitFreeQueue<T>::enqueue(const T& item) {
-    size_t currentTail = tail.load(std::memory_order_acquire);  // Ensure proper synchronization on load
-    size_t nextTail = (currentTail + 1) % buffer.size();        // Calculate next tail position
-
-    // Check if the queue is full
-    if (nextTail == head.load(std::memory_order_acquire)) {
-        std::cerr << "Queue is full!" << std::endl;
-        return false; // Queue full
-    }
-
-    buffer[currentTail] = item;                                 // Enqueue the item
-    tail.store(nextTail, std::memory_order_release);            // Update tail with memory barrier
-    return true;
+    return emplace(item);
 }
 
 template<typename T>
-bool WaitFreeQueue<T>::dequeue(T& item) {
-    size_t currentHead = head.load(std::memory_order_relaxed); // Load head index
+bool WaitFreeQueue<T>::enqueue(T&& item) {
+    return emplace(std::move(item));
+}
 
-    // Check if the queue is empty
-    if (currentHead == tail.load(std::memory_order_acquire)) {
-        //std::cerr << "Queue is empty!" << std::endl;
-        return false; // Queue empty
+template<typename T>
+template<typename U>
+bool WaitFreeQueue<T>::emplace(U&& item) {
+    size_t position = tail.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = buffer[position % slotCount];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if (diff == 0) {
+            // Slot is free for this lap; claim it
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.value.emplace(std::forward<U>(item));
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            return false; // Queue full
+        }
+        else {
+            position = tail.load(std::memory_order_relaxed); // Another producer got here first
+        }
     }
+}
 
-    // Check if there's a value to dequeue
-    if (buffer[currentHead].has_value()) {
-        // Move the item from the buffer
-        item = std::move(*buffer[currentHead]);
-
-        // Clear the value in the buffer
-        buffer[currentHead].reset();
-
-        // Update head and ensure proper memory visibility
-        head.store((currentHead + 1) % buffer.size(), std::memory_order_release);
-        return true; // Successfully dequeued
+template<typename T>
+bool WaitFreeQueue<T>::dequeue(T& item) {
+    size_t position = head.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = buffer[position % slotCount];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+        if (diff == 0) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                item = std::move(*slot.value);
+                slot.value.reset();
+                slot.sequence.store(position + slotCount, std::memory_order_release); // Free for the next lap
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            return false; // Queue empty
+        }
+        else {
+            position = head.load(std::memory_order_relaxed);
+        }
     }
-
-    std::cerr << "No valid item to dequeue at current head!" << std::endl;
-    return false; // No valid item to dequeue
 }
 
 template<typename T>
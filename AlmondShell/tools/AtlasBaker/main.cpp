@@ -0,0 +1,298 @@
+// AtlasBaker: packs a directory of images into atlas pages plus a binary manifest (see alsBakedAtlas.h).
+//
+// usage: AtlasBaker <input directory> <output.alat> [--size N] [--padding N] [--mip-levels N] [--compress] [--no-trim]
+//
+// Sprite edges are extruded into the padding so filtering never pulls in a neighbour. With
+// --mip-levels N, sprites are also aligned to 2^(N-1) texels with at least that much gutter, so the
+// first N mip levels of each page stay bleed-free.
+
+#include "alsBakedAtlas.h"
+#include "alsImageLoader.h"
+#include "alsTextureAtlasPacker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct SourceImage {
+        std::string name;
+        almond::ImageLoader::ImageData image;
+        int trimX = 0, trimY = 0, trimWidth = 0, trimHeight = 0;
+    };
+
+    struct Options {
+        std::filesystem::path input;
+        std::filesystem::path output;
+        int pageSize = 4096;
+        int padding = 2;
+        int mipLevels = 1;
+        bool compress = false;
+        bool trim = true;
+    };
+
+    void PrintUsage() {
+        std::cerr << "usage: AtlasBaker <input directory> <output.alat> [--size N] [--padding N] [--mip-levels N] [--compress] [--no-trim]\n";
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options) {
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--size" && i + 1 < argc) {
+                options.pageSize = std::stoi(argv[++i]);
+            }
+            else if (arg == "--padding" && i + 1 < argc) {
+                options.padding = std::stoi(argv[++i]);
+            }
+            else if (arg == "--mip-levels" && i + 1 < argc) {
+                options.mipLevels = std::stoi(argv[++i]);
+            }
+            else if (arg == "--compress") {
+                options.compress = true;
+            }
+            else if (arg == "--no-trim") {
+                options.trim = false;
+            }
+            else if (arg.rfind("--", 0) == 0) {
+                std::cerr << "Unknown option: " << arg << "\n";
+                return false;
+            }
+            else {
+                positional.push_back(arg);
+            }
+        }
+
+        if (positional.size() != 2 || options.pageSize <= 0 || options.padding < 0 || options.mipLevels < 1 || options.mipLevels > 16) {
+            return false;
+        }
+        options.input = positional[0];
+        options.output = positional[1];
+        return true;
+    }
+
+    // Shrinks the rect to the smallest one containing every pixel with non-zero alpha
+    void TrimTransparentBorder(SourceImage& source) {
+        const auto& image = source.image;
+        source.trimX = 0;
+        source.trimY = 0;
+        source.trimWidth = image.width;
+        source.trimHeight = image.height;
+        if (image.channels != 4) return;
+
+        int minX = image.width, minY = image.height, maxX = -1, maxY = -1;
+        for (int y = 0; y < image.height; ++y) {
+            const uint8_t* row = &image.pixels[static_cast<size_t>(y) * image.width * 4];
+            for (int x = 0; x < image.width; ++x) {
+                if (row[x * 4 + 3] != 0) {
+                    minX = std::min(minX, x);
+                    maxX = std::max(maxX, x);
+                    minY = std::min(minY, y);
+                    maxY = std::max(maxY, y);
+                }
+            }
+        }
+
+        if (maxX < 0) {
+            // Fully transparent: keep a single texel so the sprite still has a valid rect
+            source.trimWidth = 1;
+            source.trimHeight = 1;
+            return;
+        }
+
+        source.trimX = minX;
+        source.trimY = minY;
+        source.trimWidth = maxX - minX + 1;
+        source.trimHeight = maxY - minY + 1;
+    }
+
+    std::vector<SourceImage> LoadSources(const Options& options) {
+        std::vector<SourceImage> sources;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(options.input)) {
+            if (!entry.is_regular_file()) continue;
+
+            auto extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (extension != ".bmp" && extension != ".png") continue;
+
+            SourceImage source;
+            try {
+                source.image = almond::ImageLoader::LoadAlmondImage(entry.path());
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Skipping " << entry.path() << ": " << e.what() << "\n";
+                continue;
+            }
+
+            // Sprite names are the path relative to the input directory, without extension
+            auto relative = std::filesystem::relative(entry.path(), options.input);
+            source.name = relative.replace_extension().generic_string();
+
+            if (options.trim) {
+                TrimTransparentBorder(source);
+            }
+            else {
+                source.trimWidth = source.image.width;
+                source.trimHeight = source.image.height;
+            }
+            sources.push_back(std::move(source));
+        }
+        return sources;
+    }
+
+    void Blit(almond::BakedAtlasPage& page, const SourceImage& source, int dstX, int dstY) {
+        const auto& image = source.image;
+        for (int y = 0; y < source.trimHeight; ++y) {
+            const uint8_t* src = &image.pixels[(static_cast<size_t>(source.trimY + y) * image.width + source.trimX) * image.channels];
+            uint8_t* dst = &page.pixels[(static_cast<size_t>(dstY + y) * page.width + dstX) * 4];
+            if (image.channels == 4) {
+                std::memcpy(dst, src, static_cast<size_t>(source.trimWidth) * 4);
+            }
+            else {
+                for (int x = 0; x < source.trimWidth; ++x) {
+                    dst[x * 4 + 0] = src[x * image.channels + 0];
+                    dst[x * 4 + 1] = src[x * image.channels + 1];
+                    dst[x * 4 + 2] = src[x * image.channels + 2];
+                    dst[x * 4 + 3] = 255;
+                }
+            }
+        }
+    }
+
+    int RoundUp(int value, int multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    // Repeats the sprite's border texels outwards until they fill its allocation
+    void Extrude(almond::BakedAtlasPage& page, const almond::AtlasRect& allocation, int x, int y, int width, int height) {
+        auto texel = [&](int tx, int ty) { return &page.pixels[(static_cast<size_t>(ty) * page.width + tx) * 4]; };
+        const int right = allocation.x + allocation.width;
+        const int bottom = allocation.y + allocation.height;
+
+        for (int ty = y; ty < y + height; ++ty) {
+            for (int tx = allocation.x; tx < x; ++tx) std::memcpy(texel(tx, ty), texel(x, ty), 4);
+            for (int tx = x + width; tx < right; ++tx) std::memcpy(texel(tx, ty), texel(x + width - 1, ty), 4);
+        }
+
+        const size_t rowBytes = static_cast<size_t>(allocation.width) * 4;
+        for (int ty = allocation.y; ty < y; ++ty) std::memcpy(texel(allocation.x, ty), texel(allocation.x, y), rowBytes);
+        for (int ty = y + height; ty < bottom; ++ty) std::memcpy(texel(allocation.x, ty), texel(allocation.x, y + height - 1), rowBytes);
+    }
+
+    almond::BakedAtlasPage MakePage(int size) {
+        almond::BakedAtlasPage page;
+        page.width = size;
+        page.height = size;
+        page.channels = 4;
+        page.pixels.assign(static_cast<size_t>(size) * size * 4, 0);
+        return page;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        auto sources = LoadSources(options);
+        if (sources.empty()) {
+            std::cerr << "No images found in " << options.input << "\n";
+            return 1;
+        }
+
+        // Largest first packs noticeably tighter; ties broken by name so output is deterministic
+        std::sort(sources.begin(), sources.end(), [](const SourceImage& a, const SourceImage& b) {
+            int sideA = std::max(a.trimWidth, a.trimHeight);
+            int sideB = std::max(b.trimWidth, b.trimHeight);
+            return sideA != sideB ? sideA > sideB : a.name < b.name;
+        });
+
+        // Sprite rects (and so every free-rect edge) are multiples of the alignment, which keeps
+        // each sprite on a texel boundary at every requested mip level
+        const int alignment = 1 << (options.mipLevels - 1);
+        const int gutter = RoundUp(std::max(options.padding, options.mipLevels > 1 ? alignment : 0), alignment);
+        if (options.pageSize % alignment != 0) {
+            std::cerr << "Page size must be a multiple of " << alignment << " for " << options.mipLevels << " mip levels.\n";
+            return 1;
+        }
+
+        // Pack every sprite first so each page's pixels are written once
+        struct Placement { size_t page; almond::AtlasRect rect; };
+        std::vector<almond::AtlasAllocator> allocators;
+        std::vector<Placement> placements;
+        placements.reserve(sources.size());
+
+        for (const auto& source : sources) {
+            int paddedWidth = RoundUp(source.trimWidth + gutter * 2, alignment);
+            int paddedHeight = RoundUp(source.trimHeight + gutter * 2, alignment);
+            if (paddedWidth > options.pageSize || paddedHeight > options.pageSize) {
+                std::cerr << "Image " << source.name << " does not fit in a " << options.pageSize << " page.\n";
+                return 1;
+            }
+
+            Placement placement{};
+            bool placed = false;
+            for (size_t i = 0; i < allocators.size() && !placed; ++i) {
+                placement = { i, allocators[i].Insert(paddedWidth, paddedHeight) };
+                placed = placement.rect.IsValid();
+            }
+            if (!placed) {
+                allocators.emplace_back(options.pageSize, options.pageSize);
+                placement = { allocators.size() - 1, allocators.back().Insert(paddedWidth, paddedHeight) };
+            }
+            placements.push_back(placement);
+        }
+
+        std::vector<almond::BakedAtlasPage> pages;
+        for (size_t i = 0; i < allocators.size(); ++i) {
+            pages.push_back(MakePage(options.pageSize));
+        }
+
+        std::vector<almond::BakedSprite> sprites(sources.size());
+        for (size_t i = 0; i < sources.size(); ++i) {
+            const auto& source = sources[i];
+            const auto& [page, rect] = placements[i];
+            int x = rect.x + gutter;
+            int y = rect.y + gutter;
+            Blit(pages[page], source, x, y);
+            Extrude(pages[page], rect, x, y, source.trimWidth, source.trimHeight);
+
+            auto& sprite = sprites[i];
+            sprite.page = static_cast<std::uint16_t>(page);
+            sprite.x = x;
+            sprite.y = y;
+            sprite.width = source.trimWidth;
+            sprite.height = source.trimHeight;
+            sprite.trimX = source.trimX;
+            sprite.trimY = source.trimY;
+            sprite.sourceWidth = source.image.width;
+            sprite.sourceHeight = source.image.height;
+        }
+
+        const size_t pageCount = pages.size();
+        almond::BakedAtlas atlas;
+        atlas.SetMipLevels(options.mipLevels);
+        for (auto& page : pages) {
+            atlas.AddPage(std::move(page));
+        }
+        for (size_t i = 0; i < sources.size(); ++i) {
+            atlas.AddSprite(sources[i].name, sprites[i]);
+        }
+
+        atlas.Save(options.output, options.compress);
+        std::cout << "Baked " << sources.size() << " sprites into " << pageCount << " page(s): " << options.output << "\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << "AtlasBaker failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,384 @@
+#include "BlockEncoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace almond {
+namespace bc {
+
+    namespace {
+        // Principal axis of the selected texels over the first N channels, by power iteration on
+        // the covariance matrix. Returns false if every selected texel is identical.
+        template <int N>
+        bool PrincipalAxis(const std::uint8_t* rgba, const bool* include, std::array<float, N>& mean, std::array<float, N>& axis) {
+            int count = 0;
+            mean.fill(0.0f);
+            for (int i = 0; i < 16; ++i) {
+                if (!include[i]) continue;
+                for (int c = 0; c < N; ++c) mean[c] += rgba[i * 4 + c];
+                ++count;
+            }
+            if (count == 0) return false;
+            for (auto& m : mean) m /= count;
+
+            float cov[N][N] = {};
+            for (int i = 0; i < 16; ++i) {
+                if (!include[i]) continue;
+                float d[N];
+                for (int c = 0; c < N; ++c) d[c] = rgba[i * 4 + c] - mean[c];
+                for (int a = 0; a < N; ++a)
+                    for (int b = 0; b < N; ++b) cov[a][b] += d[a] * d[b];
+            }
+
+            axis.fill(1.0f);
+            for (int iteration = 0; iteration < 8; ++iteration) {
+                std::array<float, N> next{};
+                for (int a = 0; a < N; ++a)
+                    for (int b = 0; b < N; ++b) next[a] += cov[a][b] * axis[b];
+                float length = 0.0f;
+                for (float v : next) length += v * v;
+                if (length < 1e-12f) return false;
+                length = std::sqrt(length);
+                for (int c = 0; c < N; ++c) axis[c] = next[c] / length;
+            }
+            return true;
+        }
+
+        // Endpoints at the extreme projections onto the principal axis
+        template <int N>
+        void AxisEndpoints(const std::uint8_t* rgba, const bool* include, float lo[N], float hi[N]) {
+            std::array<float, N> mean, axis;
+            if (!PrincipalAxis<N>(rgba, include, mean, axis)) {
+                for (int c = 0; c < N; ++c) lo[c] = hi[c] = mean[c];
+                return;
+            }
+
+            float minT = std::numeric_limits<float>::max(), maxT = -minT;
+            for (int i = 0; i < 16; ++i) {
+                if (!include[i]) continue;
+                float t = 0.0f;
+                for (int c = 0; c < N; ++c) t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+                minT = std::min(minT, t);
+                maxT = std::max(maxT, t);
+            }
+            for (int c = 0; c < N; ++c) {
+                lo[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+                hi[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+            }
+        }
+
+        std::uint16_t To565(const float c[3]) {
+            int r = static_cast<int>(std::lround(c[0] * 31.0f / 255.0f));
+            int g = static_cast<int>(std::lround(c[1] * 63.0f / 255.0f));
+            int b = static_cast<int>(std::lround(c[2] * 31.0f / 255.0f));
+            return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void From565(std::uint16_t v, int out[3]) {
+            int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+            out[0] = (r << 3) | (r >> 2);
+            out[1] = (g << 2) | (g >> 4);
+            out[2] = (b << 3) | (b >> 2);
+        }
+
+        // Colour palette the decoder builds from two 565 endpoints
+        void BC1Palette(std::uint16_t c0, std::uint16_t c1, bool fourColor, int palette[4][3]) {
+            From565(c0, palette[0]);
+            From565(c1, palette[1]);
+            for (int c = 0; c < 3; ++c) {
+                if (fourColor) {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                else {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+        }
+
+        // Picks the nearest palette entry per texel; transparent texels take index 3
+        std::uint32_t BC1Indices(const std::uint8_t* rgba, const bool* opaque, const int palette[4][3], int usable, std::uint8_t indices[16], int& error) {
+            error = 0;
+            std::uint32_t bits = 0;
+            for (int i = 0; i < 16; ++i) {
+                int best = 3, bestError = std::numeric_limits<int>::max();
+                if (opaque[i]) {
+                    for (int p = 0; p < usable; ++p) {
+                        int e = 0;
+                        for (int c = 0; c < 3; ++c) {
+                            int d = rgba[i * 4 + c] - palette[p][c];
+                            e += d * d;
+                        }
+                        if (e < bestError) { bestError = e; best = p; }
+                    }
+                    error += bestError;
+                }
+                indices[i] = static_cast<std::uint8_t>(best);
+                bits |= static_cast<std::uint32_t>(best) << (i * 2);
+            }
+            return bits;
+        }
+
+        // Least-squares endpoints for fixed indices (four-colour weights)
+        bool RefineBC1(const std::uint8_t* rgba, const std::uint8_t indices[16], float lo[3], float hi[3]) {
+            static constexpr float kWeight[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f }; // Weight of endpoint 0
+            float aa = 0, bb = 0, ab = 0;
+            float ax[3] = {}, bx[3] = {};
+            for (int i = 0; i < 16; ++i) {
+                float a = kWeight[indices[i]], b = 1.0f - a;
+                aa += a * a; bb += b * b; ab += a * b;
+                for (int c = 0; c < 3; ++c) {
+                    ax[c] += a * rgba[i * 4 + c];
+                    bx[c] += b * rgba[i * 4 + c];
+                }
+            }
+            float det = aa * bb - ab * ab;
+            if (std::fabs(det) < 1e-6f) return false;
+            for (int c = 0; c < 3; ++c) {
+                hi[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+                lo[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        void WriteBC1(std::uint8_t* out, std::uint16_t c0, std::uint16_t c1, std::uint32_t bits) {
+            std::memcpy(out, &c0, 2);
+            std::memcpy(out + 2, &c1, 2);
+            std::memcpy(out + 4, &bits, 4);
+        }
+
+        // BC4-style alpha block: max/min endpoints with six interpolated values between them
+        void EncodeAlpha(const std::uint8_t* rgba, std::uint8_t* out) {
+            int lo = 255, hi = 0;
+            for (int i = 0; i < 16; ++i) {
+                lo = std::min<int>(lo, rgba[i * 4 + 3]);
+                hi = std::max<int>(hi, rgba[i * 4 + 3]);
+            }
+            out[0] = static_cast<std::uint8_t>(hi);
+            out[1] = static_cast<std::uint8_t>(lo);
+
+            int palette[8] = { hi, lo };
+            for (int k = 1; k < 7; ++k) palette[k + 1] = ((7 - k) * hi + k * lo) / 7;
+
+            std::uint64_t bits = 0;
+            if (hi != lo) {
+                for (int i = 0; i < 16; ++i) {
+                    int best = 0, bestError = 256;
+                    for (int p = 0; p < 8; ++p) {
+                        int e = std::abs(rgba[i * 4 + 3] - palette[p]);
+                        if (e < bestError) { bestError = e; best = p; }
+                    }
+                    bits |= static_cast<std::uint64_t>(best) << (i * 3);
+                }
+            }
+            for (int b = 0; b < 6; ++b) out[2 + b] = static_cast<std::uint8_t>(bits >> (b * 8));
+        }
+
+        // Appends value's low `count` bits to a 128-bit little-endian block
+        struct BitWriter {
+            std::uint8_t* out;
+            int position = 0;
+
+            void Put(std::uint32_t value, int count) {
+                for (int i = 0; i < count; ++i, ++position) {
+                    if (value & (1u << i)) out[position >> 3] |= static_cast<std::uint8_t>(1u << (position & 7));
+                }
+            }
+        };
+    }
+
+    void EncodeBC1(const std::uint8_t* rgba, std::uint8_t* out, bool allowTransparent) {
+        bool opaque[16];
+        bool anyTransparent = false;
+        for (int i = 0; i < 16; ++i) {
+            opaque[i] = !allowTransparent || rgba[i * 4 + 3] >= 128;
+            anyTransparent |= !opaque[i];
+        }
+        if (anyTransparent && std::none_of(opaque, opaque + 16, [](bool o) { return o; })) {
+            WriteBC1(out, 0, 0, 0xFFFFFFFFu); // Three-colour mode, every texel transparent
+            return;
+        }
+
+        float lo[3], hi[3];
+        AxisEndpoints<3>(rgba, opaque, lo, hi);
+
+        std::uint16_t bestC0 = 0, bestC1 = 0;
+        std::uint32_t bestBits = 0;
+        int bestError = std::numeric_limits<int>::max();
+        std::uint8_t indices[16];
+
+        // Endpoint ordering selects the mode: c0 > c1 is four-colour, otherwise three-colour + transparent
+        auto tryEndpoints = [&](const float* a, const float* b) {
+            std::uint16_t c0 = To565(a), c1 = To565(b);
+            if (anyTransparent ? c0 > c1 : c0 < c1) std::swap(c0, c1);
+            const bool fourColor = c0 > c1;
+            int palette[4][3];
+            BC1Palette(c0, c1, fourColor, palette);
+            int error;
+            std::uint32_t bits = BC1Indices(rgba, opaque, palette, fourColor ? 4 : 3, indices, error);
+            if (error < bestError) {
+                bestError = error;
+                bestC0 = c0;
+                bestC1 = c1;
+                bestBits = bits;
+            }
+            return fourColor;
+        };
+
+        // One least-squares pass over the first fit's indices (left in `indices`) usually helps
+        const bool fourColor = tryEndpoints(hi, lo);
+        if (fourColor && bestError > 0) {
+            float refinedLo[3], refinedHi[3];
+            if (RefineBC1(rgba, indices, refinedLo, refinedHi)) {
+                tryEndpoints(refinedHi, refinedLo);
+            }
+        }
+
+        WriteBC1(out, bestC0, bestC1, bestBits);
+    }
+
+    void EncodeBC3(const std::uint8_t* rgba, std::uint8_t* out) {
+        EncodeAlpha(rgba, out);
+        EncodeBC1(rgba, out + 8, false);
+    }
+
+    void EncodeBC7(const std::uint8_t* rgba, std::uint8_t* out) {
+        static constexpr int kWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        bool all[16];
+        std::fill(all, all + 16, true);
+        float lo[4], hi[4];
+        AxisEndpoints<4>(rgba, all, lo, hi);
+
+        int bestError = std::numeric_limits<int>::max();
+        int bestEndpoints[2][4] = {};
+        int bestP[2] = {};
+        std::uint8_t bestIndices[16] = {};
+
+        // Each endpoint is 7 bits per channel plus a p-bit shared by its four channels; try all four
+        // p-bit combinations and keep the best
+        auto evaluate = [&](const float* lo, const float* hi) {
+            for (int p0 = 0; p0 < 2; ++p0) {
+                for (int p1 = 0; p1 < 2; ++p1) {
+                    int endpoints[2][4];
+                    int expanded[2][4];
+                    for (int c = 0; c < 4; ++c) {
+                        endpoints[0][c] = std::clamp(static_cast<int>(std::lround((lo[c] - p0) / 2.0f)), 0, 127);
+                        endpoints[1][c] = std::clamp(static_cast<int>(std::lround((hi[c] - p1) / 2.0f)), 0, 127);
+                        expanded[0][c] = (endpoints[0][c] << 1) | p0;
+                        expanded[1][c] = (endpoints[1][c] << 1) | p1;
+                    }
+
+                    int palette[16][4];
+                    for (int k = 0; k < 16; ++k)
+                        for (int c = 0; c < 4; ++c)
+                            palette[k][c] = ((64 - kWeights[k]) * expanded[0][c] + kWeights[k] * expanded[1][c] + 32) >> 6;
+
+                    int error = 0;
+                    std::uint8_t indices[16];
+                    for (int i = 0; i < 16 && error < bestError; ++i) {
+                        int best = 0, bestTexel = std::numeric_limits<int>::max();
+                        for (int k = 0; k < 16; ++k) {
+                            int e = 0;
+                            for (int c = 0; c < 4; ++c) {
+                                int d = rgba[i * 4 + c] - palette[k][c];
+                                e += d * d;
+                            }
+                            if (e < bestTexel) { bestTexel = e; best = k; }
+                        }
+                        indices[i] = static_cast<std::uint8_t>(best);
+                        error += bestTexel;
+                    }
+
+                    if (error < bestError) {
+                        bestError = error;
+                        std::memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+                        bestP[0] = p0;
+                        bestP[1] = p1;
+                        std::memcpy(bestIndices, indices, sizeof(indices));
+                    }
+                }
+            }
+        };
+
+        evaluate(lo, hi);
+
+        // Least-squares endpoints for the chosen indices, re-quantized; two passes settle it
+        for (int pass = 0; pass < 2 && bestError > 0; ++pass) {
+            float aa = 0, bb = 0, ab = 0;
+            float ax[4] = {}, bx[4] = {};
+            for (int i = 0; i < 16; ++i) {
+                float b = kWeights[bestIndices[i]] / 64.0f, a = 1.0f - b;
+                aa += a * a; bb += b * b; ab += a * b;
+                for (int c = 0; c < 4; ++c) {
+                    ax[c] += a * rgba[i * 4 + c];
+                    bx[c] += b * rgba[i * 4 + c];
+                }
+            }
+            float det = aa * bb - ab * ab;
+            if (std::fabs(det) < 1e-6f) break;
+            for (int c = 0; c < 4; ++c) {
+                lo[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+                hi[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+            }
+            evaluate(lo, hi);
+        }
+
+        // The first index is stored with an implicit zero top bit; swap endpoints to make that true
+        if (bestIndices[0] & 8) {
+            for (int c = 0; c < 4; ++c) std::swap(bestEndpoints[0][c], bestEndpoints[1][c]);
+            std::swap(bestP[0], bestP[1]);
+            for (auto& index : bestIndices) index = static_cast<std::uint8_t>(15 - index);
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter writer{ out };
+        writer.Put(1u << 6, 7); // Mode 6
+        for (int c = 0; c < 4; ++c) {
+            writer.Put(static_cast<std::uint32_t>(bestEndpoints[0][c]), 7);
+            writer.Put(static_cast<std::uint32_t>(bestEndpoints[1][c]), 7);
+        }
+        writer.Put(static_cast<std::uint32_t>(bestP[0]), 1);
+        writer.Put(static_cast<std::uint32_t>(bestP[1]), 1);
+        writer.Put(bestIndices[0], 3);
+        for (int i = 1; i < 16; ++i) writer.Put(bestIndices[i], 4);
+    }
+
+    std::vector<std::uint8_t> CompressLevel(CompressedFormat format, const std::uint8_t* rgba, int width, int height) {
+        if (format != CompressedFormat::BC1 && format != CompressedFormat::BC3 && format != CompressedFormat::BC7) {
+            throw std::runtime_error("The encoder only produces BC1, BC3 and BC7.");
+        }
+
+        const int blockBytes = CompressedImage::BlockBytes(format);
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        std::vector<std::uint8_t> out(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+        std::uint8_t block[64];
+        for (int by = 0; by < blocksY; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                for (int y = 0; y < 4; ++y) {
+                    const int sy = std::min(by * 4 + y, height - 1);
+                    for (int x = 0; x < 4; ++x) {
+                        const int sx = std::min(bx * 4 + x, width - 1);
+                        std::memcpy(&block[(y * 4 + x) * 4], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+                    }
+                }
+
+                std::uint8_t* dst = &out[(static_cast<size_t>(by) * blocksX + bx) * blockBytes];
+                switch (format) {
+                case CompressedFormat::BC1: EncodeBC1(block, dst); break;
+                case CompressedFormat::BC3: EncodeBC3(block, dst); break;
+                default: EncodeBC7(block, dst); break;
+                }
+            }
+        }
+        return out;
+    }
+
+} // namespace bc
+} // namespace almond
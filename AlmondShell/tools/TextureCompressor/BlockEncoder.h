@@ -0,0 +1,27 @@
+#pragma once
+
+#include "alsCompressedImage.h"
+
+#include <cstdint>
+#include <vector>
+
+// CPU block encoders for the TextureCompressor tool. Each takes one 4x4 block of RGBA8 texels in
+// row-major order (64 bytes) and writes one compressed block.
+namespace almond {
+namespace bc {
+
+    // BC1 (DXT1). Texels with alpha below 128 use the punch-through mode when allowTransparent.
+    void EncodeBC1(const std::uint8_t* rgba, std::uint8_t* out, bool allowTransparent = true);
+
+    // BC3 (DXT5): BC1 colour plus an interpolated 8-bit alpha block
+    void EncodeBC3(const std::uint8_t* rgba, std::uint8_t* out);
+
+    // BC7 using mode 6 only (one subset, RGBA with 4-bit indices), which is most of BC7's quality
+    // on sprite art for a small fraction of a full mode search
+    void EncodeBC7(const std::uint8_t* rgba, std::uint8_t* out);
+
+    // Encodes a whole RGBA8 image level; edge blocks repeat the last row and column
+    std::vector<std::uint8_t> CompressLevel(CompressedFormat format, const std::uint8_t* rgba, int width, int height);
+
+} // namespace bc
+} // namespace almond
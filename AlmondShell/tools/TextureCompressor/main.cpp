@@ -0,0 +1,138 @@
+// TextureCompressor: encodes an image into a BC1/BC3/BC7 mip chain in a DDS or KTX2 container
+// (see alsCompressedImage.h).
+//
+// usage: TextureCompressor <input image> <output.dds|output.ktx2> [--format auto|bc1|bc3|bc7] [--no-mips] [--no-flip]
+//
+// Rows are flipped bottom-up by default, matching how OpenGLTexture uploads uncompressed images,
+// since block data cannot be flipped at load time.
+
+#include "BlockEncoder.h"
+#include "alsCompressedImage.h"
+#include "alsImageLoader.h"
+#include "alsPixelKernels.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Options {
+        std::filesystem::path input;
+        std::filesystem::path output;
+        std::string format = "auto";
+        bool mips = true;
+        bool flip = true;
+    };
+
+    void PrintUsage() {
+        std::cerr << "usage: TextureCompressor <input image> <output.dds|output.ktx2> [--format auto|bc1|bc3|bc7] [--no-mips] [--no-flip]\n";
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options) {
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--format" && i + 1 < argc) {
+                options.format = argv[++i];
+            }
+            else if (arg == "--no-mips") {
+                options.mips = false;
+            }
+            else if (arg == "--no-flip") {
+                options.flip = false;
+            }
+            else if (arg.rfind("--", 0) == 0) {
+                std::cerr << "Unknown option: " << arg << "\n";
+                return false;
+            }
+            else {
+                positional.push_back(arg);
+            }
+        }
+
+        if (positional.size() != 2) return false;
+        options.input = positional[0];
+        options.output = positional[1];
+        return true;
+    }
+
+    // BC1 for opaque art, BC7 when there is any alpha
+    almond::CompressedFormat PickFormat(const std::string& name, const almond::ImageLoader::ImageData& image) {
+        if (name == "bc1") return almond::CompressedFormat::BC1;
+        if (name == "bc3") return almond::CompressedFormat::BC3;
+        if (name == "bc7") return almond::CompressedFormat::BC7;
+        if (name != "auto") {
+            throw std::runtime_error("Unknown format: " + name);
+        }
+
+        for (size_t i = 3; i < image.pixels.size(); i += 4) {
+            if (image.pixels[i] != 255) return almond::CompressedFormat::BC7;
+        }
+        return almond::CompressedFormat::BC1;
+    }
+
+    // 2x2 box filter; odd edges reuse the last row / column
+    almond::ImageLoader::ImageData Downsample(const almond::ImageLoader::ImageData& source) {
+        almond::ImageLoader::ImageData next;
+        next.width = std::max(1, source.width / 2);
+        next.height = std::max(1, source.height / 2);
+        next.channels = 4;
+        next.pixels.resize(static_cast<size_t>(next.width) * next.height * 4);
+
+        for (int y = 0; y < next.height; ++y) {
+            const int y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+            for (int x = 0; x < next.width; ++x) {
+                const int x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                for (int c = 0; c < 4; ++c) {
+                    auto at = [&](int sx, int sy) { return source.pixels[(static_cast<size_t>(sy) * source.width + sx) * 4 + c]; };
+                    const int sum = at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1);
+                    next.pixels[(static_cast<size_t>(y) * next.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+        return next;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        auto image = almond::ImageLoader::LoadAlmondImage(options.input);
+        if (image.channels != 4) {
+            throw std::runtime_error("Expected RGBA pixels from the image loader.");
+        }
+        if (options.flip) {
+            almond::pixel::FlipVertically(image.pixels.data(), image.width, image.height, image.channels);
+        }
+
+        const auto format = PickFormat(options.format, image);
+        almond::CompressedImage compressed(format, image.width, image.height);
+
+        size_t totalBytes = 0;
+        while (true) {
+            auto blocks = almond::bc::CompressLevel(format, image.pixels.data(), image.width, image.height);
+            compressed.AddLevel(image.width, image.height, blocks.data(), blocks.size());
+            totalBytes += blocks.size();
+
+            if (!options.mips || (image.width == 1 && image.height == 1)) break;
+            image = Downsample(image);
+        }
+
+        compressed.Save(options.output);
+        std::cout << "Wrote " << compressed.GetLevels().size() << " level(s), " << totalBytes << " bytes: " << options.output << "\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << "TextureCompressor failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}